@@ -10,6 +10,9 @@
 /******************************************************************************
 * Dependencies
 ******************************************************************************/
+#include <array>
+#include <cstdint>
+#include <string_view>
 #include <vector>
 
 /******************************************************************************
@@ -31,34 +34,70 @@ enum {FLIP_NONE, FLIP_FLIP};
 ******************************************************************************/
 int binom(int n, int k);
 
+/******************************************************************************
+* The normal coordinates of a cube, all of which fit in 16 bits, as
+* calculated together by Cube::coords. The meta coordinates follow from these
+* through the *_calc functions, other than the flipslice coordinate, which
+* does not fit.
+******************************************************************************/
+struct CubeCoords
+{
+    uint16_t corner_orientation;
+    uint16_t edge_orientation;
+    uint16_t corner_permutation;
+    uint16_t ud_sorted;
+    uint16_t rl_sorted;
+    uint16_t fb_sorted;
+};
+
 /******************************************************************************
 * Cube class declarations
 ******************************************************************************/
 class Cube
 {
 private:
-    std::vector<int> corner_permutation;
-    std::vector<int> corner_orientation;
-    std::vector<int> edge_permutation;
-    std::vector<int> edge_orientation;
-    int coord_slice_sorted(std::vector<int> edges);
+    std::array<uint8_t, 8>  corner_permutation;
+    std::array<uint8_t, 8>  corner_orientation;
+    std::array<uint8_t, 12> edge_permutation;
+    std::array<uint8_t, 12> edge_orientation;
+    int coord_slice_sorted(int slice_mask) const;
+    void set_slice_sorted(int slice_mask, int coord);
 public:
     Cube();
     Cube(std::vector<int> corner_perm, std::vector<int> corner_orient,
          std::vector<int> edge_perm,   std::vector<int> edge_orient);
-    Cube perform_move(int move);
-    int coord_corner_orientation();
-    int coord_edge_orientation();
-    int coord_corner_permutation();
-    int coord_ud_sorted();
-    int coord_rl_sorted();
-    int coord_fb_sorted();
+    static bool from_facelets(std::string_view facelets, Cube& cube);
+    static bool from_moves(std::string_view moves, Cube& cube);
+    bool is_valid() const;
+    Cube perform_move(int move) const;
+    void apply_move(int move);
+    Cube multiply(const Cube& other) const;
+    Cube inverse() const;
+    bool operator==(const Cube& other) const;
+    void set_corner_orientation(int coord);
+    void set_edge_orientation(int coord);
+    void set_ud_unsorted(int coord);
+    void set_flipslice(int coord);
+    void set_corner_permutation(int coord);
+    void set_ud_sorted(int coord);
+    void set_rl_sorted(int coord);
+    void set_fb_sorted(int coord);
+    void set_edge_permutation(int coord);
+    void set_ud_permutation(int coord);
+    int coord_corner_orientation() const;
+    int coord_edge_orientation() const;
+    int coord_corner_permutation() const;
+    int coord_ud_sorted() const;
+    int coord_rl_sorted() const;
+    int coord_fb_sorted() const;
     static int edge_permutation_calc(int rl_sorted, int fb_sorted);
     static int ud_unsorted_calc(int ud_sorted);
     static int ud_permutation_calc(int ud_sorted);
-    int coord_edge_permutation();
-    int coord_ud_unsorted();
-    int coord_ud_permutation();
+    int coord_edge_permutation() const;
+    int coord_ud_unsorted() const;
+    int coord_ud_permutation() const;
+    int coord_flipslice() const;
+    CubeCoords coords() const;
 };
 
 #endif
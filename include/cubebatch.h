@@ -0,0 +1,44 @@
+#ifndef CUBEBATCH_INCLUDED
+#define CUBEBATCH_INCLUDED
+
+/******************************************************************************
+* Header:  cubebatch.h
+*
+* Purpose: Declarations for the batched pruning kernels, which look up the
+*          pruning values of all the children of a search node at once.
+******************************************************************************/
+
+/******************************************************************************
+* Dependencies
+******************************************************************************/
+#include <cstdint>
+
+#include <cubetables.h>
+
+/******************************************************************************
+* The available kernels. BATCH_SCALAR works everywhere; the others need the
+* matching instruction set, which is checked at run time.
+******************************************************************************/
+enum CubeBatchKernel {BATCH_SCALAR, BATCH_AVX2, NUM_BATCH_KERNELS};
+
+/******************************************************************************
+* A phase 1 survivors function. Given the phase 1 coordinates of a node, it
+* returns a mask with bit m set if, after move m, the pairwise pruning tables
+* still allow phase 1 to be finished in depth more moves. Bits are computed
+* for every move, so the caller must only use those it may make.
+******************************************************************************/
+typedef uint32_t (*CubeP1Survivors)(const SolverTables& tables, int co,
+                                    int eo, int ud_pos, int depth);
+
+/******************************************************************************
+* Kernel selection. The fastest supported kernel is chosen on first use, and
+* cube_set_batch_kernel may pick another, such as the scalar one for
+* comparison. Searches already running keep the kernel they started with.
+******************************************************************************/
+bool cube_batch_supported(CubeBatchKernel kernel);
+bool cube_set_batch_kernel(CubeBatchKernel kernel);
+CubeBatchKernel cube_batch_kernel();
+const char* cube_batch_kernel_name(CubeBatchKernel kernel);
+CubeP1Survivors cube_p1_survivors();
+
+#endif
@@ -0,0 +1,110 @@
+#ifndef CUBECACHE_INCLUDED
+#define CUBECACHE_INCLUDED
+
+/******************************************************************************
+* Header:  cubecache.h
+*
+* Purpose: Declarations for the on-disk table cache, which allows transition
+*          and pruning tables to be generated once, written to a binary file,
+*          and subsequently mapped into memory rather than regenerated.
+******************************************************************************/
+
+/******************************************************************************
+* Dependencies
+******************************************************************************/
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <cubemem.h>
+
+/******************************************************************************
+* Constants
+******************************************************************************/
+#define CUBE_TABLE_MAGIC    "CUBETBL"
+#define CUBE_TABLE_VERSION  3
+#define CUBE_TABLE_ALIGN    4096
+
+enum {SECTION_TRANS, SECTION_PRUNE, SECTION_SYM_CLASS, SECTION_SYM_INDEX,
+      SECTION_SYM_CONJ, SECTION_SYM_REP, SECTION_SYM_STAB, SECTION_SYM_TRANS};
+
+/******************************************************************************
+* On-disk layout. The file starts with a CubeTableHeader, followed by an array
+* of CubeTableSection descriptors, followed by the table data itself. Each
+* table starts on a CUBE_TABLE_ALIGN boundary so it can be used in place.
+******************************************************************************/
+struct CubeTableHeader
+{
+    char     magic[8];
+    uint32_t version;
+    uint32_t num_moves;
+    uint32_t p1_moves;
+    uint32_t p2_moves;
+    uint32_t num_sections;
+    uint32_t reserved;
+    uint64_t payload_bytes;
+    uint64_t checksum;
+};
+
+struct CubeTableSection
+{
+    uint32_t type;
+    uint32_t rows;
+    uint32_t cols;
+    uint32_t solved_pos;
+    uint64_t offset;
+    uint64_t bytes;
+};
+
+/******************************************************************************
+* Helper functions
+******************************************************************************/
+uint64_t cube_checksum(const void* data, size_t bytes);
+
+/******************************************************************************
+* CubeTableWriter class declaration. Collects table sections in memory and
+* writes them out as a single file.
+******************************************************************************/
+class CubeTableWriter
+{
+private:
+    std::vector<CubeTableSection> sections;
+    std::vector<std::vector<char>> payloads;
+public:
+    void add_section(uint32_t type, uint32_t rows, uint32_t cols,
+                     uint32_t solved_pos, const void* data, size_t bytes);
+    bool write(const std::string& path, uint32_t p1_moves, uint32_t p2_moves);
+};
+
+/******************************************************************************
+* CubeTableFile class declaration. A read-only memory mapping of a table file
+* whose header and checksum have been validated. A file opened with a
+* placement is instead read into memory placed as asked, so that the tables
+* can sit on huge pages or on a given NUMA node.
+******************************************************************************/
+class CubeTableFile
+{
+private:
+    void*  mapping;
+    size_t mapping_bytes;
+    bool   mapping_copied;
+    CubePages mapping_pages;
+    const CubeTableHeader*  header;
+    const CubeTableSection* sections;
+
+    bool read_placed(int fd, const CubePlacement& placement);
+public:
+    CubeTableFile();
+    ~CubeTableFile();
+    CubeTableFile(const CubeTableFile&) = delete;
+    CubeTableFile& operator=(const CubeTableFile&) = delete;
+    bool open(const std::string& path, uint32_t p1_moves, uint32_t p2_moves,
+              const CubePlacement& placement = CubePlacement());
+    void close();
+    int num_sections() const;
+    const CubeTableSection& section(int index) const;
+    const void* section_data(int index) const;
+};
+
+#endif
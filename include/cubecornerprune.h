@@ -0,0 +1,100 @@
+#ifndef CUBECORNERPRUNE_INCLUDED
+#define CUBECORNERPRUNE_INCLUDED
+
+/******************************************************************************
+* Header:  cubecornerprune.h
+*
+* Purpose: Declaration of the CubeCornerPrune class, the pruning table over
+*          corner permutation and orientation used by the optimal solver,
+*          reduced by the symmetries which fix the UD axis.
+******************************************************************************/
+
+/******************************************************************************
+* Dependencies
+******************************************************************************/
+#include <cube.h>
+#include <cubephase.h>
+#include <cubesymprune.h>
+#include <cubesymtrans.h>
+#include <cubetrans.h>
+
+/******************************************************************************
+* Constants
+*
+* The corner permutation values fall into CORNER_NUM_CLASSES classes under
+* the NUM_SYMS_UD symmetries, each paired with every corner orientation.
+* Each task in a parallel fill scans CORNER_FILL_CHUNK classes.
+******************************************************************************/
+#define CORNER_NUM_PERMS   40320
+#define CORNER_NUM_TWISTS  2187
+#define CORNER_NUM_CLASSES 2768
+#define CORNER_FILL_CHUNK  16
+
+/******************************************************************************
+* CubeCornerPrune class declaration.
+*
+* Holds the exact number of moves, from all 18, needed to solve the corners
+* of every position, ignoring the edges. No position is more than 11 moves
+* from having its corners solved, so every distance fits in an entry. As in
+* CubePhase2Prune, only one corner permutation from each symmetry class is
+* stored, paired with every corner orientation, which takes about 3MB of
+* packed entries. A position is looked up by conjugating it so that its
+* corner permutation becomes the class representative, which transforms its
+* corner orientation along with it.
+******************************************************************************/
+class CubeCornerPrune : public CubeSymPrune
+{
+public:
+    CubeCornerPrune(const CubeSymTrans* cp_sym_table,
+                    const CubeSymConj* twist_conj_table,
+                    const CubeTrans* co_table);
+    int operator()(int cp, int co) const;
+};
+
+/******************************************************************************
+* Function:  CubeCornerPrune::CubeCornerPrune
+*
+* Purpose:   Constructor for the CubeCornerPrune class.
+*
+* Params:    cp_sym_table     - The sym coordinate table of the corner
+*                               permutation coordinate, covering all 18
+*                               moves.
+*            twist_conj_table - The conjugation table of the corner
+*                               orientation coordinate.
+*            co_table         - The transition table of the corner
+*                               orientation coordinate.
+*
+* Returns:   Nothing.
+*
+* Operation: Passes the tables, moves and dimensions on to CubeSymPrune.
+******************************************************************************/
+inline CubeCornerPrune::CubeCornerPrune(const CubeSymTrans* cp_sym_table,
+                                        const CubeSymConj* twist_conj_table,
+                                        const CubeTrans* co_table)
+    : CubeSymPrune(cp_sym_table, twist_conj_table, co_table,
+                   cube_p1_allowed_moves[NUM_MOVES], CORNER_NUM_CLASSES,
+                   CORNER_NUM_TWISTS, CORNER_FILL_CHUNK)
+{
+}
+
+/******************************************************************************
+* Function:  CubeCornerPrune::operator()
+*
+* Purpose:   Looks up the corner distance of a position.
+*
+* Params:    cp - The corner permutation coordinate of the position.
+*            co - The corner orientation coordinate of the position.
+*
+* Returns:   The number of moves needed to solve the corners.
+*
+* Operation: Finds the sym coordinate of the corner permutation, conjugates
+*            the corner orientation by the same symmetry, and reads the
+*            packed entry. Defined here so that it can be inlined into the
+*            search.
+******************************************************************************/
+inline int CubeCornerPrune::operator()(int cp, int co) const
+{
+    return lookup(sym_trans->sym_coord(cp), co);
+}
+
+#endif
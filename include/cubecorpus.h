@@ -0,0 +1,29 @@
+#ifndef CUBECORPUS_INCLUDED
+#define CUBECORPUS_INCLUDED
+
+/******************************************************************************
+* Header:  cubecorpus.h
+*
+* Purpose: Declarations for generating reproducible sets of random cubes, for
+*          benchmarking and profile training.
+******************************************************************************/
+
+/******************************************************************************
+* Dependencies
+******************************************************************************/
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <cube.h>
+
+/******************************************************************************
+* Random cube generation. Every cube is drawn uniformly from all solvable
+* states, using a generator whose whole state is the 64-bit value passed in,
+* so the same seed always yields the same cubes on every platform.
+******************************************************************************/
+uint64_t cube_random_next(uint64_t& state);
+Cube cube_random_state(uint64_t& state);
+std::vector<Cube> cube_scramble_corpus(uint64_t seed, size_t count);
+
+#endif
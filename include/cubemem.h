@@ -0,0 +1,62 @@
+#ifndef CUBEMEM_INCLUDED
+#define CUBEMEM_INCLUDED
+
+/******************************************************************************
+* Header:  cubemem.h
+*
+* Purpose: Declarations for placing table memory: on huge pages, to cut the
+*          TLB misses of random lookups into large tables, and on a chosen
+*          NUMA node, so that threads pinned to that node read local memory.
+******************************************************************************/
+
+/******************************************************************************
+* Dependencies
+******************************************************************************/
+#include <cstddef>
+#include <vector>
+
+/******************************************************************************
+* Constants
+*
+* The size of a huge page, to which huge page mappings are rounded and
+* aligned.
+******************************************************************************/
+#define CUBE_HUGE_PAGE (2UL * 1024 * 1024)
+
+/******************************************************************************
+* Where table memory is placed.
+*
+* pages - PAGES_NORMAL for ordinary pages. PAGES_TRANSPARENT asks the kernel
+*         to back the memory with transparent huge pages where it can.
+*         PAGES_HUGETLB takes pages from the reserved huge page pool, and
+*         falls back to transparent huge pages if the pool is too small.
+* node  - The NUMA node to place the memory on, or -1 for wherever the
+*         kernel chooses. The node is preferred rather than required, so
+*         memory still comes from elsewhere if the node runs out.
+******************************************************************************/
+enum CubePages {PAGES_NORMAL, PAGES_TRANSPARENT, PAGES_HUGETLB};
+
+struct CubePlacement
+{
+    CubePages pages = PAGES_NORMAL;
+    int node = -1;
+
+    bool is_default() const;
+};
+
+/******************************************************************************
+* Memory functions
+******************************************************************************/
+size_t cube_pages_size(size_t bytes, CubePages pages);
+void* cube_map_pages(size_t bytes, const CubePlacement& placement);
+void cube_unmap_pages(void* memory, size_t bytes, CubePages pages);
+
+/******************************************************************************
+* NUMA functions. On a machine without NUMA, or where the topology cannot be
+* read, there is a single node 0 holding every processor.
+******************************************************************************/
+int cube_numa_nodes();
+std::vector<int> cube_numa_cpus(int node);
+bool cube_pin_thread(int node);
+
+#endif
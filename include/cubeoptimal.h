@@ -0,0 +1,79 @@
+#ifndef CUBEOPTIMAL_INCLUDED
+#define CUBEOPTIMAL_INCLUDED
+
+/******************************************************************************
+* Header:  cubeoptimal.h
+*
+* Purpose: Declarations for the OptimalSolver class, which finds the shortest
+*          possible solution of a cube with a single-phase search.
+******************************************************************************/
+
+/******************************************************************************
+* Dependencies
+******************************************************************************/
+#include <atomic>
+#include <chrono>
+#include <mutex>
+
+#include <cube.h>
+#include <cubesolver.h>
+#include <cubetables.h>
+
+/******************************************************************************
+* Constants
+*
+* No position needs more than OPTIMAL_MAX_MOVES moves, so the search never
+* goes deeper. The phase-1 table is looked up along each of the
+* OPTIMAL_AXES axes of the cube.
+******************************************************************************/
+#define OPTIMAL_MAX_MOVES 20
+#define OPTIMAL_AXES      3
+
+/******************************************************************************
+* OptimalSolver class declaration
+*
+* Runs an IDA* search over all 18 moves, deepening one move at a time, so the
+* first solution found is as short as any solution can be. A node is pruned
+* when any of its lower bounds exceeds the moves left: the phase-1 distance
+* of the cube re-oriented onto each of its three axes, since solving the
+* cube also solves phase 1 about every axis, and the corner distance from
+* the corner table. The tables must have been built with the optimal option.
+*
+* solve takes the same options as CubeSolver::solve. node_limit and deadline
+* bound the search, and pool, with split_depth, spreads each iteration over
+* a thread pool. target_length and multi_axis are ignored, since the only
+* solution reported is an optimal one. If the budget runs out first, no
+* solution is returned, but lower_bound still tells how many moves the
+* position is known to need. Statistics are not gathered. As with
+* CubeSolver, separate instances may solve at once against the same tables.
+******************************************************************************/
+class OptimalSolver
+{
+private:
+    class Search;
+    friend class Search;
+
+    const SolverTables& tables;
+    Cube cube;
+
+    // State shared by every search taking part in one call to solve.
+    SolveOptions options;
+    SolveResult result;
+    std::chrono::steady_clock::time_point start_time;
+    std::atomic<bool> stopped;
+    std::atomic<long long> nodes;
+    std::mutex result_lock;
+
+    // No solution has fewer moves than this, as far as has been searched.
+    int proved_depth;
+
+    void record_sol(const int* solution, int length, long long local_nodes);
+    void add_nodes(long long count);
+    void parallel_search(Search& root, int depth);
+public:
+    OptimalSolver(const SolverTables& solver_tables, Cube scrambled_cube);
+    SolveResult solve(const SolveOptions& solve_options = SolveOptions());
+    int lower_bound() const;
+};
+
+#endif
@@ -5,13 +5,17 @@
 * Header:  cubephase.h
 *
 * Purpose: Declarations of constants which determine the moves allowed in each
-*          phase of the two-phase algorithm.
+*          phase of the two-phase algorithm. Everything here is computed at
+*          compile time from the faces of the cube and the axes they turn
+*          about.
 ******************************************************************************/
 
 /******************************************************************************
 * Dependencies
 ******************************************************************************/
-#include <vector>
+#include <cstdint>
+
+#include <cube.h>
 
 /******************************************************************************
 * Constants
@@ -20,16 +24,134 @@
 #define PHASE_2 2
 
 /******************************************************************************
-* Allowed moves constant declarations
+* A fixed-size list of moves, usable in a range-based for loop.
+******************************************************************************/
+struct CubeMoveList
+{
+    int count;
+    uint8_t moves[NUM_MOVES];
+
+    constexpr const uint8_t* begin() const { return moves; }
+    constexpr const uint8_t* end() const { return moves + count; }
+};
+
+/******************************************************************************
+* The lists of moves which may follow each move in a phase, indexed by the
+* previous move, or by NUM_MOVES at the start of a search.
 ******************************************************************************/
-extern std::vector<std::vector<int>> cube_p1_allowed_moves;
-extern std::vector<std::vector<int>> cube_p2_allowed_moves;
+struct CubeSuccessors
+{
+    CubeMoveList after[NUM_MOVES + 1];
+
+    constexpr const CubeMoveList& operator[](int last) const
+    {
+        return after[last];
+    }
+};
 
 /******************************************************************************
-* Functions which populate the above vectors with the actual allowed moves
+* Function:  cube_phase_moves
+*
+* Purpose:   Gives the set of moves which may be used in a phase.
+*
+* Params:    phase - PHASE_1 or PHASE_2.
+*
+* Returns:   A mask with bit m set for each move m which may be used.
+*
+* Operation: In phase 1, any move is allowed. In phase 2, only half turns of
+*            R, L, F, B are allowed, together with any turn of U or D.
 ******************************************************************************/
-void cube_create_p1_allowed_moves();
-void cube_create_p2_allowed_moves();
-void cube_create_allowed_moves();
+constexpr uint32_t cube_phase_moves(int phase)
+{
+    uint32_t mask = 0;
+    for (int move = 0; move < NUM_MOVES; ++move)
+    {
+        int face = move / 3;
+        if (phase == PHASE_1 || face == MOVE_U / 3 || face == MOVE_D / 3 ||
+            move % 3 == 1)
+        {
+            mask |= 1u << move;
+        }
+    }
+    return mask;
+}
+
+/******************************************************************************
+* Function:  cube_move_may_follow
+*
+* Purpose:   Decides whether one move may directly follow another.
+*
+* Params:    last - The previous move, or NUM_MOVES if there is none.
+*            next - The move being considered.
+*
+* Returns:   true if next may follow last.
+*
+* Operation: No face can be turned twice in a row, and, since RL = LR,
+*            FB = BF, UD = DU, turns of opposite faces are only searched in
+*            one order: R before L, F before B and U before D. So a turn of
+*            L, B or D may not be followed by a turn of the opposite face.
+******************************************************************************/
+constexpr bool cube_move_may_follow(int last, int next)
+{
+    if (last == NUM_MOVES)
+    {
+        return true;
+    }
+
+    // The axis about which each face turns, and whether the face comes
+    // second in the order in which opposite faces are searched.
+    constexpr int face_axis[6] = {0, 1, 2, 1, 2, 0};
+    constexpr bool face_second[6] = {false, true, false, false, true, true};
+
+    int last_face = last / 3;
+    int next_face = next / 3;
+    return last_face != next_face &&
+           !(face_axis[last_face] == face_axis[next_face] &&
+             face_second[last_face]);
+}
+
+/******************************************************************************
+* Function:  cube_make_successors
+*
+* Purpose:   Builds the lists of moves which may follow each move in a phase.
+*
+* Params:    phase - PHASE_1 or PHASE_2.
+*
+* Returns:   NUM_MOVES + 1 lists. Entry m holds, in increasing order, the
+*            moves of the phase which may follow move m; entry NUM_MOVES
+*            holds every move of the phase, for use at the start of a search.
+*
+* Operation: Checks every pair of moves against the rules above.
+******************************************************************************/
+constexpr CubeSuccessors cube_make_successors(int phase)
+{
+    CubeSuccessors successors = {};
+    uint32_t phase_moves = cube_phase_moves(phase);
+
+    for (int last = 0; last <= NUM_MOVES; ++last)
+    {
+        CubeMoveList& list = successors.after[last];
+        for (int next = 0; next < NUM_MOVES; ++next)
+        {
+            if (((phase_moves >> next) & 1) &&
+                cube_move_may_follow(last, next))
+            {
+                list.moves[list.count++] = next;
+            }
+        }
+    }
+    return successors;
+}
+
+/******************************************************************************
+* Allowed moves constants
+******************************************************************************/
+inline constexpr uint32_t cube_p1_moves = cube_phase_moves(PHASE_1);
+inline constexpr uint32_t cube_p2_moves = cube_phase_moves(PHASE_2);
+
+inline constexpr CubeSuccessors cube_p1_allowed_moves =
+                                           cube_make_successors(PHASE_1);
+inline constexpr CubeSuccessors cube_p2_allowed_moves =
+                                           cube_make_successors(PHASE_2);
 
 #endif
@@ -0,0 +1,103 @@
+#ifndef CUBEPHASE1PRUNE_INCLUDED
+#define CUBEPHASE1PRUNE_INCLUDED
+
+/******************************************************************************
+* Header:  cubephase1prune.h
+*
+* Purpose: Declaration of the CubePhase1Prune class, the full phase-1 pruning
+*          table over corner orientation, edge orientation and UD-slice
+*          position, reduced by the symmetries which fix the UD axis.
+******************************************************************************/
+
+/******************************************************************************
+* Dependencies
+******************************************************************************/
+#include <cube.h>
+#include <cubephase.h>
+#include <cubesymprune.h>
+#include <cubesymtrans.h>
+#include <cubetrans.h>
+
+/******************************************************************************
+* Constants
+*
+* A flipslice coordinate combines the UD-slice position and edge orientation
+* as ud_pos * P1_NUM_FLIP + eo. Its values fall into P1_NUM_CLASSES classes
+* under the NUM_SYMS_UD symmetries. Each task in a parallel fill scans
+* P1_FILL_CHUNK classes.
+******************************************************************************/
+#define P1_NUM_TWIST      2187
+#define P1_NUM_FLIP       2048
+#define P1_NUM_SLICE      495
+#define P1_NUM_FLIPSLICE  (P1_NUM_SLICE * P1_NUM_FLIP)
+#define P1_NUM_CLASSES    64430
+#define P1_FILL_CHUNK     32
+
+/******************************************************************************
+* CubePhase1Prune class declaration.
+*
+* Holds the exact phase-1 distance of every position. Positions related by a
+* symmetry fixing the UD axis are the same distance from phase-1 solved, so
+* only one flipslice coordinate from each class is stored, paired with every
+* corner orientation: about 70MB of packed entries rather than over a
+* gigabyte. A position is looked up by conjugating it so that its flipslice
+* coordinate becomes the representative of its class, which transforms its
+* corner orientation along with it.
+******************************************************************************/
+class CubePhase1Prune : public CubeSymPrune
+{
+public:
+    CubePhase1Prune(const CubeSymTrans* flipslice_table,
+                    const CubeSymConj* twist_conj_table,
+                    const CubeTrans* co_table);
+    int operator()(int co, int eo, int ud_pos) const;
+};
+
+/******************************************************************************
+* Function:  CubePhase1Prune::CubePhase1Prune
+*
+* Purpose:   Constructor for the CubePhase1Prune class.
+*
+* Params:    flipslice_table  - The sym coordinate table of the flipslice
+*                               coordinate.
+*            twist_conj_table - The conjugation table of the corner
+*                               orientation coordinate.
+*            co_table         - The transition table of the corner
+*                               orientation coordinate.
+*
+* Returns:   Nothing.
+*
+* Operation: Passes the tables, moves and dimensions on to CubeSymPrune.
+******************************************************************************/
+inline CubePhase1Prune::CubePhase1Prune(const CubeSymTrans* flipslice_table,
+                                        const CubeSymConj* twist_conj_table,
+                                        const CubeTrans* co_table)
+    : CubeSymPrune(flipslice_table, twist_conj_table, co_table,
+                   cube_p1_allowed_moves[NUM_MOVES], P1_NUM_CLASSES,
+                   P1_NUM_TWIST, P1_FILL_CHUNK)
+{
+}
+
+/******************************************************************************
+* Function:  CubePhase1Prune::operator()
+*
+* Purpose:   Looks up the phase-1 distance of a position.
+*
+* Params:    co     - The corner orientation coordinate of the position.
+*            eo     - The edge orientation coordinate of the position.
+*            ud_pos - The unsorted UD-slice coordinate of the position.
+*
+* Returns:   The number of moves needed to solve phase 1 from the position.
+*
+* Operation: Finds the sym coordinate of the flipslice coordinate, that is,
+*            its class and the symmetry taking it to the representative,
+*            conjugates the corner orientation by the same symmetry, and reads
+*            the packed entry. Defined here so that it can be inlined into the
+*            searches.
+******************************************************************************/
+inline int CubePhase1Prune::operator()(int co, int eo, int ud_pos) const
+{
+    return lookup(sym_trans->sym_coord(ud_pos * P1_NUM_FLIP + eo), co);
+}
+
+#endif
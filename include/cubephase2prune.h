@@ -0,0 +1,100 @@
+#ifndef CUBEPHASE2PRUNE_INCLUDED
+#define CUBEPHASE2PRUNE_INCLUDED
+
+/******************************************************************************
+* Header:  cubephase2prune.h
+*
+* Purpose: Declaration of the CubePhase2Prune class, the phase-2 pruning
+*          table over corner permutation and edge permutation, reduced by the
+*          symmetries which fix the UD axis.
+******************************************************************************/
+
+/******************************************************************************
+* Dependencies
+******************************************************************************/
+#include <cube.h>
+#include <cubephase.h>
+#include <cubesymprune.h>
+#include <cubesymtrans.h>
+#include <cubetrans.h>
+
+/******************************************************************************
+* Constants
+*
+* The corner permutation values fall into P2_NUM_CLASSES classes under the
+* NUM_SYMS_UD symmetries. The edge permutation is of the eight U and D layer
+* edges only. Each task in a parallel fill scans P2_FILL_CHUNK classes.
+******************************************************************************/
+#define P2_NUM_CORNERS  40320
+#define P2_NUM_EDGES    40320
+#define P2_NUM_CLASSES  2768
+#define P2_FILL_CHUNK   4
+
+/******************************************************************************
+* CubePhase2Prune class declaration.
+*
+* Holds the distance of every phase-2 position from having both its corners
+* and its U and D layer edges solved, ignoring the UD-slice edges. Unlike the
+* pairwise tables, this captures how the corner and edge permutations hold
+* each other back. As in CubePhase1Prune, only one corner permutation from
+* each symmetry class is stored, paired with every edge permutation, which
+* takes about 56MB of packed entries. A position is looked up by conjugating
+* it so that its corner permutation becomes the class representative, which
+* transforms its edge permutation along with it. Distances of 15 or more are
+* all stored as 15.
+******************************************************************************/
+class CubePhase2Prune : public CubeSymPrune
+{
+public:
+    CubePhase2Prune(const CubeSymTrans* cp_sym_table,
+                    const CubeSymConj* ep_conj_table,
+                    const CubeTrans* ep_table);
+    int operator()(int cp, int ep) const;
+};
+
+/******************************************************************************
+* Function:  CubePhase2Prune::CubePhase2Prune
+*
+* Purpose:   Constructor for the CubePhase2Prune class.
+*
+* Params:    cp_sym_table  - The sym coordinate table of the corner
+*                            permutation coordinate.
+*            ep_conj_table - The conjugation table of the edge permutation
+*                            coordinate.
+*            ep_table      - The transition table of the edge permutation
+*                            coordinate.
+*
+* Returns:   Nothing.
+*
+* Operation: Passes the tables, moves and dimensions on to CubeSymPrune.
+******************************************************************************/
+inline CubePhase2Prune::CubePhase2Prune(const CubeSymTrans* cp_sym_table,
+                                        const CubeSymConj* ep_conj_table,
+                                        const CubeTrans* ep_table)
+    : CubeSymPrune(cp_sym_table, ep_conj_table, ep_table,
+                   cube_p2_allowed_moves[NUM_MOVES], P2_NUM_CLASSES,
+                   P2_NUM_EDGES, P2_FILL_CHUNK)
+{
+}
+
+/******************************************************************************
+* Function:  CubePhase2Prune::operator()
+*
+* Purpose:   Looks up the corner and edge permutation distance of a position.
+*
+* Params:    cp - The corner permutation coordinate of the position.
+*            ep - The edge permutation coordinate of the position.
+*
+* Returns:   A lower bound on the number of moves needed to solve phase 2
+*            from the position.
+*
+* Operation: Finds the sym coordinate of the corner permutation, conjugates
+*            the edge permutation by the same symmetry, and reads the packed
+*            entry. Defined here so that it can be inlined into the search.
+******************************************************************************/
+inline int CubePhase2Prune::operator()(int cp, int ep) const
+{
+    return lookup(sym_trans->sym_coord(cp), ep);
+}
+
+#endif
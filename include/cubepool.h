@@ -0,0 +1,95 @@
+#ifndef CUBEPOOL_INCLUDED
+#define CUBEPOOL_INCLUDED
+
+/******************************************************************************
+* Header:  cubepool.h
+*
+* Purpose: Declarations for a work-stealing thread pool, used to spread
+*          searches over several cores.
+******************************************************************************/
+
+/******************************************************************************
+* Dependencies
+******************************************************************************/
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/******************************************************************************
+* CubeThreadPool class declaration.
+*
+* Each worker thread has its own deque of tasks. A worker takes tasks from the
+* back of its own deque, and when that is empty steals from the front of
+* another worker's deque, so that large subtrees queued early are the ones
+* which get stolen. A pool may be tied to a NUMA node, in which case its
+* workers only run on the node's processors.
+******************************************************************************/
+class CubeThreadPool
+{
+private:
+    struct Worker
+    {
+        std::mutex lock;
+        std::deque<std::function<void()>> tasks;
+    };
+
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::vector<std::thread> threads;
+    std::atomic<long> queued;
+    std::atomic<unsigned> next_worker;
+    std::mutex sleep_lock;
+    std::condition_variable wake;
+    bool shutdown;
+    int node;
+
+    bool pop(int index, std::function<void()>& task);
+    bool steal(int index, std::function<void()>& task);
+    void worker_main(int index);
+public:
+    explicit CubeThreadPool(int num_threads = 0, int numa_node = -1);
+    ~CubeThreadPool();
+    CubeThreadPool(const CubeThreadPool&) = delete;
+    CubeThreadPool& operator=(const CubeThreadPool&) = delete;
+    int size() const;
+    void submit(std::function<void()> task);
+    bool run_one();
+};
+
+/******************************************************************************
+* CubeTaskGroup class declaration.
+*
+* Tracks a set of tasks submitted to a pool so that the caller can wait for
+* all of them. A thread waiting on a group runs queued tasks itself rather
+* than sitting idle, so groups may safely be waited on from inside a task.
+******************************************************************************/
+class CubeTaskGroup
+{
+private:
+    CubeThreadPool& pool;
+    std::atomic<int> pending;
+    std::mutex done_lock;
+    std::condition_variable done;
+public:
+    explicit CubeTaskGroup(CubeThreadPool& thread_pool);
+    ~CubeTaskGroup();
+    CubeTaskGroup(const CubeTaskGroup&) = delete;
+    CubeTaskGroup& operator=(const CubeTaskGroup&) = delete;
+    void run(std::function<void()> task);
+    void wait();
+};
+
+/******************************************************************************
+* Data-parallel loops. Splits the range [0, count) into chunks of the given
+* size and calls body(begin, end) once per chunk, spread over the pool, then
+* waits for them all. Runs the whole range on the calling thread if there is
+* no pool or it has only one thread.
+******************************************************************************/
+void cube_parallel_for(CubeThreadPool* pool, long count, long chunk,
+                       const std::function<void(long begin, long end)>& body);
+
+#endif
@@ -10,10 +10,103 @@
 /******************************************************************************
 * Dependencies
 ******************************************************************************/
-#include <vector>
+#include <atomic>
+#include <cstdint>
+#include <memory>
 
+#include <cubecache.h>
+#include <cubemem.h>
+#include <cubepool.h>
 #include <cubetrans.h>
 
+/******************************************************************************
+* Constants
+******************************************************************************/
+#define PRUNE_UNVISITED 0xF
+
+/******************************************************************************
+* CubeNibbleTable class declaration.
+*
+* The storage of a pruning table while it is being filled, holding two 4-bit
+* entries per byte, all initially PRUNE_UNVISITED. Entries may be read and
+* claimed from many threads at once. Once filling has finished, data() gives
+* the packed bytes in the layout which the lookups and table files use. The
+* storage is padded to a whole number of 32-bit words, so that vector code
+* may read the aligned word holding any entry, and is mapped directly rather
+* than allocated, so that it can be placed on huge pages or a NUMA node.
+******************************************************************************/
+class CubeNibbleTable
+{
+private:
+    std::atomic<uint8_t>* bytes = nullptr;
+    long num_bytes = 0;
+    size_t mapped_bytes = 0;
+    CubePages pages = PAGES_NORMAL;
+public:
+    CubeNibbleTable() = default;
+    ~CubeNibbleTable();
+    CubeNibbleTable(const CubeNibbleTable&) = delete;
+    CubeNibbleTable& operator=(const CubeNibbleTable&) = delete;
+    void assign(long entries,
+                const CubePlacement& placement = CubePlacement());
+    void clear();
+    long size() const;
+    const uint8_t* data() const;
+    int get(long index) const;
+    bool claim(long index, int value);
+};
+
+/******************************************************************************
+* Function:  CubeNibbleTable::get
+*
+* Purpose:   Reads an entry.
+*
+* Params:    index - The index of the entry.
+*
+* Returns:   The value of the entry.
+*
+* Operation: A relaxed load, since every entry changes only once, from
+*            PRUNE_UNVISITED to its final value.
+******************************************************************************/
+inline int CubeNibbleTable::get(long index) const
+{
+    return (bytes[index >> 1].load(std::memory_order_relaxed) >>
+            ((index & 1) << 2)) & 0xF;
+}
+
+/******************************************************************************
+* Function:  CubeNibbleTable::claim
+*
+* Purpose:   Sets an unvisited entry.
+*
+* Params:    index - The index of the entry.
+*            value - The value to store, which must fit in 4 bits. Claims
+*                    which may run at the same time must all use the same
+*                    value, as they do within one level of a search.
+*
+* Returns:   true if the entry was unvisited, and so has now been set.
+*
+* Operation: Entries which are already set are left alone. Otherwise, since
+*            PRUNE_UNVISITED has every bit set, clearing the bits which are
+*            not set in value turns it into value without disturbing the
+*            other entry in the byte. This is a single atomic AND, so if
+*            several threads claim the same entry, exactly one of them sees
+*            it unvisited.
+******************************************************************************/
+inline bool CubeNibbleTable::claim(long index, int value)
+{
+    if (get(index) != PRUNE_UNVISITED)
+    {
+        return false;
+    }
+
+    int shift = (index & 1) << 2;
+    uint8_t old = bytes[index >> 1].fetch_and(
+                      (uint8_t)~((PRUNE_UNVISITED ^ value) << shift),
+                      std::memory_order_relaxed);
+    return ((old >> shift) & 0xF) == PRUNE_UNVISITED;
+}
+
 /******************************************************************************
 * CubePrune class declaration.
 ******************************************************************************/
@@ -21,15 +114,77 @@ class CubePrune
 {
 private:
     int phase;
-    std::vector<int> allowed_moves;
-    CubeTrans* transition_table_1;
-    CubeTrans* transition_table_2;
-    std::vector<std::vector<int>> table;
+    const CubeTrans* transition_table_1;
+    const CubeTrans* transition_table_2;
+    int size_1, size_2;
+    CubeNibbleTable storage;
+    const uint8_t* table;
 public:
-    CubePrune(int phase_desc,
-              CubeTrans* trans_table_1, CubeTrans* trans_table_2);
-    int operator()(int coord_value_1, int coord_value_2);
-    void fill();
+    CubePrune(int phase_desc, const CubeTrans* trans_table_1,
+                              const CubeTrans* trans_table_2);
+    int operator()(int coord_value_1, int coord_value_2) const;
+    const uint8_t* data() const;
+    int columns() const;
+    void fill(CubeThreadPool* pool = nullptr,
+              const CubePlacement& placement = CubePlacement());
+    void save(CubeTableWriter& writer) const;
+    bool matches(const CubeTableFile& file, int index) const;
+    void load(const CubeTableFile& file, int index);
 };
 
+/******************************************************************************
+* Function:  CubePrune::operator()
+*
+* Purpose:   Returns an entry in the pruning table.
+*
+* Params:    coord_value_1 - The coordinate values of the position to look up.
+*            coord_value_2
+*
+* Returns:   The value stored in the table for that combination of coordinates.
+*
+* Operation: Entries are stored two to a byte, at the flat index
+*            coord_value_1 * size_2 + coord_value_2, with the even entry in the
+*            low nibble. Defined here so that it can be inlined into the
+*            searches.
+******************************************************************************/
+inline int CubePrune::operator()(int coord_value_1, int coord_value_2) const
+{
+    int index = coord_value_1 * size_2 + coord_value_2;
+    return (table[index >> 1] >> ((index & 1) << 2)) & 0xF;
+}
+
+/******************************************************************************
+* Function:  CubePrune::data
+*
+* Purpose:   Gives the packed entries, for lookups done outside this class.
+*
+* Params:    None.
+*
+* Returns:   The entries, laid out as described for operator(). The aligned
+*            32-bit word holding any entry may be read, since both filled
+*            tables and table file sections are padded.
+*
+* Operation: Simply return the pointer.
+******************************************************************************/
+inline const uint8_t* CubePrune::data() const
+{
+    return table;
+}
+
+/******************************************************************************
+* Function:  CubePrune::columns
+*
+* Purpose:   Gives the number of entries per value of the first coordinate.
+*
+* Params:    None.
+*
+* Returns:   The range of the second coordinate.
+*
+* Operation: Simply return the value.
+******************************************************************************/
+inline int CubePrune::columns() const
+{
+    return size_2;
+}
+
 #endif
@@ -0,0 +1,106 @@
+#ifndef CUBEREGISTRY_INCLUDED
+#define CUBEREGISTRY_INCLUDED
+
+/******************************************************************************
+* Header:  cuberegistry.h
+*
+* Purpose: Declaration of the CubeTableRegistry class, which makes the solver
+*          tables ready on demand, one table at a time, instead of all of
+*          them before the first solve.
+******************************************************************************/
+
+/******************************************************************************
+* Dependencies
+******************************************************************************/
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include <cubepool.h>
+#include <cubetables.h>
+
+/******************************************************************************
+* Constants
+*
+* Sets of tables, as masks of SolverTableId bits, naming what each kind of
+* query reads. Tables which the options do not enable are left out of any
+* set they appear in.
+*
+* TABLES_PHASE1  - A phase 1 query such as cube_solve_phase1.
+* TABLES_SOLVER  - CubeSolver, and everything built on it.
+* TABLES_OPTIMAL - OptimalSolver.
+* TABLES_ALL     - Every table.
+******************************************************************************/
+#define TABLE_BIT(table) (1u << (table))
+
+#define TABLES_PHASE1  (TABLE_BIT(TABLE_CO_TRANS) |                          \
+                        TABLE_BIT(TABLE_EO_TRANS) |                          \
+                        TABLE_BIT(TABLE_UD_UNSORTED_TRANS) |                 \
+                        TABLE_BIT(TABLE_CO_EO_PRUNE) |                       \
+                        TABLE_BIT(TABLE_CO_UD_PRUNE) |                       \
+                        TABLE_BIT(TABLE_EO_UD_PRUNE) |                       \
+                        TABLE_BIT(TABLE_PHASE1))
+#define TABLES_SOLVER  (TABLES_ALL & ~TABLE_BIT(TABLE_CORNER))
+#define TABLES_OPTIMAL (TABLE_BIT(TABLE_CO_TRANS) |                          \
+                        TABLE_BIT(TABLE_EO_TRANS) |                          \
+                        TABLE_BIT(TABLE_CP_TRANS) |                          \
+                        TABLE_BIT(TABLE_UD_UNSORTED_TRANS) |                 \
+                        TABLE_BIT(TABLE_PHASE1) |                            \
+                        TABLE_BIT(TABLE_CORNER))
+#define TABLES_ALL     (TABLE_BIT(NUM_SOLVER_TABLES) - 1)
+
+/******************************************************************************
+* CubeTableRegistry class declaration.
+*
+* Owns a SolverTables object and makes each table ready the first time it is
+* asked for. The first request tries the table file; if it loads, every table
+* is ready at once. Otherwise each table is generated when it is first
+* needed, after the tables it is built from, and never twice, however many
+* threads ask for it at once; threads asking for tables which are already
+* ready do not wait at all. Once every table has been generated, the file is
+* written for next time.
+*
+* warm_up starts a background thread which makes every table ready in turn,
+* phase 1 first, so that a server can take requests straight away: a query
+* only waits for the tables it reads, and those are often ready by the time
+* it arrives. A solver must only be given the tables once require has
+* returned for everything it reads, and the registry must outlive it. The
+* destructor waits for the warm-up thread to finish.
+******************************************************************************/
+class CubeTableRegistry
+{
+private:
+    std::string path;
+    SolverTables tables;
+    std::unique_ptr<CubeThreadPool> pool;
+
+    // Whether the file has been tried, and whether it loaded.
+    std::once_flag load_once;
+    bool loaded;
+
+    // Each table is made ready under its own flag. ready_mask has a bit set
+    // for each table which is ready, and remaining counts the enabled tables
+    // still to be generated.
+    std::once_flag table_once[NUM_SOLVER_TABLES];
+    std::atomic<uint32_t> ready_mask;
+    std::atomic<int> remaining;
+
+    std::thread warm_thread;
+
+    void load();
+    void make_ready(SolverTableId table);
+public:
+    CubeTableRegistry(const std::string& table_path,
+                      const TableOptions& table_options = TableOptions());
+    ~CubeTableRegistry();
+    CubeTableRegistry(const CubeTableRegistry&) = delete;
+    CubeTableRegistry& operator=(const CubeTableRegistry&) = delete;
+    const SolverTables& require(uint32_t needs);
+    bool is_ready(uint32_t needs) const;
+    void warm_up();
+};
+
+#endif
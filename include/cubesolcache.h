@@ -0,0 +1,130 @@
+#ifndef CUBESOLCACHE_INCLUDED
+#define CUBESOLCACHE_INCLUDED
+
+/******************************************************************************
+* Header:  cubesolcache.h
+*
+* Purpose: Declarations for the solution cache, which remembers the best
+*          solution found for each position so that repeated and symmetric
+*          positions need not be searched again.
+******************************************************************************/
+
+/******************************************************************************
+* Dependencies
+******************************************************************************/
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include <cube.h>
+#include <cubesolver.h>
+#include <cubetables.h>
+
+/******************************************************************************
+* Constants
+*
+* The default number of shards a cache is split into, each with its own lock,
+* and the longest solution an entry can hold.
+******************************************************************************/
+#define SOLCACHE_SHARDS    16
+#define SOLCACHE_MAX_MOVES 32
+
+/******************************************************************************
+* The canonical form of a position: the least, by exact encoding, of the
+* positions reached by conjugating the cube and its inverse by each of the
+* NUM_SYMS symmetries. Symmetric positions, and a position and its inverse,
+* all share one canonical form, and a solution of any of them is turned into
+* a solution of another by conjugating its moves, then reversing and undoing
+* them if one is the inverse of the other.
+*
+* state   - The exact encoding of the canonical position, packed from its
+*           coordinates into two words.
+* key     - A 64-bit hash of state, by which the cache finds the position.
+* sym     - The symmetry which conjugates the cube, or its inverse, onto the
+*           canonical position.
+* inverse - Whether it was the inverse which was conjugated.
+******************************************************************************/
+struct CubeCanonical
+{
+    uint64_t state[2];
+    uint64_t key;
+    int sym;
+    bool inverse;
+};
+
+CubeCanonical cube_canonical(const Cube& cube);
+std::vector<int> cube_to_canonical(const CubeCanonical& canonical,
+                                   const std::vector<int>& moves);
+std::vector<int> cube_from_canonical(const CubeCanonical& canonical,
+                                     const std::vector<int>& moves);
+
+/******************************************************************************
+* A solution held by the cache, given for the position which was looked up.
+*
+* moves - The best solution stored for the position.
+* bound - No solution has fewer moves than this, as far as has been proved.
+*         When it equals the number of moves, the solution is optimal.
+******************************************************************************/
+struct CubeCachedSolution
+{
+    std::vector<int> moves;
+    int bound = 0;
+};
+
+/******************************************************************************
+* CubeSolutionCache class declaration
+*
+* A bounded cache of solutions keyed by canonical form, safe to use from many
+* threads at once. Positions are spread over shards by key, and each shard
+* keeps its entries in least recently used order, evicting the oldest once it
+* is full. The canonical form is worked out before any lock is taken, so each
+* shard is only locked for a hash lookup and a few bytes of copying. An entry
+* is only used if its full state matches, so keys which collide are simply
+* treated as different positions.
+******************************************************************************/
+class CubeSolutionCache
+{
+private:
+    struct Entry
+    {
+        uint64_t state[2];
+        uint8_t moves[SOLCACHE_MAX_MOVES];
+        uint8_t length;
+        uint8_t bound;
+    };
+
+    struct Shard
+    {
+        std::mutex lock;
+        std::list<Entry> entries;
+        std::unordered_map<uint64_t, std::list<Entry>::iterator> index;
+    };
+
+    std::unique_ptr<Shard[]> shards;
+    int num_shards;
+    size_t shard_capacity;
+    std::atomic<long long> hit_count;
+    std::atomic<long long> miss_count;
+
+    Shard& shard_for(uint64_t key);
+public:
+    CubeSolutionCache(size_t capacity, int shard_count = SOLCACHE_SHARDS);
+    bool lookup(const Cube& cube, CubeCachedSolution& solution);
+    bool lookup(const CubeCanonical& canonical, CubeCachedSolution& solution);
+    bool store(const Cube& cube, const std::vector<int>& moves, int bound);
+    bool store(const CubeCanonical& canonical, const std::vector<int>& moves,
+               int bound);
+    SolveResult solve(const SolverTables& tables, const Cube& cube,
+                      const SolveOptions& options = SolveOptions());
+    void clear();
+    size_t size();
+    long long hits() const;
+    long long misses() const;
+};
+
+#endif
@@ -10,31 +10,252 @@
 /******************************************************************************
 * Dependencies
 ******************************************************************************/
+#include <atomic>
+#include <chrono>
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
 #include <vector>
 
 #include <cube.h>
+#include <cubepool.h>
+#include <cubetables.h>
+
+/******************************************************************************
+* Constants
+*
+* The number of searches run by a multi-axis solve: the cube as given, and
+* re-oriented so that RL and then FB become the phase 1 axis, each searched
+* both as it is and inverted.
+******************************************************************************/
+#define SOLVE_ORIENTATIONS 6
+
+/******************************************************************************
+* Search statistics, only gathered when the library is built with CUBE_STATS
+* defined (the CUBE_STATS CMake option). Otherwise the fields stay zero and
+* counting costs nothing, since the code doing it is compiled out.
+*
+* enabled           - Whether the library was built to gather statistics.
+* phase1_nodes      - Phase 1 nodes expanded, by number of moves from the root.
+* phase2_nodes      - Phase 2 nodes expanded, by number of phase 2 moves made.
+* prunes            - Nodes cut off, by the pruning table that cut them off.
+*                     Where several tables would, the first in the order of
+*                     SolvePruneTable is credited.
+* phase1_leaves     - Positions reached which solve phase 1.
+* phase2_searches   - Phase 2 searches started from those positions. Leaves
+*                     whose last move is also a phase 2 move are skipped, since
+*                     the solutions through them are found from a shorter
+*                     phase 1.
+* iteration_seconds - Time spent on each phase 1 deepening iteration, by
+*                     depth. For a multi-axis solve this is the sum over the
+*                     orientations, which run concurrently.
+*
+* Depths beyond the end of the arrays are counted in the last entry.
+******************************************************************************/
+#define SOLVE_STATS_DEPTHS 32
+
+enum SolvePruneTable {PRUNE_CO_EO, PRUNE_CO_UD, PRUNE_EO_UD, PRUNE_PHASE1,
+                      PRUNE_PHASE2, PRUNE_CP_UD, PRUNE_EP_UD,
+                      NUM_PRUNE_TABLES};
+
+struct SolveStats
+{
+    bool enabled = false;
+    long long phase1_nodes[SOLVE_STATS_DEPTHS] = {};
+    long long phase2_nodes[SOLVE_STATS_DEPTHS] = {};
+    long long prunes[NUM_PRUNE_TABLES] = {};
+    long long phase1_leaves = 0;
+    long long phase2_searches = 0;
+    double iteration_seconds[SOLVE_STATS_DEPTHS] = {};
+
+    void add(const SolveStats& other);
+};
+
+/******************************************************************************
+* The outcome of a call to CubeSolver::solve, or of a session so far.
+*
+* moves        - The best solution found, empty if none was found.
+* length       - The number of moves in that solution, or -1 if none.
+* nodes        - The number of search nodes expanded.
+* improvements - One entry for each successively shorter solution found,
+*                recording its length and when it was found.
+* stats        - Where the search spent its effort; see SolveStats.
+******************************************************************************/
+struct SolveImprovement
+{
+    int length;
+    long long nodes;
+    double seconds;
+};
+
+struct SolveResult
+{
+    std::vector<int> moves;
+    int length = -1;
+    long long nodes = 0;
+    std::vector<SolveImprovement> improvements;
+    SolveStats stats;
+};
+
+/******************************************************************************
+* Options controlling when CubeSolver::solve stops searching. By default it
+* runs until it has found the shortest two-phase solution. The same options
+* give the budget for each call to CubeSolver::improve, where node_limit
+* counts only the nodes expanded by that call.
+*
+* target_length - Stop at the first solution of at most this many moves.
+* node_limit    - Stop after expanding this many search nodes.
+* deadline      - Stop once this time has passed.
+* process_sol   - If set, called with the result so far each time a shorter
+*                 solution is found. Calls are never made concurrently.
+* pool          - If set, the phase 1 search is split into subtrees which are
+*                 searched in parallel on this pool.
+* split_depth   - How many moves deep the phase 1 tree is split when searching
+*                 in parallel.
+* multi_axis    - If set, runs SOLVE_ORIENTATIONS searches, one for each
+*                 phase 1 axis of the cube and of its inverse, sharing the
+*                 best length found so far. Each search is sequential and
+*                 runs as one task on pool, concurrently with the others. If
+*                 pool is not set they take turns on the calling thread, one
+*                 phase 1 depth at a time. Solutions are always given for
+*                 the cube as passed to the solver.
+******************************************************************************/
+struct SolveOptions
+{
+    int target_length = 0;
+    long long node_limit = LLONG_MAX;
+    std::chrono::steady_clock::time_point deadline =
+                                    std::chrono::steady_clock::time_point::max();
+    std::function<void(const SolveResult&)> process_sol;
+    CubeThreadPool* pool = nullptr;
+    int split_depth = 3;
+    bool multi_axis = false;
+};
+
+/******************************************************************************
+* Helper functions
+******************************************************************************/
+size_t cube_format_moves(const int* moves, size_t count, char* buffer);
+std::string cube_solution_string(const std::vector<int>& moves);
 
 /******************************************************************************
 * CubeSolver class declaration
+*
+* Each CubeSolver holds only its own search state and reads the shared tables
+* through a const reference, so separate instances may run solve concurrently
+* on separate threads against the same SolverTables. A single instance must
+* not be used from more than one thread at a time, other than through the
+* pool passed in SolveOptions.
+*
+* Instead of solving in one go, a solver can run a session: start it, call
+* improve as often as wanted, each time with a fresh budget, and read the
+* solution so far with best. Each call carries on the iterative deepening
+* from where the last one stopped, down to the node being searched, so no
+* work is repeated and each call can only add shorter solutions. A session
+* searches sequentially and in the cube's own orientation, so the pool and
+* multi_axis options are ignored. Its whole state can be saved in a few
+* hundred bytes and loaded into a solver for the same cube, perhaps in
+* another process, which then carries on as the first would have.
 ******************************************************************************/
 class CubeSolver
 {
 private:
-    int max_length;
-    std::vector<int> solution;
-    int last_move;
+    class Search;
+    friend class Search;
 
-    int curr_co, curr_eo, curr_ud_pos;
-    int curr_cp, curr_ep, curr_ud_perm;
-    int start_ud_sorted, start_rl_sorted, start_fb_sorted, start_cp;
+    const SolverTables& tables;
 
-    void phase1_search(int depth);
-    void phase2_search(int depth);
-    void print_sol();
+    // Starting values of the phase 1 and auxiliary coordinates, for the cube
+    // in each orientation that a multi-axis solve searches. The first is the
+    // cube as given. Every one of them fits in 16 bits.
+    struct Start
+    {
+        uint16_t co, eo, ud_pos;
+        uint16_t ud_sorted, rl_sorted, fb_sorted, cp;
+    };
+    Start starts[SOLVE_ORIENTATIONS];
+
+    // State shared by every search taking part in one call to solve.
+    // max_length is the length of the longest solution still worth finding,
+    // one less than the best found so far.
+    SolveOptions options;
+    SolveResult result;
+    std::chrono::steady_clock::time_point start_time;
+    std::atomic<int> max_length;
+    std::atomic<bool> stopped;
+    std::atomic<long long> nodes;
+    std::mutex result_lock;
+
+    // The running session, if any: its search, the depth of the phase 1
+    // iteration that search is in, and the time spent in improve so far.
+    std::unique_ptr<Search> session;
+    int session_depth;
+    double session_seconds;
+
+    // How many phase 1 iterations the last solve finished.
+    int solved_depth;
+
+    void record_sol(const int* solution, int length, int orientation,
+                    long long local_nodes);
+    void add_nodes(long long count);
+    bool solves(const std::vector<int>& moves) const;
+    void add_stats(const SolveStats& stats);
+    void add_iteration(int depth,
+                       std::chrono::steady_clock::time_point start);
+    void parallel_search(int depth);
+    void multi_axis_search();
 public:
-    CubeSolver();
-    CubeSolver(Cube cube);
-    void solve();
+    CubeSolver(const SolverTables& solver_tables);
+    CubeSolver(const SolverTables& solver_tables, Cube cube);
+    ~CubeSolver();
+    SolveResult solve(const SolveOptions& solve_options = SolveOptions());
+    void start();
+    SolveResult improve(const SolveOptions& budget);
+    const SolveResult& best() const;
+    bool exhausted() const;
+    int lower_bound() const;
+    std::vector<uint8_t> save_session() const;
+    bool load_session(const std::vector<uint8_t>& data);
 };
 
+/******************************************************************************
+* Phase 1 queries. cube_solve_phase1 gives a shortest sequence of moves
+* taking a cube into the phase 2 subgroup, sometimes called domino
+* reduction. It reads only the phase 1 tables, so it can run before the
+* phase 2 tables have been built; see CubeTableRegistry.
+******************************************************************************/
+std::vector<int> cube_solve_phase1(const SolverTables& tables,
+                                   const Cube& cube);
+
+/******************************************************************************
+* Batch solving. Each cube is solved with the given options, sequentially,
+* while the cubes themselves are spread over a thread pool sharing one set of
+* tables. Results are returned in input order, and on_complete, if set, is
+* called as each cube finishes, in completion order but never concurrently.
+* Given replicas rather than one set of tables, the cubes are instead spread
+* over a pool on each NUMA node, each reading its own node's replica.
+******************************************************************************/
+typedef std::function<void(size_t index, const SolveResult& result)>
+                                                              BatchCallback;
+
+std::vector<SolveResult> cube_solve_batch(const SolverTables& tables,
+                                          const Cube* cubes, size_t count,
+                                          const SolveOptions& options,
+                                          const BatchCallback& on_complete =
+                                                                 nullptr);
+std::vector<SolveResult> cube_solve_batch(const SolverTables& tables,
+                                          const std::vector<Cube>& cubes,
+                                          const SolveOptions& options,
+                                          const BatchCallback& on_complete =
+                                                                 nullptr);
+std::vector<SolveResult> cube_solve_batch(const CubeTableReplicas& replicas,
+                                          const Cube* cubes, size_t count,
+                                          const SolveOptions& options,
+                                          const BatchCallback& on_complete =
+                                                                 nullptr);
+
 #endif
@@ -0,0 +1,38 @@
+#ifndef CUBESYM_INCLUDED
+#define CUBESYM_INCLUDED
+
+/******************************************************************************
+* Header:  cubesym.h
+*
+* Purpose: Declarations for the symmetries of the cube, that is, the rotations
+*          and reflections of the whole cube which map the set of moves onto
+*          itself, and for the tables which describe how they act on moves.
+******************************************************************************/
+
+/******************************************************************************
+* Dependencies
+******************************************************************************/
+#include <cube.h>
+
+/******************************************************************************
+* Constants
+*
+* Symmetries are numbered 16 * a + 8 * b + 2 * c + d, meaning a turns of the
+* whole cube about the URF-DBL diagonal, then b half turns about the FB axis,
+* then c quarter turns about the UD axis, then d reflections in the RL plane.
+* The first NUM_SYMS_UD symmetries are therefore exactly those which leave the
+* UD axis in place.
+******************************************************************************/
+#define NUM_SYMS    48
+#define NUM_SYMS_UD 16
+
+/******************************************************************************
+* Symmetry functions
+******************************************************************************/
+const Cube& cube_symmetry(int sym);
+int cube_sym_inverse(int sym);
+int cube_sym_multiply(int sym_1, int sym_2);
+int cube_conjugate_move(int move, int sym);
+Cube cube_conjugate(const Cube& cube, int sym);
+
+#endif
@@ -0,0 +1,89 @@
+#ifndef CUBESYMPRUNE_INCLUDED
+#define CUBESYMPRUNE_INCLUDED
+
+/******************************************************************************
+* Header:  cubesymprune.h
+*
+* Purpose: Declaration of the CubeSymPrune class, a pruning table over a
+*          symmetry-reduced coordinate paired with a raw one.
+******************************************************************************/
+
+/******************************************************************************
+* Dependencies
+******************************************************************************/
+#include <cstdint>
+
+#include <cubecache.h>
+#include <cubemem.h>
+#include <cubephase.h>
+#include <cubepool.h>
+#include <cubeprune.h>
+#include <cubesym.h>
+#include <cubesymtrans.h>
+#include <cubetrans.h>
+
+/******************************************************************************
+* CubeSymPrune class declaration.
+*
+* Holds a distance for every pairing of a class of one coordinate under the
+* NUM_SYMS_UD symmetries with every value of a second, raw coordinate, packed
+* at index class * num_raw + raw. Positions related by one of the symmetries
+* are the same distance from solved, so one class representative stands for
+* all of its class. A position is looked up by conjugating it so that its
+* first coordinate becomes the representative, which transforms its raw
+* coordinate along with it. CubePhase1Prune, CubePhase2Prune and
+* CubeCornerPrune each choose the coordinates and moves, and how a position's
+* coordinates are combined for a lookup.
+******************************************************************************/
+class CubeSymPrune
+{
+private:
+    const CubeSymConj* raw_conj;
+    const CubeTrans* raw_trans;
+    const CubeMoveList* moves;
+    int num_classes, num_raw, fill_chunk;
+
+    CubeNibbleTable storage;
+
+    long set_all(int cls, int raw, int value);
+protected:
+    const CubeSymTrans* sym_trans;
+    const uint8_t* table;
+
+    CubeSymPrune(const CubeSymTrans* sym_table, const CubeSymConj* conj_table,
+                 const CubeTrans* raw_table, const CubeMoveList& move_list,
+                 int classes, int raw_size, int chunk);
+    int lookup(int sym_coord, int raw) const;
+public:
+    static const int num_sections = 1;
+
+    void fill(CubeThreadPool* pool = nullptr,
+              const CubePlacement& placement = CubePlacement());
+    void save(CubeTableWriter& writer) const;
+    bool matches(const CubeTableFile& file, int first) const;
+    void load(const CubeTableFile& file, int first);
+};
+
+/******************************************************************************
+* Function:  CubeSymPrune::lookup
+*
+* Purpose:   Reads the distance of a position.
+*
+* Params:    sym_coord - The sym coordinate of the position's first
+*                        coordinate.
+*            raw       - The position's raw coordinate.
+*
+* Returns:   The value stored for the position.
+*
+* Operation: Conjugates the raw coordinate by the symmetry taking the first
+*            coordinate to its class representative, and reads the packed
+*            entry. Defined here so that it can be inlined into the searches.
+******************************************************************************/
+inline int CubeSymPrune::lookup(int sym_coord, int raw) const
+{
+    long index = (long)(sym_coord / NUM_SYMS_UD) * num_raw +
+                 (*raw_conj)(raw, sym_coord % NUM_SYMS_UD);
+    return (table[index >> 1] >> ((index & 1) << 2)) & 0xF;
+}
+
+#endif
@@ -0,0 +1,194 @@
+#ifndef CUBESYMTRANS_INCLUDED
+#define CUBESYMTRANS_INCLUDED
+
+/******************************************************************************
+* Header:  cubesymtrans.h
+*
+* Purpose: Declarations for the CubeSymConj and CubeSymTrans classes, which
+*          describe how the symmetries fixing the UD axis act on a coordinate.
+******************************************************************************/
+
+/******************************************************************************
+* Dependencies
+******************************************************************************/
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include <cube.h>
+#include <cubecache.h>
+#include <cubesym.h>
+
+/******************************************************************************
+* CubeSymConj class declaration.
+*
+* A coordinate conjugation table. Entry (position, sym) is the coordinate of
+* S * C * S^-1, where C is any cube whose coordinate is position and S is one
+* of the first NUM_SYMS_UD symmetries. The coordinate must be one which such
+* conjugation preserves, as the phase 1 and phase 2 coordinates are.
+******************************************************************************/
+class CubeSymConj
+{
+private:
+    std::function<int(Cube&)> coord_func;
+    std::function<void(Cube&, int)> set_func;
+    int range;
+    std::vector<uint16_t> storage;
+    const uint16_t* table;
+public:
+    static const int num_sections = 1;
+
+    CubeSymConj(std::function<int(Cube&)> func,
+                std::function<void(Cube&, int)> set, int coord_range);
+    int size() const;
+    int operator()(int position, int sym) const;
+    void fill();
+    void save(CubeTableWriter& writer) const;
+    bool matches(const CubeTableFile& file, int first) const;
+    void load(const CubeTableFile& file, int first);
+};
+
+/******************************************************************************
+* CubeSymTrans class declaration.
+*
+* A symmetry-reduced coordinate and its transition table. The raw values of
+* the coordinate fall into classes of values related by the first NUM_SYMS_UD
+* symmetries, and each class has a representative. A position is described
+* by a sym coordinate, class * NUM_SYMS_UD + sym, meaning that conjugating it
+* by sym gives the class representative. Only the representatives need a row
+* of the transition table, so the table has about NUM_SYMS_UD times fewer
+* rows than one for the raw coordinate.
+******************************************************************************/
+class CubeSymTrans
+{
+private:
+    int phase;
+    std::function<int(Cube&)> coord_func;
+    std::function<void(Cube&, int)> set_func;
+    int range;
+    int classes;
+    int _solved_pos;
+
+    // For each raw value, its class and the symmetry taking it to the
+    // representative.
+    std::vector<uint16_t> class_storage;
+    std::vector<uint8_t> sym_storage;
+    const uint16_t* class_index;
+    const uint8_t* class_sym;
+
+    // For each class, the raw value of its representative and a mask of the
+    // symmetries which fix it.
+    std::vector<uint32_t> rep_storage;
+    std::vector<uint16_t> stab_storage;
+    const uint32_t* class_rep;
+    const uint16_t* class_stab;
+
+    // The sym coordinate reached by each move from each representative.
+    std::vector<uint32_t> storage;
+    const uint32_t* table;
+
+    // Local copies of the symmetry tables used on every transition.
+    uint8_t move_conj[NUM_MOVES][NUM_SYMS_UD];
+    uint8_t sym_product[NUM_SYMS_UD][NUM_SYMS_UD];
+public:
+    static const int num_sections = 5;
+
+    CubeSymTrans(int phase_desc, std::function<int(Cube&)> func,
+                 std::function<void(Cube&, int)> set, int coord_range);
+    int size() const;
+    int num_classes() const;
+    int solved_pos() const;
+    int sym_coord(int raw) const;
+    int rep(int cls) const;
+    uint16_t stabiliser(int cls) const;
+    int rep_move(int cls, int move) const;
+    int operator()(int sym_coord, int move) const;
+    void fill();
+    void save(CubeTableWriter& writer) const;
+    bool matches(const CubeTableFile& file, int first) const;
+    void load(const CubeTableFile& file, int first);
+};
+
+/******************************************************************************
+* Inline function definitions. These are used in the innermost loops of the
+* searches and of table generation.
+******************************************************************************/
+
+/******************************************************************************
+* Function:  CubeSymConj::operator()
+*
+* Purpose:   Returns an entry in the conjugation table.
+*
+* Params:    position - The coordinate value to conjugate.
+*            sym      - The symmetry to conjugate by.
+*
+* Returns:   The coordinate value of the conjugated position.
+*
+* Operation: The table is stored row-major, one row of NUM_SYMS_UD entries
+*            per coordinate value.
+******************************************************************************/
+inline int CubeSymConj::operator()(int position, int sym) const
+{
+    return table[position * NUM_SYMS_UD + sym];
+}
+
+/******************************************************************************
+* Function:  CubeSymTrans::sym_coord
+*
+* Purpose:   Converts a raw coordinate value into a sym coordinate.
+*
+* Params:    raw - The raw coordinate value.
+*
+* Returns:   The sym coordinate class * NUM_SYMS_UD + sym.
+*
+* Operation: Looks up the class and symmetry of the raw value.
+******************************************************************************/
+inline int CubeSymTrans::sym_coord(int raw) const
+{
+    return class_index[raw] * NUM_SYMS_UD + class_sym[raw];
+}
+
+/******************************************************************************
+* Function:  CubeSymTrans::rep_move
+*
+* Purpose:   Returns an entry in the transition table.
+*
+* Params:    cls  - The class whose representative the move starts from.
+*            move - The move to be performed.
+*
+* Returns:   The sym coordinate of the resulting position.
+*
+* Operation: The table is stored row-major, one row of NUM_MOVES entries per
+*            class.
+******************************************************************************/
+inline int CubeSymTrans::rep_move(int cls, int move) const
+{
+    return table[cls * NUM_MOVES + move];
+}
+
+/******************************************************************************
+* Function:  CubeSymTrans::operator()
+*
+* Purpose:   Applies a move to a position given by a sym coordinate.
+*
+* Params:    sym_coord - The sym coordinate of the 'from' position.
+*            move      - The move to be performed.
+*
+* Returns:   The sym coordinate of the resulting position.
+*
+* Operation: If conjugating the position X by S gives the representative R,
+*            then conjugating X * move by S gives R * move', where move' is
+*            the conjugate of the move by S. The table gives the class of
+*            R * move' and the symmetry T taking it to its representative, so
+*            the symmetry taking X * move there is T * S.
+******************************************************************************/
+inline int CubeSymTrans::operator()(int sym_coord, int move) const
+{
+    int cls = sym_coord / NUM_SYMS_UD;
+    int sym = sym_coord % NUM_SYMS_UD;
+    int next = table[cls * NUM_MOVES + move_conj[move][sym]];
+    return (next / NUM_SYMS_UD) * NUM_SYMS_UD +
+           sym_product[next % NUM_SYMS_UD][sym];
+}
+
+#endif
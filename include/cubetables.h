@@ -4,42 +4,149 @@
 /******************************************************************************
 * Header:  cubetables.h
 *
-* Purpose: Declarations of the transition and pruning tables for the cube.
+* Purpose: Declaration of the SolverTables class, which holds the transition
+*          and pruning tables for the cube.
 ******************************************************************************/
 
 /******************************************************************************
 * Dependencies
 ******************************************************************************/
+#include <memory>
+#include <string>
+#include <vector>
+
 #include <cube.h>
+#include <cubecache.h>
+#include <cubecornerprune.h>
+#include <cubemem.h>
+#include <cubepool.h>
 #include <cubetrans.h>
 #include <cubeprune.h>
+#include <cubephase1prune.h>
+#include <cubephase2prune.h>
+#include <cubesymtrans.h>
 
 /******************************************************************************
-* Transition tables
+* Options controlling which optional tables a SolverTables object builds.
+*
+* full_phase1 - Also build the full, symmetry-reduced phase-1 pruning table,
+*               which needs about 70MB more memory (and space in the table
+*               file) but prunes phase 1 far harder than the pairwise tables.
+* full_phase2 - Also build the symmetry-reduced corner and edge permutation
+*               table for phase 2, which needs about 56MB more and mostly
+*               helps the long phase 2 searches.
+* optimal     - Also build the tables used by OptimalSolver: the full
+*               phase-1 table, which is built whether or not full_phase1 is
+*               set, and the symmetry-reduced corner table, which needs
+*               about 3MB more.
+* placement   - Where to put the tables; see CubePlacement. Tables loaded
+*               from a file are read into placed memory rather than mapped
+*               from the file. Tables which are filled place their pruning
+*               tables, which are nearly all of the memory, and leave the
+*               small transition tables in ordinary memory.
 ******************************************************************************/
-extern CubeTrans cube_co_trans;
-extern CubeTrans cube_eo_trans;
-extern CubeTrans cube_cp_trans;
-extern CubeTrans cube_ud_sorted_trans;
-extern CubeTrans cube_rl_sorted_trans;
-extern CubeTrans cube_fb_sorted_trans;
-extern CubeTrans cube_ep_trans;
-extern CubeTrans cube_ud_unsorted_trans;
-extern CubeTrans cube_ud_perm_trans;
+struct TableOptions
+{
+    bool full_phase1 = false;
+    bool full_phase2 = false;
+    bool optimal = false;
+    CubePlacement placement;
+};
 
 /******************************************************************************
-* Pruning tables
+* The tables, or groups of tables, which can be filled one at a time. The
+* transition and pairwise pruning tables come first, in the order in which
+* they appear in a table file. Each optional group holds an optional pruning
+* table together with its symmetry tables, and is only used when enabled in
+* the options.
 ******************************************************************************/
-extern CubePrune cube_co_eo_prune;
-extern CubePrune cube_co_ud_prune;
-extern CubePrune cube_eo_ud_prune;
-extern CubePrune cube_ep_ud_prune;
-extern CubePrune cube_cp_ud_prune;
+enum SolverTableId {TABLE_CO_TRANS, TABLE_EO_TRANS, TABLE_CP_TRANS,
+                    TABLE_UD_SORTED_TRANS, TABLE_RL_SORTED_TRANS,
+                    TABLE_FB_SORTED_TRANS, TABLE_EP_TRANS,
+                    TABLE_UD_UNSORTED_TRANS, TABLE_UD_PERM_TRANS,
+                    TABLE_CO_EO_PRUNE, TABLE_CO_UD_PRUNE, TABLE_EO_UD_PRUNE,
+                    TABLE_EP_UD_PRUNE, TABLE_CP_UD_PRUNE, TABLE_PHASE1,
+                    TABLE_PHASE2, TABLE_CORNER, NUM_SOLVER_TABLES};
 
 /******************************************************************************
-* Functions to populate the tables.
+* SolverTables class declaration.
+*
+* A SolverTables object is built once, by filling or loading its tables, and
+* is never modified afterwards. Any number of CubeSolver instances, on any
+* number of threads, may then share a const reference to it without locking.
+******************************************************************************/
+class SolverTables
+{
+private:
+    std::unique_ptr<CubeTableFile> file;
+public:
+    const TableOptions options;
+
+    // Transition tables
+    CubeTrans co_trans;
+    CubeTrans eo_trans;
+    CubeTrans cp_trans;
+    CubeTrans ud_sorted_trans;
+    CubeTrans rl_sorted_trans;
+    CubeTrans fb_sorted_trans;
+    CubeTrans ep_trans;
+    CubeTrans ud_unsorted_trans;
+    CubeTrans ud_perm_trans;
+
+    // Pruning tables
+    CubePrune co_eo_prune;
+    CubePrune co_ud_prune;
+    CubePrune eo_ud_prune;
+    CubePrune ep_ud_prune;
+    CubePrune cp_ud_prune;
+
+    // Optional tables, only usable if enabled in the options.
+    CubeSymTrans flipslice_trans;
+    CubeSymConj twist_conj;
+    CubePhase1Prune phase1_prune;
+    CubeSymTrans cp_sym_trans;
+    CubeSymConj ep_conj;
+    CubePhase2Prune phase2_prune;
+    CubeSymTrans corner_sym_trans;
+    CubeCornerPrune corner_prune;
+
+    explicit SolverTables(const TableOptions& table_options = TableOptions());
+    SolverTables(const SolverTables&) = delete;
+    SolverTables& operator=(const SolverTables&) = delete;
+
+    // Functions to populate the tables.
+    void fill_trans_tables(CubeThreadPool* pool = nullptr);
+    void fill_pruning_tables(CubeThreadPool* pool = nullptr);
+    bool uses_table(SolverTableId table) const;
+    void fill_table(SolverTableId table, CubeThreadPool* pool = nullptr);
+
+    // Functions to persist the tables to disk and load them back again.
+    bool save(const std::string& path) const;
+    bool load(const std::string& path);
+    bool init(const std::string& path);
+};
+
+/******************************************************************************
+* CubeTableReplicas class declaration.
+*
+* One set of tables for each NUMA node with processors, each placed on its
+* own node, so that threads pinned to a node only ever read local memory.
+* Nodes with memory but no processors get no replica, since no thread runs
+* there to read it. On a machine with a single node there is just one set,
+* and if no node lists any processors there is one set tied to no node. Like
+* SolverTables, the replicas are never modified once they have been set up.
 ******************************************************************************/
-void cube_fill_all_trans_tables();
-void cube_fill_all_pruning_tables();
+class CubeTableReplicas
+{
+private:
+    std::vector<std::unique_ptr<SolverTables>> replicas;
+    std::vector<int> nodes;
+public:
+    bool init(const std::string& path,
+              const TableOptions& table_options = TableOptions());
+    int size() const;
+    int node(int index) const;
+    const SolverTables& tables(int index) const;
+};
 
 #endif
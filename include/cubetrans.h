@@ -10,10 +10,34 @@
 /******************************************************************************
 * Dependencies
 ******************************************************************************/
-#include <functional>
+#include <cstdint>
 #include <vector>
 
 #include <cube.h>
+#include <cubecache.h>
+#include <cubephase.h>
+#include <cubepool.h>
+
+/******************************************************************************
+* CubeCoord template declaration.
+*
+* Describes a coordinate by the Cube member functions which calculate it from
+* a cube and set it on one. Passing the functions as template arguments,
+* rather than as function objects, makes the calls direct, so that they can
+* be inlined into the table-building loops.
+******************************************************************************/
+template <int (Cube::*Get)() const, void (Cube::*Set)(int)>
+struct CubeCoord
+{
+    static int get(Cube& cube)
+    {
+        return (cube.*Get)();
+    }
+    static void set(Cube& cube, int value)
+    {
+        (cube.*Set)(value);
+    }
+};
 
 /******************************************************************************
 * CubeTrans class declaration.
@@ -22,16 +46,130 @@ class CubeTrans
 {
 private:
     int phase;
-    std::function<int(Cube&)> coord_func;
-    std::vector<std::vector<int>> table;
+    int range;
+    std::vector<uint16_t> storage;
+    const uint16_t* table;
     int _solved_pos;
-    std::vector<int> allowed_moves;
+
+    // Fills the rows of the table for a range of coordinate values, built
+    // for the coordinate this table describes.
+    void (*fill_rows)(CubeTrans& trans, long begin, long end);
+
+    template <typename Coord>
+    static void coord_rows(CubeTrans& trans, long begin, long end);
 public:
-    CubeTrans(int phase_desc, std::function<int(Cube&)> func, int range);
-    int solved_pos();
-    int size();
-    int operator()(int position, int move);
-    void fill();
+    template <typename Coord>
+    CubeTrans(int phase_desc, Coord coord, int coord_range);
+    int solved_pos() const;
+    int size() const;
+    int operator()(int position, int move) const;
+    const uint16_t* row(int position) const;
+    void fill(CubeThreadPool* pool = nullptr);
+    void save(CubeTableWriter& writer) const;
+    bool matches(const CubeTableFile& file, int index) const;
+    void load(const CubeTableFile& file, int index);
 };
 
+/******************************************************************************
+* Function:  CubeTrans::operator()
+*
+* Purpose:   Returns an entry in the transition table.
+*
+* Params:    position - The coordinate value of the 'from' position
+*            move     - The move to be performed.
+*
+* Returns:   The coordinate value of the resulting position.
+*
+* Operation: The table is stored row-major, one row of NUM_MOVES entries per
+*            coordinate value. Defined here so that it can be inlined into
+*            the searches.
+******************************************************************************/
+inline int CubeTrans::operator()(int position, int move) const
+{
+    return table[position * NUM_MOVES + move];
+}
+
+/******************************************************************************
+* Function:  CubeTrans::row
+*
+* Purpose:   Returns a whole row of the transition table.
+*
+* Params:    position - The coordinate value of the 'from' position.
+*
+* Returns:   The NUM_MOVES entries for that position, indexed by move. Entries
+*            for moves not allowed in the table's phase are zero.
+*
+* Operation: Rows are contiguous, so this is just an offset into the table.
+******************************************************************************/
+inline const uint16_t* CubeTrans::row(int position) const
+{
+    return table + position * NUM_MOVES;
+}
+
+/******************************************************************************
+* Function:  CubeTrans::CubeTrans
+*
+* Purpose:   Constructor for the CubeTrans class.
+*
+* Params:    phase_desc  - Whether this transition table is relevant in phase
+*                          1 or phase 2 of the two-phase algorithm.
+*            coord       - A CubeCoord describing the coordinate.
+*            coord_range - The number of values taken by the coordinate.
+*
+* Returns:   Nothing.
+*
+* Operation: Records the coordinate's fill function and solved value. Space
+*            for the entries is not allocated until the table is filled, since
+*            it may instead be loaded from a table file.
+******************************************************************************/
+template <typename Coord>
+CubeTrans::CubeTrans(int phase_desc, Coord, int coord_range)
+{
+    Cube solved_cube;
+    phase = phase_desc;
+    range = coord_range;
+    table = nullptr;
+    _solved_pos = Coord::get(solved_cube);
+    fill_rows = &CubeTrans::coord_rows<Coord>;
+}
+
+/******************************************************************************
+* Function:  CubeTrans::coord_rows
+*
+* Purpose:   Fills in the rows of a transition table for a range of
+*            coordinate values.
+*
+* Params:    trans - The table being filled.
+*            begin - The first coordinate value to fill in.
+*            end   - One past the last coordinate value to fill in.
+*
+* Returns:   Nothing.
+*
+* Operation: Sets each coordinate value on a solved cube, to get a cube which
+*            has it, and records the value after each allowed move. Every
+*            coordinate value is handled on its own, so ranges may be filled
+*            concurrently.
+******************************************************************************/
+template <typename Coord>
+void CubeTrans::coord_rows(CubeTrans& trans, long begin, long end)
+{
+    const CubeMoveList& allowed_moves = (trans.phase == PHASE_1) ?
+                                        cube_p1_allowed_moves[NUM_MOVES] :
+                                        cube_p2_allowed_moves[NUM_MOVES];
+    uint16_t* rows = trans.storage.data();
+
+    for (long position = begin; position < end; ++position)
+    {
+        Cube cube;
+        Coord::set(cube, position);
+
+        for (int move : allowed_moves)
+        {
+            Cube next_cube = cube;
+            next_cube.apply_move(move);
+            rows[position * NUM_MOVES + move] = Coord::get(next_cube);
+        }
+    }
+}
+
 #endif
@@ -14,6 +14,10 @@
 * Includes
 ******************************************************************************/
 #include <algorithm>
+#include <array>
+#include <cctype>
+#include <cstdint>
+#include <string_view>
 #include <vector>
 
 #include <cube.h>
@@ -22,36 +26,379 @@
 * Helper functions
 ******************************************************************************/
 
+/******************************************************************************
+* The binomial coefficients (n choose k) for n, k in the range 0..12, built at
+* compile time by Pascal's rule. Every coordinate which counts subsets is a
+* subset of the 12 edge positions, so nothing larger is needed.
+******************************************************************************/
+struct BinomTable
+{
+    int value[13][13];
+};
+
+static constexpr BinomTable make_binom_table()
+{
+    BinomTable table = {};
+    for (int n = 0; n <= 12; ++n)
+    {
+        table.value[n][0] = 1;
+        for (int k = 1; k <= n; ++k)
+        {
+            table.value[n][k] = table.value[n - 1][k - 1] +
+                                table.value[n - 1][k];
+        }
+    }
+    return table;
+}
+
+static constexpr BinomTable binom_table = make_binom_table();
+
 /******************************************************************************
 * Function:  binom
 *
 * Purpose:   Calculates the value of a binomial coefficient.
 *
-* Params:    n, k - The result we are computing is (n choose k)
+* Params:    n, k - The result we are computing is (n choose k), where n is in
+*                   the range 0..12.
 *
-* Returns:   The value of the binomial coefficient (n choose k).
+* Returns:   The value of the binomial coefficient (n choose k), which is 0
+*            if k is negative or greater than n.
 *
-* Operation: Uses the direct formula n * (n - 1) * ... * (n - k + 1) / k!
-*            to compute the result.
+* Operation: Looks the result up in binom_table.
 ******************************************************************************/
 int binom(int n, int k)
 {
-    // Calculate the numerator of the formula
-    int num = 1;
-    for (int ii = 0; ii < k; ++ii)
+    return (k < 0 || k > n) ? 0 : binom_table.value[n][k];
+}
+
+/******************************************************************************
+* The edges making up each slice, as bit masks of edge numbers.
+******************************************************************************/
+static const int ud_slice_mask = (1 << EDGE_FR) | (1 << EDGE_FL) |
+                                 (1 << EDGE_BL) | (1 << EDGE_BR);
+static const int rl_slice_mask = (1 << EDGE_UF) | (1 << EDGE_UB) |
+                                 (1 << EDGE_DB) | (1 << EDGE_DF);
+static const int fb_slice_mask = (1 << EDGE_UR) | (1 << EDGE_UL) |
+                                 (1 << EDGE_DL) | (1 << EDGE_DR);
+
+/******************************************************************************
+* The slice each edge belongs to, and the weight of each digit of the rank of
+* the order of a slice's edges, indexed by how many of them have been met.
+******************************************************************************/
+enum {SLICE_UD, SLICE_RL, SLICE_FB, NUM_SLICES};
+
+static const uint8_t edge_slice[12] = {
+    SLICE_RL, SLICE_FB, SLICE_RL, SLICE_FB,
+    SLICE_RL, SLICE_FB, SLICE_RL, SLICE_FB,
+    SLICE_UD, SLICE_UD, SLICE_UD, SLICE_UD};
+
+static const int slice_factorial[5] = {0, 1, 1, 2, 6};
+
+/******************************************************************************
+* The sorted coordinate of one slice, built up a position at a time by
+* walking up the edge positions, as Cube::coord_slice_sorted describes.
+*
+* seen      - The slice edges met so far, as a bit mask of edge numbers.
+* found     - How many slice edges have been met.
+* pos_rank  - The rank of the positions of the edges met so far.
+* perm_rank - The rank of their order.
+******************************************************************************/
+struct SliceRank
+{
+    int seen = 0;
+    int found = 0;
+    int pos_rank = 0;
+    int perm_rank = 0;
+
+    // Adds the slice edge found in position n, above those already met. Its
+    // digit of the order rank counts the edges below it which are higher.
+    void add(int n, int edge)
+    {
+        ++found;
+        pos_rank += binom_table.value[n][found];
+        perm_rank += __builtin_popcount(seen & ~((2 << edge) - 1)) *
+                     slice_factorial[found];
+        seen |= 1 << edge;
+    }
+
+    int coord() const
+    {
+        return 24 * pos_rank + perm_rank;
+    }
+};
+
+/******************************************************************************
+* Function:  slice_order
+*
+* Purpose:   Decodes the order of four slice edges from its rank, as computed
+*            by Cube::coord_slice_sorted.
+*
+* Params:    slice_mask - The edges of the slice.
+*            perm_rank  - The rank of their order, in the range 0..23.
+*            order      - Receives the four edges, in the order in which they
+*                         are met walking down from the highest position.
+*
+* Returns:   Nothing.
+*
+* Operation: The rank has one digit per edge, in a factorial number system,
+*            counting how many of the edges after it are higher. Each digit
+*            therefore picks an edge out of those not yet placed, counting
+*            down from the highest.
+******************************************************************************/
+static void slice_order(int slice_mask, int perm_rank, int* order)
+{
+    int remaining[4];
+    int count = 0;
+    for (int edge = 0; edge < 12; ++edge)
+    {
+        if ((slice_mask >> edge) & 1)
+        {
+            remaining[count++] = edge;
+        }
+    }
+
+    static const int factorial[4] = {6, 2, 1, 1};
+    for (int ii = 0; ii < 4; ++ii)
     {
-        num *= (n - ii);
+        int digit = (perm_rank / factorial[ii]) % (4 - ii);
+        int pick = count - 1 - digit;
+        order[ii] = remaining[pick];
+        for (int jj = pick; jj < count - 1; ++jj)
+        {
+            remaining[jj] = remaining[jj + 1];
+        }
+        --count;
     }
+}
+
+/******************************************************************************
+* Move tables
+******************************************************************************/
+
+/******************************************************************************
+* The effect of each move at the cubie level. For a move m, the piece which
+* ends up in position i came from position cp[m][i] (or ep[m][i] for edges)
+* and picks up an extra twist of co[m][i] (or flip of eo[m][i]).
+******************************************************************************/
+struct CubieMoves
+{
+    uint8_t cp[NUM_MOVES][8];
+    uint8_t co[NUM_MOVES][8];
+    uint8_t ep[NUM_MOVES][12];
+    uint8_t eo[NUM_MOVES][12];
+};
 
-    // Calculate the denominator k!
-    int denom = 1;
-    for (int ii = 2; ii <= k; ++ii)
+/******************************************************************************
+* The pieces cycled by a quarter turn of each face, in the order U, L, F, R, B,
+* D, together with the twist or flip picked up by a piece leaving each of the
+* listed positions.
+******************************************************************************/
+static constexpr uint8_t face_corners[6][4] = {
+    {CORNER_URF, CORNER_UFL, CORNER_ULB, CORNER_UBR},
+    {CORNER_UFL, CORNER_DLF, CORNER_DBL, CORNER_ULB},
+    {CORNER_URF, CORNER_DFR, CORNER_DLF, CORNER_UFL},
+    {CORNER_URF, CORNER_UBR, CORNER_DRB, CORNER_DFR},
+    {CORNER_UBR, CORNER_ULB, CORNER_DBL, CORNER_DRB},
+    {CORNER_DFR, CORNER_DRB, CORNER_DBL, CORNER_DLF}};
+
+static constexpr uint8_t face_edges[6][4] = {
+    {EDGE_UF, EDGE_UL, EDGE_UB, EDGE_UR},
+    {EDGE_UL, EDGE_FL, EDGE_DL, EDGE_BL},
+    {EDGE_UF, EDGE_FR, EDGE_DF, EDGE_FL},
+    {EDGE_UR, EDGE_BR, EDGE_DR, EDGE_FR},
+    {EDGE_UB, EDGE_BL, EDGE_DB, EDGE_BR},
+    {EDGE_DF, EDGE_DR, EDGE_DB, EDGE_DL}};
+
+static constexpr uint8_t face_twist[6][4] = {
+    {TWIST_NONE, TWIST_NONE, TWIST_NONE, TWIST_NONE},
+    {TWIST_CCW,  TWIST_CW,   TWIST_CCW,  TWIST_CW},
+    {TWIST_CCW,  TWIST_CW,   TWIST_CCW,  TWIST_CW},
+    {TWIST_CW,   TWIST_CCW,  TWIST_CW,   TWIST_CCW},
+    {TWIST_CW,   TWIST_CCW,  TWIST_CW,   TWIST_CCW},
+    {TWIST_NONE, TWIST_NONE, TWIST_NONE, TWIST_NONE}};
+
+static constexpr uint8_t face_flip[6][4] = {
+    {FLIP_NONE, FLIP_NONE, FLIP_NONE, FLIP_NONE},
+    {FLIP_NONE, FLIP_NONE, FLIP_NONE, FLIP_NONE},
+    {FLIP_FLIP, FLIP_FLIP, FLIP_FLIP, FLIP_FLIP},
+    {FLIP_NONE, FLIP_NONE, FLIP_NONE, FLIP_NONE},
+    {FLIP_FLIP, FLIP_FLIP, FLIP_FLIP, FLIP_FLIP},
+    {FLIP_NONE, FLIP_NONE, FLIP_NONE, FLIP_NONE}};
+
+/******************************************************************************
+* Function:  make_cubie_moves
+*
+* Purpose:   Builds the cubie-level move tables.
+*
+* Params:    None.
+*
+* Returns:   The move tables for all NUM_MOVES moves.
+*
+* Operation: Evaluated at compile time. Moves are numbered face * 3 + amount,
+*            where amount is 0, 1, 2 for a quarter, half and anti-clockwise
+*            quarter turn. A turn by t quarters moves the piece in the ii-th
+*            listed position t places around the cycle, accumulating the twist
+*            or flip of each position it leaves along the way.
+******************************************************************************/
+static constexpr CubieMoves make_cubie_moves()
+{
+    CubieMoves moves = {};
+    for (int move = 0; move < NUM_MOVES; ++move)
+    {
+        int face = move / 3;
+        int turn_amt = move % 3 + 1;
+
+        for (int ii = 0; ii < 8; ++ii)
+        {
+            moves.cp[move][ii] = ii;
+            moves.co[move][ii] = TWIST_NONE;
+        }
+        for (int ii = 0; ii < 12; ++ii)
+        {
+            moves.ep[move][ii] = ii;
+            moves.eo[move][ii] = FLIP_NONE;
+        }
+
+        for (int ii = 0; ii < 4; ++ii)
+        {
+            int twist = 0, flip = 0;
+            for (int jj = 0; jj < turn_amt; ++jj)
+            {
+                twist += face_twist[face][(ii + jj) % 4];
+                flip  += face_flip[face][(ii + jj) % 4];
+            }
+
+            int to = face_corners[face][(ii + turn_amt) % 4];
+            moves.cp[move][to] = face_corners[face][ii];
+            moves.co[move][to] = twist % 3;
+
+            to = face_edges[face][(ii + turn_amt) % 4];
+            moves.ep[move][to] = face_edges[face][ii];
+            moves.eo[move][to] = flip % 2;
+        }
+    }
+    return moves;
+}
+
+static constexpr CubieMoves cubie_moves = make_cubie_moves();
+
+/******************************************************************************
+* Lookup tables for combining two twists. Plain twists add modulo 3. Mirror
+* symmetries of the cube reverse the sense of a twist, which is recorded by
+* adding 3 to the orientation, so the full table covers combinations of
+* twists 0..5 as they arise when conjugating by a symmetry.
+******************************************************************************/
+static constexpr uint8_t twist_sum[3][3] = {{0, 1, 2}, {1, 2, 0}, {2, 0, 1}};
+
+static constexpr uint8_t twist_product[6][6] = {
+    {0, 1, 2, 3, 4, 5}, {1, 2, 0, 4, 5, 3}, {2, 0, 1, 5, 3, 4},
+    {3, 5, 4, 0, 2, 1}, {4, 3, 5, 1, 0, 2}, {5, 4, 3, 2, 1, 0}};
+
+/******************************************************************************
+* Facelet tables
+******************************************************************************/
+
+/******************************************************************************
+* A facelet string lists the 54 stickers of the cube face by face in the order
+* U, R, F, D, L, B, each face read row by row as seen from outside the cube,
+* with U and D read with the F face at the bottom and top respectively, and
+* the other faces with U at the top. So facelet 4 of each face is its centre.
+******************************************************************************/
+enum {FACELET_U, FACELET_R, FACELET_F, FACELET_D, FACELET_L, FACELET_B};
+
+#define FACELET(face, index) (9 * FACELET_##face + (index) - 1)
+
+/******************************************************************************
+* The facelets of each corner and edge position. A corner's facelets are
+* listed clockwise starting from its U or D facelet, so that the twist of a
+* corner is the position in this list at which its U or D colour appears.
+* An edge's facelets start with the U or D facelet if it has one, and the F
+* or B facelet otherwise, and an edge is flipped if its colours appear the
+* other way round.
+******************************************************************************/
+static constexpr uint8_t corner_facelets[8][3] = {
+    {FACELET(U, 9), FACELET(R, 1), FACELET(F, 3)},
+    {FACELET(U, 7), FACELET(F, 1), FACELET(L, 3)},
+    {FACELET(U, 1), FACELET(L, 1), FACELET(B, 3)},
+    {FACELET(U, 3), FACELET(B, 1), FACELET(R, 3)},
+    {FACELET(D, 3), FACELET(F, 9), FACELET(R, 7)},
+    {FACELET(D, 1), FACELET(L, 9), FACELET(F, 7)},
+    {FACELET(D, 7), FACELET(B, 9), FACELET(L, 7)},
+    {FACELET(D, 9), FACELET(R, 9), FACELET(B, 7)}};
+
+static constexpr uint8_t edge_facelets[12][2] = {
+    {FACELET(U, 8), FACELET(F, 2)}, {FACELET(U, 4), FACELET(L, 2)},
+    {FACELET(U, 2), FACELET(B, 2)}, {FACELET(U, 6), FACELET(R, 2)},
+    {FACELET(D, 2), FACELET(F, 8)}, {FACELET(D, 4), FACELET(L, 8)},
+    {FACELET(D, 8), FACELET(B, 8)}, {FACELET(D, 6), FACELET(R, 8)},
+    {FACELET(F, 6), FACELET(R, 4)}, {FACELET(F, 4), FACELET(L, 6)},
+    {FACELET(B, 6), FACELET(L, 4)}, {FACELET(B, 4), FACELET(R, 6)}};
+
+/******************************************************************************
+* The faces each corner and edge piece belongs to, in the same order as its
+* facelets above, so that a solved piece has these colours.
+******************************************************************************/
+static constexpr uint8_t corner_faces[8][3] = {
+    {FACELET_U, FACELET_R, FACELET_F}, {FACELET_U, FACELET_F, FACELET_L},
+    {FACELET_U, FACELET_L, FACELET_B}, {FACELET_U, FACELET_B, FACELET_R},
+    {FACELET_D, FACELET_F, FACELET_R}, {FACELET_D, FACELET_L, FACELET_F},
+    {FACELET_D, FACELET_B, FACELET_L}, {FACELET_D, FACELET_R, FACELET_B}};
+
+static constexpr uint8_t edge_faces[12][2] = {
+    {FACELET_U, FACELET_F}, {FACELET_U, FACELET_L}, {FACELET_U, FACELET_B},
+    {FACELET_U, FACELET_R}, {FACELET_D, FACELET_F}, {FACELET_D, FACELET_L},
+    {FACELET_D, FACELET_B}, {FACELET_D, FACELET_R}, {FACELET_F, FACELET_R},
+    {FACELET_F, FACELET_L}, {FACELET_B, FACELET_L}, {FACELET_B, FACELET_R}};
+
+/******************************************************************************
+* Function:  parse_face
+*
+* Purpose:   Converts a face letter in move notation into a face number.
+*
+* Params:    letter - The letter to convert.
+*
+* Returns:   The face number used in move numbering, or -1 if the letter does
+*            not name a face.
+*
+* Operation: Move numbering uses the face order U, L, F, R, B, D.
+******************************************************************************/
+static int parse_face(char letter)
+{
+    switch (letter)
     {
-        denom *= ii;
+        case 'U': return MOVE_U / 3;
+        case 'L': return MOVE_L / 3;
+        case 'F': return MOVE_F / 3;
+        case 'R': return MOVE_R / 3;
+        case 'B': return MOVE_B / 3;
+        case 'D': return MOVE_D / 3;
+        default:  return -1;
     }
+}
 
-    // Return the result
-    return num / denom;
+/******************************************************************************
+* Function:  permutation_parity
+*
+* Purpose:   Works out whether a permutation is odd or even.
+*
+* Params:    perm - The permutation, which must contain each of 0..N-1 once.
+*
+* Returns:   1 if the permutation is odd, 0 if it is even.
+*
+* Operation: Counts the pairs of entries which are out of order.
+******************************************************************************/
+template <size_t N>
+static int permutation_parity(const std::array<uint8_t, N>& perm)
+{
+    int inversions = 0;
+    for (size_t ii = 0; ii < N; ++ii)
+    {
+        for (size_t jj = ii + 1; jj < N; ++jj)
+        {
+            inversions += (perm[ii] > perm[jj]);
+        }
+    }
+    return inversions & 1;
 }
 
 /******************************************************************************
@@ -98,10 +445,233 @@ Cube::Cube()
 Cube::Cube(std::vector<int> corner_perm, std::vector<int> corner_orient,
            std::vector<int> edge_perm,   std::vector<int> edge_orient)
 {
-    corner_permutation = corner_perm;
-    corner_orientation = corner_orient;
-    edge_permutation   = edge_perm;
-    edge_orientation   = edge_orient;
+    for (int ii = 0; ii < 8; ++ii)
+    {
+        corner_permutation[ii] = corner_perm[ii];
+        corner_orientation[ii] = corner_orient[ii];
+    }
+    for (int ii = 0; ii < 12; ++ii)
+    {
+        edge_permutation[ii] = edge_perm[ii];
+        edge_orientation[ii] = edge_orient[ii];
+    }
+}
+
+/******************************************************************************
+* Function:  Cube::from_facelets
+*
+* Purpose:   Builds a cube from a facelet string.
+*
+* Params:    facelets - 54 characters, laid out as described above the facelet
+*                       tables. Any six characters may be used as colours;
+*                       each face's colour is read from its centre.
+*            cube     - Receives the cube. Only modified on success.
+*
+* Returns:   true if the string describes a cube which can be solved, false
+*            if it is malformed, if some piece's colours do not match any
+*            piece, or if the pieces are twisted, flipped or swapped in a way
+*            no sequence of moves can produce.
+*
+* Operation: Each piece is identified from its colours: a corner's twist is
+*            the position of its U or D colour, and the remaining two colours
+*            pick out the corner; an edge is found by its two colours in
+*            either order. Works in fixed-size arrays, without allocating.
+******************************************************************************/
+bool Cube::from_facelets(std::string_view facelets, Cube& cube)
+{
+    if (facelets.size() != 54)
+    {
+        return false;
+    }
+
+    // Map each colour character to the face whose centre has it.
+    int8_t colour_face[256];
+    std::fill(colour_face, colour_face + 256, -1);
+    for (int face = 0; face < 6; ++face)
+    {
+        unsigned char centre = facelets[9 * face + 4];
+        if (colour_face[centre] != -1)
+        {
+            return false;
+        }
+        colour_face[centre] = face;
+    }
+
+    uint8_t face_of[54];
+    for (int ii = 0; ii < 54; ++ii)
+    {
+        int face = colour_face[(unsigned char)facelets[ii]];
+        if (face == -1)
+        {
+            return false;
+        }
+        face_of[ii] = face;
+    }
+
+    Cube result;
+    for (int ii = 0; ii < 8; ++ii)
+    {
+        int twist = 0;
+        while (twist < 3 &&
+               face_of[corner_facelets[ii][twist]] != FACELET_U &&
+               face_of[corner_facelets[ii][twist]] != FACELET_D)
+        {
+            ++twist;
+        }
+        if (twist == 3)
+        {
+            return false;
+        }
+
+        int face_1 = face_of[corner_facelets[ii][(twist + 1) % 3]];
+        int face_2 = face_of[corner_facelets[ii][(twist + 2) % 3]];
+        int corner = 0;
+        while (corner < 8 && (corner_faces[corner][1] != face_1 ||
+                              corner_faces[corner][2] != face_2))
+        {
+            ++corner;
+        }
+        if (corner == 8)
+        {
+            return false;
+        }
+
+        result.corner_permutation[ii] = corner;
+        result.corner_orientation[ii] = twist;
+    }
+
+    for (int ii = 0; ii < 12; ++ii)
+    {
+        int face_0 = face_of[edge_facelets[ii][0]];
+        int face_1 = face_of[edge_facelets[ii][1]];
+        int edge = 0;
+        for (; edge < 12; ++edge)
+        {
+            int solved_0 = edge_faces[edge][0];
+            int solved_1 = edge_faces[edge][1];
+            if ((solved_0 == face_0 && solved_1 == face_1) ||
+                (solved_0 == face_1 && solved_1 == face_0))
+            {
+                break;
+            }
+        }
+        if (edge == 12)
+        {
+            return false;
+        }
+
+        result.edge_permutation[ii] = edge;
+        result.edge_orientation[ii] = (edge_faces[edge][0] != face_0);
+    }
+
+    if (!result.is_valid())
+    {
+        return false;
+    }
+    cube = result;
+    return true;
+}
+
+/******************************************************************************
+* Function:  Cube::from_moves
+*
+* Purpose:   Builds a cube by applying a scramble to the solved cube.
+*
+* Params:    moves - A sequence of moves in standard notation, such as
+*                    "R U2 F'", separated by whitespace. A face letter on its
+*                    own is a clockwise quarter turn, and may be followed by
+*                    2 for a half turn or ' for an anti-clockwise quarter
+*                    turn.
+*            cube  - Receives the cube. Only modified on success.
+*
+* Returns:   true if every move was understood, false otherwise.
+*
+* Operation: Scans the string once, applying each move as it is read.
+******************************************************************************/
+bool Cube::from_moves(std::string_view moves, Cube& cube)
+{
+    Cube result;
+    size_t pos = 0;
+    while (pos < moves.size())
+    {
+        char letter = moves[pos++];
+        if (std::isspace((unsigned char)letter))
+        {
+            continue;
+        }
+
+        int face = parse_face(letter);
+        if (face < 0)
+        {
+            return false;
+        }
+
+        int amount = 0;
+        if (pos < moves.size() && moves[pos] == '2')
+        {
+            amount = 1;
+            ++pos;
+        }
+        else if (pos < moves.size() && moves[pos] == '\'')
+        {
+            amount = 2;
+            ++pos;
+        }
+
+        // Moves must be separated from whatever follows them.
+        if (pos < moves.size() && !std::isspace((unsigned char)moves[pos]))
+        {
+            return false;
+        }
+        result.apply_move(3 * face + amount);
+    }
+
+    cube = result;
+    return true;
+}
+
+/******************************************************************************
+* Function:  Cube::is_valid
+*
+* Purpose:   Checks whether this cube can be solved.
+*
+* Params:    None.
+*
+* Returns:   true if the cube is some sequence of moves away from solved.
+*
+* Operation: The pieces must each appear exactly once with an orientation in
+*            range, the total twist must be a multiple of three, the total
+*            flip must be even, and the corner and edge permutations must
+*            have the same parity. These conditions are also sufficient.
+******************************************************************************/
+bool Cube::is_valid() const
+{
+    int corners_seen = 0, edges_seen = 0;
+    int twist = 0, flip = 0;
+
+    for (int ii = 0; ii < 8; ++ii)
+    {
+        if (corner_permutation[ii] >= 8 || corner_orientation[ii] >= 3)
+        {
+            return false;
+        }
+        corners_seen |= 1 << corner_permutation[ii];
+        twist += corner_orientation[ii];
+    }
+    for (int ii = 0; ii < 12; ++ii)
+    {
+        if (edge_permutation[ii] >= 12 || edge_orientation[ii] >= 2)
+        {
+            return false;
+        }
+        edges_seen |= 1 << edge_permutation[ii];
+        flip += edge_orientation[ii];
+    }
+
+    return corners_seen == 0xFF && edges_seen == 0xFFF &&
+           twist % 3 == 0 && flip % 2 == 0 &&
+           permutation_parity(corner_permutation) ==
+           permutation_parity(edge_permutation);
 }
 
 /******************************************************************************
@@ -111,158 +681,408 @@ Cube::Cube(std::vector<int> corner_perm, std::vector<int> corner_orient,
 /******************************************************************************
 * Function:  Cube::perform_move
 *
-* Purpose:   Performs a move on this Cube object
+* Purpose:   Performs a move on a copy of this Cube object
 *
 * Params:    move - which move is being performed.
 *
 * Returns:   A Cube object holding the result of the move.
 *
-* Operation: Update the permutation and orientation of all the pieces according
-*            to the particular move being performed.
-******************************************************************************/
-Cube Cube::perform_move(int move)
-{
-    // Local variables
-    std::vector<int> corners_moved;
-    std::vector<int> edges_moved;
-    std::vector<int> corner_twist;
-    std::vector<int> edge_flip;
-
-    // Set up new vectors in which to hold the result of the move having been
-    // performed
-    std::vector<int> new_corner_permutation = corner_permutation;
-    std::vector<int> new_corner_orientation = corner_orientation;
-    std::vector<int> new_edge_permutation = edge_permutation;
-    std::vector<int> new_edge_orientation = edge_orientation;
-
-    // Switch based on the face being turned to determine which corners and
-    // edges are permuted by this move and how the orientations of the pieces
-    // are affected.
-    switch (move)
-    {
-        case MOVE_U:
-        case MOVE_U2:
-        case MOVE_UP:
-            corners_moved = {CORNER_URF, CORNER_UFL, CORNER_ULB, CORNER_UBR};
-            edges_moved   = {EDGE_UF, EDGE_UL, EDGE_UB, EDGE_UR};
-            corner_twist  = {TWIST_NONE, TWIST_NONE, TWIST_NONE, TWIST_NONE};
-            edge_flip     = {FLIP_NONE, FLIP_NONE, FLIP_NONE, FLIP_NONE};
-            break;
-
-        case MOVE_L:
-        case MOVE_L2:
-        case MOVE_LP:
-            corners_moved = {CORNER_UFL, CORNER_DLF, CORNER_DBL, CORNER_ULB};
-            edges_moved   = {EDGE_UL, EDGE_FL, EDGE_DL, EDGE_BL};
-            corner_twist  = {TWIST_CCW, TWIST_CW, TWIST_CCW, TWIST_CW};
-            edge_flip     = {FLIP_NONE, FLIP_NONE, FLIP_NONE, FLIP_NONE};
-            break;
-
-        case MOVE_F:
-        case MOVE_F2:
-        case MOVE_FP:
-            corners_moved = {CORNER_URF, CORNER_DFR, CORNER_DLF, CORNER_UFL};
-            edges_moved   = {EDGE_UF, EDGE_FR, EDGE_DF, EDGE_FL};
-            corner_twist  = {TWIST_CCW, TWIST_CW, TWIST_CCW, TWIST_CW};
-            edge_flip     = {FLIP_FLIP, FLIP_FLIP, FLIP_FLIP, FLIP_FLIP};
-            break;
-
-        case MOVE_R:
-        case MOVE_R2:
-        case MOVE_RP:
-            corners_moved = {CORNER_URF, CORNER_UBR, CORNER_DRB, CORNER_DFR};
-            edges_moved   = {EDGE_UR, EDGE_BR, EDGE_DR, EDGE_FR};
-            corner_twist  = {TWIST_CW, TWIST_CCW, TWIST_CW, TWIST_CCW};
-            edge_flip     = {FLIP_NONE, FLIP_NONE, FLIP_NONE, FLIP_NONE};
-            break;
-
-        case MOVE_B:
-        case MOVE_B2:
-        case MOVE_BP:
-            corners_moved = {CORNER_UBR, CORNER_ULB, CORNER_DBL, CORNER_DRB};
-            edges_moved   = {EDGE_UB, EDGE_BL, EDGE_DB, EDGE_BR};
-            corner_twist  = {TWIST_CW, TWIST_CCW, TWIST_CW, TWIST_CCW};
-            edge_flip     = {FLIP_FLIP, FLIP_FLIP, FLIP_FLIP, FLIP_FLIP};
-            break;
-
-        case MOVE_D:
-        case MOVE_D2:
-        case MOVE_DP:
-            corners_moved = {CORNER_DFR, CORNER_DRB, CORNER_DBL, CORNER_DLF};
-            edges_moved   = {EDGE_DF, EDGE_DR, EDGE_DB, EDGE_DL};
-            corner_twist  = {TWIST_NONE, TWIST_NONE, TWIST_NONE, TWIST_NONE};
-            edge_flip     = {FLIP_NONE, FLIP_NONE, FLIP_NONE, FLIP_NONE};
-            break;
-    }
-
-    // Work out how far the face has been turned in the clockwise direction
-    int turn_amt;
-    switch (move)
-    {
-        case MOVE_U:
-        case MOVE_L:
-        case MOVE_F:
-        case MOVE_R:
-        case MOVE_B:
-        case MOVE_D:
-            turn_amt = 1;
-            break;
-        case MOVE_U2:
-        case MOVE_L2:
-        case MOVE_F2:
-        case MOVE_R2:
-        case MOVE_B2:
-        case MOVE_D2:
-            turn_amt = 2;
-            break;
-        case MOVE_UP:
-        case MOVE_LP:
-        case MOVE_FP:
-        case MOVE_RP:
-        case MOVE_BP:
-        case MOVE_DP:
-            turn_amt = 3;
-            break;
-    }
-
-    // Update the corner permutation and orientation
-    for (int ii = 0; ii < corners_moved.size(); ++ii)
-    {
-        // Permute the corners according to how far we turned the face
-        int from = corners_moved[ii];
-        int to   = corners_moved[(ii + turn_amt) % corners_moved.size()];
-        new_corner_permutation[to] = corner_permutation[from];
-
-        // Calculate the total twist for this corner piece and update it
-        int twist = 0;
-        for (int jj = 0; jj < turn_amt; ++jj)
+* Operation: Copies this cube and applies the move to the copy in place.
+******************************************************************************/
+Cube Cube::perform_move(int move) const
+{
+    Cube cube = *this;
+    cube.apply_move(move);
+    return cube;
+}
+
+/******************************************************************************
+* Function:  Cube::apply_move
+*
+* Purpose:   Performs a move on this Cube object in place.
+*
+* Params:    move - which move is being performed.
+*
+* Returns:   Nothing.
+*
+* Operation: Looks up where each piece comes from in the precomputed move
+*            tables and adds on the twist or flip picked up along the way.
+******************************************************************************/
+void Cube::apply_move(int move)
+{
+    const uint8_t* cp = cubie_moves.cp[move];
+    const uint8_t* co = cubie_moves.co[move];
+    const uint8_t* ep = cubie_moves.ep[move];
+    const uint8_t* eo = cubie_moves.eo[move];
+
+    std::array<uint8_t, 8>  old_cp = corner_permutation;
+    std::array<uint8_t, 8>  old_co = corner_orientation;
+    std::array<uint8_t, 12> old_ep = edge_permutation;
+    std::array<uint8_t, 12> old_eo = edge_orientation;
+
+    for (int ii = 0; ii < 8; ++ii)
+    {
+        corner_permutation[ii] = old_cp[cp[ii]];
+        corner_orientation[ii] = twist_sum[old_co[cp[ii]]][co[ii]];
+    }
+    for (int ii = 0; ii < 12; ++ii)
+    {
+        edge_permutation[ii] = old_ep[ep[ii]];
+        edge_orientation[ii] = old_eo[ep[ii]] ^ eo[ii];
+    }
+}
+
+/******************************************************************************
+* Function:  Cube::multiply
+*
+* Purpose:   Composes this cube with another.
+*
+* Params:    other - The cube whose permutation is applied after this one.
+*
+* Returns:   The cube reached by starting from this cube's state and then
+*            performing whatever sequence of moves takes the solved cube to
+*            other's state.
+*
+* Operation: The piece which ends up in position i is the piece this cube has
+*            at the position other takes i from, and its orientation is the
+*            sum of both orientations. Either cube may be a mirror symmetry,
+*            so corner twists are combined with the full twist_product table.
+******************************************************************************/
+Cube Cube::multiply(const Cube& other) const
+{
+    Cube cube;
+    for (int ii = 0; ii < 8; ++ii)
+    {
+        int from = other.corner_permutation[ii];
+        cube.corner_permutation[ii] = corner_permutation[from];
+        cube.corner_orientation[ii] =
+         twist_product[corner_orientation[from]][other.corner_orientation[ii]];
+    }
+    for (int ii = 0; ii < 12; ++ii)
+    {
+        int from = other.edge_permutation[ii];
+        cube.edge_permutation[ii] = edge_permutation[from];
+        cube.edge_orientation[ii] = edge_orientation[from] ^
+                                    other.edge_orientation[ii];
+    }
+    return cube;
+}
+
+/******************************************************************************
+* Function:  Cube::inverse
+*
+* Purpose:   Calculates the inverse of this cube.
+*
+* Params:    None.
+*
+* Returns:   The cube which, multiplied by this one, gives the solved cube.
+*            Its solutions are the solutions of this cube reversed, with each
+*            move undone.
+*
+* Operation: The piece this cube takes from position from to position i is
+*            taken back from i to from, and its twist or flip is undone.
+******************************************************************************/
+Cube Cube::inverse() const
+{
+    Cube cube;
+    for (int ii = 0; ii < 8; ++ii)
+    {
+        int from = corner_permutation[ii];
+        cube.corner_permutation[from] = ii;
+        cube.corner_orientation[from] = (3 - corner_orientation[ii]) % 3;
+    }
+    for (int ii = 0; ii < 12; ++ii)
+    {
+        int from = edge_permutation[ii];
+        cube.edge_permutation[from] = ii;
+        cube.edge_orientation[from] = edge_orientation[ii];
+    }
+    return cube;
+}
+
+/******************************************************************************
+* Function:  Cube::operator==
+*
+* Purpose:   Compares two cubes.
+*
+* Params:    other - The cube to compare against.
+*
+* Returns:   true if every piece is in the same place with the same
+*            orientation in both cubes.
+*
+* Operation: Compares the four state arrays.
+******************************************************************************/
+bool Cube::operator==(const Cube& other) const
+{
+    return corner_permutation == other.corner_permutation &&
+           corner_orientation == other.corner_orientation &&
+           edge_permutation == other.edge_permutation &&
+           edge_orientation == other.edge_orientation;
+}
+
+/******************************************************************************
+* Functions which set part of the cube state from a coordinate value. These
+* are the inverses of the corresponding coord_ functions, and leave the rest
+* of the state untouched.
+******************************************************************************/
+
+/******************************************************************************
+* Function:  Cube::set_corner_orientation
+*
+* Purpose:   Twists the corners to match a corner orientation coordinate.
+*
+* Params:    coord - A corner orientation coordinate in the range 0..2186.
+*
+* Returns:   Nothing.
+*
+* Operation: Reads off the base-3 digits of the coordinate, last corner
+*            first, and gives the eighth corner whatever twist makes the
+*            total a multiple of three.
+******************************************************************************/
+void Cube::set_corner_orientation(int coord)
+{
+    int sum = 0;
+    for (int ii = corner_orientation.size() - 2; ii >= 0; --ii)
+    {
+        corner_orientation[ii] = coord % 3;
+        sum += coord % 3;
+        coord /= 3;
+    }
+    corner_orientation[corner_orientation.size() - 1] = (3 - sum % 3) % 3;
+}
+
+/******************************************************************************
+* Function:  Cube::set_edge_orientation
+*
+* Purpose:   Flips the edges to match an edge orientation coordinate.
+*
+* Params:    coord - An edge orientation coordinate in the range 0..2047.
+*
+* Returns:   Nothing.
+*
+* Operation: Reads off the binary digits of the coordinate, last edge first,
+*            and gives the twelfth edge whatever flip makes the total even.
+******************************************************************************/
+void Cube::set_edge_orientation(int coord)
+{
+    int sum = 0;
+    for (int ii = edge_orientation.size() - 2; ii >= 0; --ii)
+    {
+        edge_orientation[ii] = coord & 1;
+        sum += coord & 1;
+        coord >>= 1;
+    }
+    edge_orientation[edge_orientation.size() - 1] = sum & 1;
+}
+
+/******************************************************************************
+* Function:  Cube::set_ud_unsorted
+*
+* Purpose:   Moves the edges so that the UD-slice edges occupy the positions
+*            described by an unsorted UD-slice coordinate.
+*
+* Params:    coord - An unsorted UD-slice coordinate in the range 0..494.
+*
+* Returns:   Nothing.
+*
+* Operation: Decodes the rank computed by coord_slice_sorted, taking positions
+*            from the highest down, and fills the slice positions with the
+*            slice edges and the rest with the other edges, in order.
+******************************************************************************/
+void Cube::set_ud_unsorted(int coord)
+{
+    int slice_edge = EDGE_FR;
+    int other_edge = EDGE_UF;
+    int k = 4;
+
+    for (int n = edge_permutation.size() - 1; n >= 0; --n)
+    {
+        if (k > 0 && coord >= binom(n, k))
         {
-            twist += corner_twist[(ii + jj) % corners_moved.size()];
+            coord -= binom(n, k--);
+            edge_permutation[n] = slice_edge++;
+        }
+        else
+        {
+            edge_permutation[n] = other_edge++;
         }
-        new_corner_orientation[to] = (corner_orientation[from] + twist) % 3;
     }
+}
 
-    // Update the edge permutation and orientation
-    for (int ii = 0; ii < edges_moved.size(); ++ii)
+/******************************************************************************
+* Function:  Cube::set_flipslice
+*
+* Purpose:   Flips and moves the edges to match a flipslice coordinate.
+*
+* Params:    coord - A flipslice coordinate in the range 0..1013759.
+*
+* Returns:   Nothing.
+*
+* Operation: Splits the coordinate into its unsorted UD-slice and edge
+*            orientation parts, as computed by coord_flipslice.
+******************************************************************************/
+void Cube::set_flipslice(int coord)
+{
+    set_ud_unsorted(coord / 2048);
+    set_edge_orientation(coord % 2048);
+}
+
+/******************************************************************************
+* Function:  Cube::set_corner_permutation
+*
+* Purpose:   Moves the corners to match a corner permutation coordinate.
+*
+* Params:    coord - A corner permutation coordinate in the range 0..40319.
+*
+* Returns:   Nothing.
+*
+* Operation: The coordinate has one digit per corner, in a factorial number
+*            system, counting how many of the corners after it are lower. Each
+*            digit therefore picks a corner out of those not yet placed,
+*            counting up from the lowest.
+******************************************************************************/
+void Cube::set_corner_permutation(int coord)
+{
+    static const int factorial[8] = {5040, 720, 120, 24, 6, 2, 1, 1};
+    uint8_t remaining[8] = {0, 1, 2, 3, 4, 5, 6, 7};
+    int count = 8;
+
+    for (int ii = 0; ii < 8; ++ii)
+    {
+        int pick = (coord / factorial[ii]) % (8 - ii);
+        corner_permutation[ii] = remaining[pick];
+        for (int jj = pick; jj < count - 1; ++jj)
+        {
+            remaining[jj] = remaining[jj + 1];
+        }
+        --count;
+    }
+}
+
+/******************************************************************************
+* Function:  Cube::set_slice_sorted
+*
+* Purpose:   Moves the edges to match a sorted slice coordinate.
+*
+* Params:    slice_mask - The edges of the slice.
+*            coord      - A sorted slice coordinate in the range 0..11879.
+*
+* Returns:   Nothing.
+*
+* Operation: Decodes the positions and order of the slice edges as computed
+*            by coord_slice_sorted, then fills the remaining positions with
+*            the other edges, the lowest edge in the lowest position.
+******************************************************************************/
+void Cube::set_slice_sorted(int slice_mask, int coord)
+{
+    int pos_rank = coord / 24;
+    int order[4];
+    slice_order(slice_mask, coord % 24, order);
+
+    int found = 0;
+    int other_slots = 0;
+    int k = 4;
+    for (int n = edge_permutation.size() - 1; n >= 0; --n)
     {
-        // Permute the edges according to how far we turned the face
-        int from = edges_moved[ii];
-        int to   = edges_moved[(ii + turn_amt) % edges_moved.size()];
-        new_edge_permutation[to] = edge_permutation[from];
+        if (k > 0 && pos_rank >= binom(n, k))
+        {
+            pos_rank -= binom(n, k--);
+            edge_permutation[n] = order[found++];
+        }
+        else
+        {
+            other_slots |= 1 << n;
+        }
+    }
 
-        // Calculate the total flip for this edge piece and update it
-        int flip = 0;
-        for (int jj = 0; jj < turn_amt; ++jj)
+    int next_edge = 0;
+    for (int n = 0; n < (int)edge_permutation.size(); ++n)
+    {
+        if ((other_slots >> n) & 1)
         {
-            flip += edge_flip[(ii + jj) % edges_moved.size()];
+            while ((slice_mask >> next_edge) & 1)
+            {
+                ++next_edge;
+            }
+            edge_permutation[n] = next_edge++;
         }
-        new_edge_orientation[to] = (edge_orientation[from] + flip) % 2;
     }
+}
 
-    // Return a Cube with the new permutations and orientations.
-    Cube cube(new_corner_permutation, new_corner_orientation,
-                new_edge_permutation,   new_edge_orientation);
-    return cube;
+/******************************************************************************
+* Function:  Cube::set_ud_sorted, set_rl_sorted, set_fb_sorted
+*
+* Purpose:   Moves the edges to match a sorted slice coordinate.
+*
+* Params:    coord - A sorted slice coordinate in the range 0..11879.
+*
+* Returns:   Nothing.
+*
+* Operation: Calls into set_slice_sorted with the edges of the slice.
+******************************************************************************/
+void Cube::set_ud_sorted(int coord)
+{
+    set_slice_sorted(ud_slice_mask, coord);
+}
+
+void Cube::set_rl_sorted(int coord)
+{
+    set_slice_sorted(rl_slice_mask, coord);
+}
+
+void Cube::set_fb_sorted(int coord)
+{
+    set_slice_sorted(fb_slice_mask, coord);
+}
+
+/******************************************************************************
+* Function:  Cube::set_edge_permutation
+*
+* Purpose:   Moves the edges to match an edge permutation coordinate, with the
+*            UD-slice edges in their home positions.
+*
+* Params:    coord - An edge permutation coordinate in the range 0..40319.
+*
+* Returns:   Nothing.
+*
+* Operation: Places the RL-slice edges by their sorted coordinate. This puts
+*            the FB-slice edges, which are the next lowest, in the four U and D
+*            positions left over, and the UD-slice edges at home. The FB-slice
+*            edges are then reordered to match the rest of the coordinate.
+******************************************************************************/
+void Cube::set_edge_permutation(int coord)
+{
+    set_slice_sorted(rl_slice_mask, coord / 24);
+
+    int order[4];
+    slice_order(fb_slice_mask, coord % 24, order);
+    int found = 0;
+    for (int n = edge_permutation.size() - 1; n >= 0; --n)
+    {
+        if ((fb_slice_mask >> edge_permutation[n]) & 1)
+        {
+            edge_permutation[n] = order[found++];
+        }
+    }
+}
+
+/******************************************************************************
+* Function:  Cube::set_ud_permutation
+*
+* Purpose:   Moves the UD-slice edges to match a UD-slice permutation
+*            coordinate, with all four in the UD slice.
+*
+* Params:    coord - A UD-slice permutation coordinate in the range 0..23.
+*
+* Returns:   Nothing.
+*
+* Operation: The UD-slice positions are the highest four, so they have the
+*            highest position rank, and the coordinate is the order within
+*            them.
+******************************************************************************/
+void Cube::set_ud_permutation(int coord)
+{
+    set_slice_sorted(ud_slice_mask, 24 * (binom(12, 4) - 1) + coord);
 }
 
 /******************************************************************************
@@ -286,7 +1106,7 @@ Cube Cube::perform_move(int move)
 *            combining the twist of each individual corner piece into a single
 *            integer result using a ternary encoding.
 ******************************************************************************/
-int Cube::coord_corner_orientation()
+int Cube::coord_corner_orientation() const
 {
     // Interpret the corner orientation vector as a base-3 number to get the
     // value of this coordinate. Ignore the last entry, since it is determined
@@ -315,7 +1135,7 @@ int Cube::coord_corner_orientation()
 *            combining the flip of each individual corner piece into a single
 *            integer result using a binary encoding.
 ******************************************************************************/
-int Cube::coord_edge_orientation()
+int Cube::coord_edge_orientation() const
 {
     // Interpret the edge orientation vector as a base-2 number to get the
     // value of this coordinate. Ignore the last entry, since it is determined
@@ -344,27 +1164,20 @@ int Cube::coord_edge_orientation()
 *            working out the lexicographic position of the vector which
 *            represents the corner permutation.
 ******************************************************************************/
-int Cube::coord_corner_permutation()
+int Cube::coord_corner_permutation() const
 {
-    // Local variable to keep track of value of factorials
-    int factorial = 1;
-
-    // Calculate the lexicographic position of the permutation represented by
-    // the vector corner_permutation - for each element of the permutation,
-    // work out how many elements following it have a lower value, and use
-    // these numbers as the coefficients of some factorials.
+    // For each corner, count how many of the corners after it have a lower
+    // value, and use these counts as the coefficients of some factorials.
+    // The corners already passed are kept as a bit mask, so each count is a
+    // single population count.
     int ret = 0;
+    int factorial = 1;
+    int seen = 0;
     for (int ii = corner_permutation.size() - 1; ii >= 0; --ii)
     {
-        int low_count = 0;
-        for (int jj = ii + 1; jj < corner_permutation.size(); ++jj)
-        {
-            if (corner_permutation[jj] < corner_permutation[ii])
-            {
-                ++low_count;
-            }
-        }
-        ret += low_count * factorial;
+        int corner = corner_permutation[ii];
+        ret += __builtin_popcount(seen & ((1 << corner) - 1)) * factorial;
+        seen |= 1 << corner;
         factorial *= corner_permutation.size() - ii;
     }
     return ret;
@@ -376,7 +1189,8 @@ int Cube::coord_corner_permutation()
 * Purpose:   Given a particular slice of edges, extract the associated sorted
 *            slice coordinate from the current cube position.
 *
-* Params:    None.
+* Params:    slice_mask - The edges of the slice, as a bit mask of edge
+*                         numbers.
 *
 * Returns:   The value of the sorted slice coordinate. This coordinate is a
 *            number in the range 0..11879 which describes the positions (order
@@ -385,53 +1199,21 @@ int Cube::coord_corner_permutation()
 * Operation: Calculates the lexicographic position x of the set of 4 positions
 *            occupied by the four slice edges, and also the lexicographic
 *            position y of the permutation of these 4 edges among themselves,
-*            and calculates the coordinate as 24x + y.
+*            and calculates the coordinate as 24x + y. Both are built up in a
+*            single walk up the positions by SliceRank.
 ******************************************************************************/
-int Cube::coord_slice_sorted(std::vector<int> edges)
+int Cube::coord_slice_sorted(int slice_mask) const
 {
-    // Local variables n, k.
-    int n = edge_permutation.size();
-    int k = edges.size();
-
-    // The order in which the edges making up this slice appear in the current
-    // cube position.
-    std::vector<int> order = {};
-
-    // Calculate the lexicographic rank of the four positions occupied by
-    // the slice edges.
-    int pos_rank = 0;
-
-    while (n-- > 0)
+    SliceRank rank;
+    for (int n = 0; n < (int)edge_permutation.size(); ++n)
     {
         int curr_edge = edge_permutation[n];
-        if (std::find(edges.begin(), edges.end(), curr_edge) != edges.end())
-        {
-            // We've found one of the slice edges, so update the rank and note
-            // the order in which we found this edge.
-            pos_rank += binom(n, k--);
-            order.push_back(curr_edge);
-        }
-    }
-
-    // Now calculate the lexicographic rank of the permutation of the four
-    // edges among themselves
-    int perm_rank = 0; int factorial = 1;
-    for (int ii = order.size() - 1; ii >= 0; --ii)
-    {
-        int high_count = 0;
-        for (int jj = ii + 1; jj < order.size(); ++jj)
+        if ((slice_mask >> curr_edge) & 1)
         {
-            if (order[jj] > order[ii])
-            {
-                ++high_count;
-            }
+            rank.add(n, curr_edge);
         }
-        perm_rank += high_count * factorial;
-        factorial *= (order.size() - ii);
     }
-
-    // Return the combination of these two data which makes the coordinate
-    return 24 * pos_rank + perm_rank;
+    return rank.coord();
 }
 
 /******************************************************************************
@@ -446,13 +1228,12 @@ int Cube::coord_slice_sorted(std::vector<int> edges)
 *            number in the range 0..11879 which describes the positions (order
 *            matters) of the 4 edges belonging in the UD slice.
 *
-* Operation: Calls into coord_slice_sorted with a specific set of edges for
+* Operation: Calls into coord_slice_sorted with the set of edges for
 *            the UD-slice.
 ******************************************************************************/
-int Cube::coord_ud_sorted()
+int Cube::coord_ud_sorted() const
 {
-    std::vector<int> edges = {EDGE_FR, EDGE_FL, EDGE_BL, EDGE_BR};
-    return coord_slice_sorted(edges);
+    return coord_slice_sorted(ud_slice_mask);
 }
 
 /******************************************************************************
@@ -467,13 +1248,12 @@ int Cube::coord_ud_sorted()
 *            number in the range 0..11879 which describes the positions (order
 *            matters) of the 4 edges belonging in the RL slice.
 *
-* Operation: Calls into coord_slice_sorted with a specific set of edges for
+* Operation: Calls into coord_slice_sorted with the set of edges for
 *            the RL-slice.
 ******************************************************************************/
-int Cube::coord_rl_sorted()
+int Cube::coord_rl_sorted() const
 {
-    std::vector<int> edges = {EDGE_UF, EDGE_UB, EDGE_DB, EDGE_DF};
-    return coord_slice_sorted(edges);
+    return coord_slice_sorted(rl_slice_mask);
 }
 
 /******************************************************************************
@@ -488,13 +1268,12 @@ int Cube::coord_rl_sorted()
 *            number in the range 0..11879 which describes the positions (order
 *            matters) of the 4 edges belonging in the FB slice.
 *
-* Operation: Calls into coord_slice_sorted with a specific set of edges for
+* Operation: Calls into coord_slice_sorted with the set of edges for
 *            the FB-slice.
 ******************************************************************************/
-int Cube::coord_fb_sorted()
+int Cube::coord_fb_sorted() const
 {
-    std::vector<int> edges = {EDGE_UR, EDGE_UL, EDGE_DL, EDGE_DR};
-    return coord_slice_sorted(edges);
+    return coord_slice_sorted(fb_slice_mask);
 }
 
 /******************************************************************************
@@ -589,7 +1368,7 @@ int Cube::ud_permutation_calc(int ud_sorted)
 *            where x is the sorted RL-slice coordinate, and y is the sorted
 *            FB-slice coordinate.
 ******************************************************************************/
-int Cube::coord_edge_permutation()
+int Cube::coord_edge_permutation() const
 {
     return edge_permutation_calc(coord_rl_sorted(), coord_fb_sorted());
 }
@@ -610,7 +1389,7 @@ int Cube::coord_edge_permutation()
 * Operation: Calculates the unsorted UD-slice coordinate as x / 24, where x is
 *            the value of the sorted UD-slice coordinate.
 ******************************************************************************/
-int Cube::coord_ud_unsorted()
+int Cube::coord_ud_unsorted() const
 {
     return ud_unsorted_calc(coord_ud_sorted());
 }
@@ -631,7 +1410,63 @@ int Cube::coord_ud_unsorted()
 * Operation: Calculates the UD-slice permutation coordinate as x % 24, where x
 *            is the sorted UD-slice coordinate.
 ******************************************************************************/
-int Cube::coord_ud_permutation()
+int Cube::coord_ud_permutation() const
 {
     return ud_permutation_calc(coord_ud_sorted());
-}
\ No newline at end of file
+}
+
+/******************************************************************************
+* Function:  Cube::coord_flipslice
+*
+* Purpose:   Calculates the flipslice coordinate from the current cube
+*            position.
+*
+* Params:    None.
+*
+* Returns:   The value of the flipslice coordinate. This coordinate is an
+*            integer in the range 0..1013759 which combines the edge
+*            orientation and the unsorted UD-slice coordinates, which are
+*            mixed together by the symmetries of the cube.
+*
+* Operation: Calculates the flipslice coordinate as 2048 * x + y, where x is
+*            the unsorted UD-slice coordinate and y is the edge orientation
+*            coordinate.
+******************************************************************************/
+int Cube::coord_flipslice() const
+{
+    return 2048 * coord_ud_unsorted() + coord_edge_orientation();
+}
+
+/******************************************************************************
+* Function:  Cube::coords
+*
+* Purpose:   Calculates all of the normal coordinates of the current cube
+*            position at once.
+*
+* Params:    None.
+*
+* Returns:   The coordinates, as returned by the coord_* functions.
+*
+* Operation: The orientation and corner permutation coordinates are found as
+*            usual. The three sorted slice coordinates share a single walk up
+*            the edge positions, each edge being added to the rank of the
+*            slice it belongs to.
+******************************************************************************/
+CubeCoords Cube::coords() const
+{
+    SliceRank slices[NUM_SLICES];
+    for (int n = 0; n < (int)edge_permutation.size(); ++n)
+    {
+        int curr_edge = edge_permutation[n];
+        slices[edge_slice[curr_edge]].add(n, curr_edge);
+    }
+
+    CubeCoords ret;
+    ret.corner_orientation = coord_corner_orientation();
+    ret.edge_orientation = coord_edge_orientation();
+    ret.corner_permutation = coord_corner_permutation();
+    ret.ud_sorted = slices[SLICE_UD].coord();
+    ret.rl_sorted = slices[SLICE_RL].coord();
+    ret.fb_sorted = slices[SLICE_FB].coord();
+    return ret;
+}
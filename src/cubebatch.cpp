@@ -0,0 +1,354 @@
+/******************************************************************************
+* File:    cubebatch.cpp
+*
+* Purpose: Implementation of the batched pruning kernels and of the run time
+*          selection between them.
+******************************************************************************/
+
+/******************************************************************************
+* Dependencies
+******************************************************************************/
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+
+#include <cube.h>
+#include <cubebatch.h>
+#include <cubeprune.h>
+#include <cubetables.h>
+#include <cubetrans.h>
+
+#if (defined(__x86_64__) || defined(__i386__)) && \
+    (defined(__GNUC__) || defined(__clang__))
+#define CUBE_BATCH_X86
+#include <immintrin.h>
+#endif
+
+static_assert(NUM_MOVES > 16 && NUM_MOVES <= 32,
+              "The kernels handle moves in two vectors of eight and a tail");
+
+/******************************************************************************
+* Scalar kernel
+******************************************************************************/
+
+/******************************************************************************
+* Function:  p1_bound
+*
+* Purpose:   Looks up the pairwise phase 1 bound of one position.
+*
+* Params:    tables - The tables to look in.
+*            co     - The corner orientation coordinate of the position.
+*            eo     - The edge orientation coordinate of the position.
+*            ud_pos - The unsorted UD-slice coordinate of the position.
+*
+* Returns:   The largest of the three pairwise pruning values.
+*
+* Operation: Three table lookups.
+******************************************************************************/
+static inline int p1_bound(const SolverTables& tables, int co, int eo,
+                           int ud_pos)
+{
+    int bound = tables.co_eo_prune(co, eo);
+    bound = std::max(bound, tables.co_ud_prune(co, ud_pos));
+    return std::max(bound, tables.eo_ud_prune(eo, ud_pos));
+}
+
+/******************************************************************************
+* Function:  p1_survivors_scalar
+*
+* Purpose:   The portable phase 1 survivors function; see CubeP1Survivors.
+*
+* Params:    tables - The tables to look in.
+*            co     - The phase 1 coordinates of the node.
+*            eo
+*            ud_pos
+*            depth  - The number of moves left after the child's move.
+*
+* Returns:   The mask of moves whose children are not pruned.
+*
+* Operation: Reads the three transition rows of the node and looks up each
+*            child in turn.
+******************************************************************************/
+static uint32_t p1_survivors_scalar(const SolverTables& tables, int co,
+                                    int eo, int ud_pos, int depth)
+{
+    const uint16_t* co_row = tables.co_trans.row(co);
+    const uint16_t* eo_row = tables.eo_trans.row(eo);
+    const uint16_t* ud_row = tables.ud_unsorted_trans.row(ud_pos);
+    uint32_t survivors = 0;
+
+    for (int move = 0; move < NUM_MOVES; ++move)
+    {
+        if (p1_bound(tables, co_row[move], eo_row[move], ud_row[move]) <=
+            depth)
+        {
+            survivors |= 1u << move;
+        }
+    }
+    return survivors;
+}
+
+/******************************************************************************
+* AVX2 kernel
+******************************************************************************/
+#ifdef CUBE_BATCH_X86
+
+/******************************************************************************
+* Function:  gather_nibbles
+*
+* Purpose:   Looks up eight entries of a packed pruning table.
+*
+* Params:    table - The packed entries, whose storage is padded to a whole
+*                    number of 32-bit words.
+*            index - The flat index of each entry.
+*
+* Returns:   The entries, one per 32-bit lane.
+*
+* Operation: Entry i is in the aligned word i / 8, at bit 4 * (i % 8), since
+*            the even entry of each byte is in its low nibble. Reading whole
+*            aligned words never strays past the padded storage.
+******************************************************************************/
+__attribute__((target("avx2")))
+static inline __m256i gather_nibbles(const uint8_t* table, __m256i index)
+{
+    __m256i words = _mm256_i32gather_epi32((const int*)table,
+                                           _mm256_srli_epi32(index, 3), 4);
+    __m256i shift = _mm256_slli_epi32(
+                        _mm256_and_si256(index, _mm256_set1_epi32(7)), 2);
+    return _mm256_and_si256(_mm256_srlv_epi32(words, shift),
+                            _mm256_set1_epi32(0xF));
+}
+
+/******************************************************************************
+* Function:  load_row
+*
+* Purpose:   Loads eight entries of a transition row.
+*
+* Params:    row - The first of the entries.
+*
+* Returns:   The entries, widened to one per 32-bit lane.
+*
+* Operation: A single unaligned 128-bit load.
+******************************************************************************/
+__attribute__((target("avx2")))
+static inline __m256i load_row(const uint16_t* row)
+{
+    return _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i*)row));
+}
+
+/******************************************************************************
+* Function:  p1_survivors_avx2
+*
+* Purpose:   The AVX2 phase 1 survivors function; see CubeP1Survivors.
+*
+* Params:    tables - The tables to look in.
+*            co     - The phase 1 coordinates of the node.
+*            eo
+*            ud_pos
+*            depth  - The number of moves left after the child's move.
+*
+* Returns:   The mask of moves whose children are not pruned.
+*
+* Operation: Handles the children of the first sixteen moves eight at a
+*            time: one load of each transition row gives their coordinates,
+*            and one gather from each pruning table gives their bounds. The
+*            last few moves are looked up one at a time, so that no load
+*            reads past the end of a row.
+******************************************************************************/
+__attribute__((target("avx2")))
+static uint32_t p1_survivors_avx2(const SolverTables& tables, int co, int eo,
+                                  int ud_pos, int depth)
+{
+    const uint16_t* co_row = tables.co_trans.row(co);
+    const uint16_t* eo_row = tables.eo_trans.row(eo);
+    const uint16_t* ud_row = tables.ud_unsorted_trans.row(ud_pos);
+
+    const __m256i limit = _mm256_set1_epi32(depth);
+    const __m256i co_eo_cols =
+                          _mm256_set1_epi32(tables.co_eo_prune.columns());
+    const __m256i co_ud_cols =
+                          _mm256_set1_epi32(tables.co_ud_prune.columns());
+    const __m256i eo_ud_cols =
+                          _mm256_set1_epi32(tables.eo_ud_prune.columns());
+    uint32_t survivors = 0;
+
+    for (int first = 0; first < 16; first += 8)
+    {
+        __m256i next_co = load_row(co_row + first);
+        __m256i next_eo = load_row(eo_row + first);
+        __m256i next_ud = load_row(ud_row + first);
+
+        __m256i bound = gather_nibbles(tables.co_eo_prune.data(),
+            _mm256_add_epi32(_mm256_mullo_epi32(next_co, co_eo_cols),
+                             next_eo));
+        bound = _mm256_max_epi32(bound, gather_nibbles(
+            tables.co_ud_prune.data(),
+            _mm256_add_epi32(_mm256_mullo_epi32(next_co, co_ud_cols),
+                             next_ud)));
+        bound = _mm256_max_epi32(bound, gather_nibbles(
+            tables.eo_ud_prune.data(),
+            _mm256_add_epi32(_mm256_mullo_epi32(next_eo, eo_ud_cols),
+                             next_ud)));
+
+        __m256i pruned = _mm256_cmpgt_epi32(bound, limit);
+        uint32_t kept = ~_mm256_movemask_ps(_mm256_castsi256_ps(pruned));
+        survivors |= (kept & 0xFF) << first;
+    }
+
+    for (int move = 16; move < NUM_MOVES; ++move)
+    {
+        if (p1_bound(tables, co_row[move], eo_row[move], ud_row[move]) <=
+            depth)
+        {
+            survivors |= 1u << move;
+        }
+    }
+    return survivors;
+}
+
+#endif
+
+/******************************************************************************
+* Kernel selection
+******************************************************************************/
+
+/******************************************************************************
+* Function:  best_kernel
+*
+* Purpose:   Chooses the fastest kernel which this processor supports.
+*
+* Params:    None.
+*
+* Returns:   The kernel.
+*
+* Operation: Tries the kernels from fastest to slowest.
+******************************************************************************/
+static CubeBatchKernel best_kernel()
+{
+    return cube_batch_supported(BATCH_AVX2) ? BATCH_AVX2 : BATCH_SCALAR;
+}
+
+/******************************************************************************
+* Function:  selected_kernel
+*
+* Purpose:   Gives the stored kernel choice.
+*
+* Params:    None.
+*
+* Returns:   The choice, which starts as the fastest supported kernel.
+*
+* Operation: Initialised on first use rather than at load time, so that the
+*            choice is ready however early it is asked for.
+******************************************************************************/
+static std::atomic<int>& selected_kernel()
+{
+    static std::atomic<int> kernel(best_kernel());
+    return kernel;
+}
+
+/******************************************************************************
+* Function:  cube_batch_supported
+*
+* Purpose:   Checks whether a kernel can run on this processor.
+*
+* Params:    kernel - The kernel to check.
+*
+* Returns:   true if the kernel was built into the library and the processor
+*            and operating system support its instructions.
+*
+* Operation: Asks the compiler's processor feature detection, which also
+*            checks that the operating system saves the vector registers.
+******************************************************************************/
+bool cube_batch_supported(CubeBatchKernel kernel)
+{
+    switch (kernel)
+    {
+    case BATCH_SCALAR:
+        return true;
+#ifdef CUBE_BATCH_X86
+    case BATCH_AVX2:
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx2");
+#endif
+    default:
+        return false;
+    }
+}
+
+/******************************************************************************
+* Function:  cube_set_batch_kernel
+*
+* Purpose:   Chooses the kernel used by searches started from now on.
+*
+* Params:    kernel - The kernel to use.
+*
+* Returns:   true if the kernel is supported and is now in use, false if it
+*            is not, in which case the choice is unchanged.
+*
+* Operation: Stores the choice, which searches read when they start.
+******************************************************************************/
+bool cube_set_batch_kernel(CubeBatchKernel kernel)
+{
+    if (!cube_batch_supported(kernel))
+    {
+        return false;
+    }
+    selected_kernel() = kernel;
+    return true;
+}
+
+/******************************************************************************
+* Function:  cube_batch_kernel
+*
+* Purpose:   Gives the kernel in use.
+*
+* Params:    None.
+*
+* Returns:   The kernel used by searches started from now on.
+*
+* Operation: Simply return the stored choice.
+******************************************************************************/
+CubeBatchKernel cube_batch_kernel()
+{
+    return (CubeBatchKernel)selected_kernel().load();
+}
+
+/******************************************************************************
+* Function:  cube_batch_kernel_name
+*
+* Purpose:   Names a kernel, for reports.
+*
+* Params:    kernel - The kernel.
+*
+* Returns:   A short lower-case name.
+*
+* Operation: A fixed table of names.
+******************************************************************************/
+const char* cube_batch_kernel_name(CubeBatchKernel kernel)
+{
+    static const char* names[NUM_BATCH_KERNELS] = {"scalar", "avx2"};
+    return (kernel >= 0 && kernel < NUM_BATCH_KERNELS) ? names[kernel] : "";
+}
+
+/******************************************************************************
+* Function:  cube_p1_survivors
+*
+* Purpose:   Gives the phase 1 survivors function of the kernel in use.
+*
+* Params:    None.
+*
+* Returns:   The function.
+*
+* Operation: Looks up the stored choice. Only kernels which were built can
+*            have been chosen.
+******************************************************************************/
+CubeP1Survivors cube_p1_survivors()
+{
+#ifdef CUBE_BATCH_X86
+    if (cube_batch_kernel() == BATCH_AVX2)
+    {
+        return &p1_survivors_avx2;
+    }
+#endif
+    return &p1_survivors_scalar;
+}
@@ -0,0 +1,644 @@
+/******************************************************************************
+* File:    cubebench.cpp
+*
+* Purpose: Benchmark harness. Solves a seeded corpus of random cubes and times
+*          the basic cube operations and table builds, writing the results as
+*          JSON so that runs can be compared to track regressions.
+******************************************************************************/
+
+/******************************************************************************
+* Dependencies
+******************************************************************************/
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <cube.h>
+#include <cubebatch.h>
+#include <cubecorpus.h>
+#include <cubemem.h>
+#include <cubephase.h>
+#include <cubeprune.h>
+#include <cubesolver.h>
+#include <cubetables.h>
+#include <cubetrans.h>
+
+/******************************************************************************
+* Constants
+*
+* BENCH_CUBES       - The number of random cubes used by the microbenchmarks.
+* BENCH_ITERATIONS  - The number of operations timed by each microbenchmark.
+* BENCH_FAST_LENGTH - The length reported on by the time-to-length metric.
+******************************************************************************/
+#define BENCH_CUBES       64
+#define BENCH_ITERATIONS  4000000
+#define BENCH_FAST_LENGTH 20
+
+/******************************************************************************
+* The names of the kinds of table pages, as given to --pages and written to
+* the report, indexed by CubePages.
+******************************************************************************/
+#define NUM_BENCH_PAGES 3
+
+static const char* const bench_page_names[NUM_BENCH_PAGES] =
+                                            {"normal", "thp", "hugetlb"};
+
+/******************************************************************************
+* The settings for one benchmark run, taken from the command line.
+******************************************************************************/
+struct BenchConfig
+{
+    std::string tables_path = "cubetables.dat";
+    std::string output_path;
+    uint64_t seed = 1;
+    int cubes = 100;
+    long long node_limit = 5000000;
+    bool multi_axis = false;
+    bool full_phase1 = false;
+    bool full_phase2 = false;
+    CubeBatchKernel kernel = cube_batch_kernel();
+    CubePages pages = PAGES_NORMAL;
+    bool solve = true;
+    bool micro = true;
+};
+
+/******************************************************************************
+* Function:  seconds_since
+*
+* Purpose:   Measures elapsed time.
+*
+* Params:    start - When timing started.
+*
+* Returns:   The number of seconds since start.
+*
+* Operation: Uses the steady clock, which the solver also uses.
+******************************************************************************/
+static double seconds_since(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                         start).count();
+}
+
+/******************************************************************************
+* Function:  print_distribution
+*
+* Purpose:   Writes a summary of a set of measurements as a JSON object.
+*
+* Params:    name   - The key of the object.
+*            values - The measurements, which are sorted in place.
+*            total  - The number of cases measured, which is more than the
+*                     number of values if some cases produced no measurement.
+*            last   - Whether this is the last member of the enclosing object.
+*
+* Returns:   Nothing.
+*
+* Operation: Percentiles are taken by nearest rank. The count is the number of
+*            values, so that a metric only some cubes reach can be told apart
+*            from one they all reach.
+******************************************************************************/
+static void print_distribution(const char* name, std::vector<double>& values,
+                               size_t total, bool last)
+{
+    std::sort(values.begin(), values.end());
+
+    std::printf("    \"%s\": {\"count\": %zu, \"of\": %zu", name,
+                values.size(), total);
+    const double ranks[] = {0.5, 0.9, 0.99};
+    const char* labels[] = {"median", "p90", "p99"};
+    for (int ii = 0; ii < 3; ++ii)
+    {
+        if (values.empty())
+        {
+            std::printf(", \"%s\": null", labels[ii]);
+            continue;
+        }
+        size_t rank = (size_t)std::ceil(ranks[ii] * values.size());
+        std::printf(", \"%s\": %.6g", labels[ii],
+                    values[std::max<size_t>(rank, 1) - 1]);
+    }
+    std::printf("}%s\n", last ? "" : ",");
+}
+
+/******************************************************************************
+* Function:  print_counts
+*
+* Purpose:   Writes a by-depth statistics array as a JSON array.
+*
+* Params:    name   - The key of the array.
+*            values - The SOLVE_STATS_DEPTHS entries of the array.
+*
+* Returns:   Nothing.
+*
+* Operation: Trailing zero entries, for depths never reached, are left out.
+******************************************************************************/
+template <typename T>
+static void print_counts(const char* name, const T* values)
+{
+    int count = SOLVE_STATS_DEPTHS;
+    while (count > 0 && values[count - 1] == 0)
+    {
+        --count;
+    }
+
+    std::printf("      \"%s\": [", name);
+    for (int ii = 0; ii < count; ++ii)
+    {
+        std::printf("%s%.10g", (ii == 0) ? "" : ", ", (double)values[ii]);
+    }
+    std::printf("],\n");
+}
+
+/******************************************************************************
+* Function:  print_stats
+*
+* Purpose:   Writes the search statistics totalled over the corpus.
+*
+* Params:    stats - The statistics.
+*
+* Returns:   Nothing.
+*
+* Operation: Written as the last member of the solve object.
+******************************************************************************/
+static void print_stats(const SolveStats& stats)
+{
+    static const char* table_names[NUM_PRUNE_TABLES] =
+                     {"co_eo", "co_ud", "eo_ud", "phase1", "phase2", "cp_ud",
+                      "ep_ud"};
+
+    std::printf("    \"stats\": {\n");
+    print_counts("phase1_nodes", stats.phase1_nodes);
+    print_counts("phase2_nodes", stats.phase2_nodes);
+    print_counts("iteration_seconds", stats.iteration_seconds);
+    std::printf("      \"prunes\": {");
+    for (int ii = 0; ii < NUM_PRUNE_TABLES; ++ii)
+    {
+        std::printf("%s\"%s\": %lld", (ii == 0) ? "" : ", ", table_names[ii],
+                    stats.prunes[ii]);
+    }
+    std::printf("},\n");
+    std::printf("      \"phase1_leaves\": %lld,\n", stats.phase1_leaves);
+    std::printf("      \"phase2_searches\": %lld\n", stats.phase2_searches);
+    std::printf("    }\n");
+}
+
+/******************************************************************************
+* Function:  solve_bench
+*
+* Purpose:   Solves the benchmark corpus and reports on the solves.
+*
+* Params:    tables - The solver tables.
+*            config - The benchmark settings.
+*            last   - Whether this is the last member of the report.
+*
+* Returns:   Nothing.
+*
+* Operation: Each cube is solved under the node limit, and the times at which
+*            it first found a solution, first found one of BENCH_FAST_LENGTH
+*            moves or fewer and found its best solution are read from the
+*            record of improvements. If the library gathers search statistics
+*            their totals are reported too.
+******************************************************************************/
+static void solve_bench(const SolverTables& tables, const BenchConfig& config,
+                        bool last)
+{
+    std::vector<Cube> cubes = cube_scramble_corpus(config.seed, config.cubes);
+    std::vector<double> rate, first, fast, best, length;
+    long long total_nodes = 0;
+    double total_seconds = 0;
+    SolveStats total_stats;
+
+    // A multi-axis solve searches its orientations concurrently on one pool
+    // kept for the whole run.
+    SolveOptions options;
+    options.node_limit = config.node_limit;
+    options.multi_axis = config.multi_axis;
+    std::unique_ptr<CubeThreadPool> pool;
+    if (config.multi_axis)
+    {
+        pool.reset(new CubeThreadPool(SOLVE_ORIENTATIONS));
+        options.pool = pool.get();
+    }
+
+    for (size_t ii = 0; ii < cubes.size(); ++ii)
+    {
+        CubeSolver solver(tables, cubes[ii]);
+        auto start = std::chrono::steady_clock::now();
+        SolveResult result = solver.solve(options);
+        double seconds = seconds_since(start);
+
+        total_nodes += result.nodes;
+        total_seconds += seconds;
+        total_stats.add(result.stats);
+        rate.push_back(result.nodes / seconds);
+        std::fprintf(stderr, "\rSolved %zu of %zu", ii + 1, cubes.size());
+        if (result.improvements.empty())
+        {
+            continue;
+        }
+
+        first.push_back(result.improvements.front().seconds);
+        best.push_back(result.improvements.back().seconds);
+        length.push_back(result.length);
+        for (const SolveImprovement& improvement : result.improvements)
+        {
+            if (improvement.length <= BENCH_FAST_LENGTH)
+            {
+                fast.push_back(improvement.seconds);
+                break;
+            }
+        }
+    }
+    std::fprintf(stderr, "\n");
+
+    std::printf("  \"solve\": {\n");
+    std::printf("    \"nodes\": %lld,\n", total_nodes);
+    std::printf("    \"seconds\": %.6g,\n", total_seconds);
+    std::printf("    \"overall_nodes_per_sec\": %.6g,\n",
+                total_nodes / total_seconds);
+    print_distribution("nodes_per_sec", rate, cubes.size(), false);
+    print_distribution("length", length, cubes.size(), false);
+    print_distribution("time_to_first", first, cubes.size(), false);
+    char fast_name[32];
+    std::snprintf(fast_name, sizeof(fast_name), "time_to_%d",
+                  BENCH_FAST_LENGTH);
+    print_distribution(fast_name, fast, cubes.size(), false);
+    print_distribution("time_to_best", best, cubes.size(),
+                       !total_stats.enabled);
+    if (total_stats.enabled)
+    {
+        print_stats(total_stats);
+    }
+    std::printf("  }%s\n", last ? "" : ",");
+}
+
+/******************************************************************************
+* Function:  do_not_optimize
+*
+* Purpose:   Stops the compiler from removing the work behind a value.
+*
+* Params:    value - The value.
+*
+* Returns:   Nothing.
+*
+* Operation: An empty asm statement which claims to read the value and to
+*            touch memory, so the value must be computed, and computed
+*            before the statement. Other compilers store it to a volatile
+*            instead, which they cannot remove either.
+******************************************************************************/
+static void do_not_optimize(long long value)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : : "r"(value) : "memory");
+#else
+    static volatile long long sink;
+    sink = value;
+#endif
+}
+
+/******************************************************************************
+* Function:  time_per_op
+*
+* Purpose:   Times a microbenchmark.
+*
+* Params:    body - Performs the operation being timed, given the iteration
+*                   number, and returns a value that depends on its result.
+*
+* Returns:   The average time per operation in nanoseconds.
+*
+* Operation: The results are accumulated and passed to do_not_optimize, so
+*            that the compiler cannot remove the work being timed.
+******************************************************************************/
+template <typename Body>
+static double time_per_op(Body body)
+{
+    long long sum = 0;
+
+    auto start = std::chrono::steady_clock::now();
+    for (int ii = 0; ii < BENCH_ITERATIONS; ++ii)
+    {
+        sum += body(ii);
+    }
+    double seconds = seconds_since(start);
+    do_not_optimize(sum);
+
+    return seconds * 1e9 / BENCH_ITERATIONS;
+}
+
+/******************************************************************************
+* Function:  time_fill
+*
+* Purpose:   Times building a table.
+*
+* Params:    table - A table which has not been filled or loaded.
+*
+* Returns:   The time taken to fill it in milliseconds.
+*
+* Operation: Times a single call to fill, since the larger tables take far too
+*            long to repeat.
+******************************************************************************/
+template <typename Table>
+static double time_fill(Table& table)
+{
+    auto start = std::chrono::steady_clock::now();
+    table.fill();
+    return seconds_since(start) * 1e3;
+}
+
+/******************************************************************************
+* Function:  micro_bench
+*
+* Purpose:   Times the basic operations of the solver.
+*
+* Params:    tables - The solver tables.
+*
+* Returns:   Nothing.
+*
+* Operation: Moves and coordinates are timed over a small set of random cubes,
+*            with the moves chained so that each depends on the last. The
+*            transition table lookups are a chained random walk, measuring
+*            latency, while the pruning table lookups are at independent
+*            random positions, measuring throughput.
+******************************************************************************/
+static void micro_bench(const SolverTables& tables)
+{
+    std::vector<Cube> cubes = cube_scramble_corpus(0, BENCH_CUBES);
+    std::vector<uint8_t> moves(BENCH_ITERATIONS);
+    std::vector<int> coord_1(BENCH_ITERATIONS), coord_2(BENCH_ITERATIONS);
+    uint64_t state = 0;
+    for (int ii = 0; ii < BENCH_ITERATIONS; ++ii)
+    {
+        moves[ii] = (uint8_t)(cube_random_next(state) % NUM_MOVES);
+        coord_1[ii] = (int)(cube_random_next(state) % 2187);
+        coord_2[ii] = (int)(cube_random_next(state) % 2048);
+    }
+
+    std::printf("  \"micro\": {\n");
+
+    Cube cube = cubes[0];
+    std::printf("    \"perform_move_ns\": %.4g,\n", time_per_op([&](int ii)
+    {
+        cube = cube.perform_move(moves[ii]);
+        return cube.coord_corner_orientation() & 1;
+    }));
+    std::printf("    \"apply_move_ns\": %.4g,\n", time_per_op([&](int ii)
+    {
+        cube.apply_move(moves[ii]);
+        return cube.coord_corner_orientation() & 1;
+    }));
+
+    struct Coord
+    {
+        const char* name;
+        int (Cube::*func)() const;
+    };
+    const Coord coords[] =
+    {
+        {"coord_corner_orientation", &Cube::coord_corner_orientation},
+        {"coord_edge_orientation",   &Cube::coord_edge_orientation},
+        {"coord_corner_permutation", &Cube::coord_corner_permutation},
+        {"coord_ud_sorted",          &Cube::coord_ud_sorted},
+        {"coord_rl_sorted",          &Cube::coord_rl_sorted},
+        {"coord_fb_sorted",          &Cube::coord_fb_sorted},
+        {"coord_edge_permutation",   &Cube::coord_edge_permutation},
+        {"coord_ud_unsorted",        &Cube::coord_ud_unsorted},
+        {"coord_ud_permutation",     &Cube::coord_ud_permutation},
+        {"coord_flipslice",          &Cube::coord_flipslice}
+    };
+    for (const Coord& coord : coords)
+    {
+        std::printf("    \"%s_ns\": %.4g,\n", coord.name,
+                    time_per_op([&](int ii)
+        {
+            return (cubes[ii % BENCH_CUBES].*coord.func)();
+        }));
+    }
+    std::printf("    \"coords_ns\": %.4g,\n", time_per_op([&](int ii)
+    {
+        CubeCoords all = cubes[ii % BENCH_CUBES].coords();
+        return all.corner_permutation + all.ud_sorted + all.fb_sorted;
+    }));
+
+    int pos = tables.co_trans.solved_pos();
+    std::printf("    \"trans_lookup_ns\": %.4g,\n", time_per_op([&](int ii)
+    {
+        pos = tables.co_trans(pos, moves[ii]);
+        return pos;
+    }));
+    std::printf("    \"prune_lookup_ns\": %.4g,\n", time_per_op([&](int ii)
+    {
+        return tables.co_eo_prune(coord_1[ii], coord_2[ii]);
+    }));
+    CubeP1Survivors survivors = cube_p1_survivors();
+    std::printf("    \"p1_survivors_ns\": %.4g,\n", time_per_op([&](int ii)
+    {
+        return (int)survivors(tables, coord_1[ii], coord_2[ii],
+                              coord_1[ii] % 495, 8);
+    }));
+
+    CubeTrans co_trans(PHASE_1,
+                       CubeCoord<&Cube::coord_corner_orientation,
+                                 &Cube::set_corner_orientation>(), 2187);
+    CubeTrans ud_sorted_trans(PHASE_1,
+                              CubeCoord<&Cube::coord_ud_sorted,
+                                        &Cube::set_ud_sorted>(), 11880);
+    CubeTrans ep_trans(PHASE_2,
+                       CubeCoord<&Cube::coord_edge_permutation,
+                                 &Cube::set_edge_permutation>(), 40320);
+    std::printf("    \"trans_fill_ms\": {\"co\": %.4g, \"ud_sorted\": %.4g, "
+                "\"ep\": %.4g},\n", time_fill(co_trans),
+                time_fill(ud_sorted_trans), time_fill(ep_trans));
+
+    CubePrune co_eo_prune(PHASE_1, &tables.co_trans, &tables.eo_trans);
+    CubePrune cp_ud_prune(PHASE_2, &tables.cp_trans, &tables.ud_perm_trans);
+    std::printf("    \"prune_fill_ms\": {\"co_eo\": %.4g, \"cp_ud\": %.4g}\n",
+                time_fill(co_eo_prune), time_fill(cp_ud_prune));
+
+    std::printf("  }\n");
+}
+
+/******************************************************************************
+* Function:  parse_args
+*
+* Purpose:   Reads the benchmark settings from the command line.
+*
+* Params:    argc, argv - The command line.
+*            config     - Receives the settings.
+*
+* Returns:   false if the command line is not understood.
+*
+* Operation: Every option other than the flags takes one value.
+******************************************************************************/
+static bool parse_args(int argc, char** argv, BenchConfig& config)
+{
+    for (int ii = 1; ii < argc; ++ii)
+    {
+        const char* arg = argv[ii];
+        const char* value = (ii + 1 < argc) ? argv[ii + 1] : nullptr;
+
+        if (!std::strcmp(arg, "--multi-axis"))
+        {
+            config.multi_axis = true;
+        }
+        else if (!std::strcmp(arg, "--full-phase1"))
+        {
+            config.full_phase1 = true;
+        }
+        else if (!std::strcmp(arg, "--full-phase2"))
+        {
+            config.full_phase2 = true;
+        }
+        else if (!std::strcmp(arg, "--no-solve"))
+        {
+            config.solve = false;
+        }
+        else if (!std::strcmp(arg, "--no-micro"))
+        {
+            config.micro = false;
+        }
+        else if (value == nullptr)
+        {
+            return false;
+        }
+        else if (!std::strcmp(arg, "--tables"))
+        {
+            config.tables_path = value;
+            ++ii;
+        }
+        else if (!std::strcmp(arg, "--output"))
+        {
+            config.output_path = value;
+            ++ii;
+        }
+        else if (!std::strcmp(arg, "--seed"))
+        {
+            config.seed = std::strtoull(value, nullptr, 0);
+            ++ii;
+        }
+        else if (!std::strcmp(arg, "--cubes"))
+        {
+            config.cubes = std::atoi(value);
+            ++ii;
+        }
+        else if (!std::strcmp(arg, "--nodes"))
+        {
+            config.node_limit = std::atoll(value);
+            ++ii;
+        }
+        else if (!std::strcmp(arg, "--kernel"))
+        {
+            int kernel = 0;
+            while (kernel < NUM_BATCH_KERNELS &&
+                   std::strcmp(value, cube_batch_kernel_name(
+                                          (CubeBatchKernel)kernel)))
+            {
+                ++kernel;
+            }
+            config.kernel = (CubeBatchKernel)kernel;
+            if (!cube_set_batch_kernel(config.kernel))
+            {
+                return false;
+            }
+            ++ii;
+        }
+        else if (!std::strcmp(arg, "--pages"))
+        {
+            int pages = 0;
+            while (pages < NUM_BENCH_PAGES &&
+                   std::strcmp(value, bench_page_names[pages]))
+            {
+                ++pages;
+            }
+            if (pages == NUM_BENCH_PAGES)
+            {
+                return false;
+            }
+            config.pages = (CubePages)pages;
+            ++ii;
+        }
+        else
+        {
+            return false;
+        }
+    }
+
+    return config.cubes > 0 && config.node_limit > 0;
+}
+
+/******************************************************************************
+* Function:  main
+*
+* Purpose:   Runs the benchmarks.
+*
+* Params:    argc, argv - The command line; see the usage message.
+*
+* Returns:   0 on success, 1 if the report cannot be written, 2 if the
+*            command line is not understood.
+*
+* Operation: The JSON report is written to standard output, or to the file
+*            given with --output, and progress to standard error.
+******************************************************************************/
+int main(int argc, char** argv)
+{
+    BenchConfig config;
+    if (!parse_args(argc, argv, config))
+    {
+        std::fprintf(stderr,
+                     "Usage: %s [--tables FILE] [--output FILE] [--seed N] "
+                     "[--cubes N]\n"
+                     "       [--nodes N] [--multi-axis] [--full-phase1] "
+                     "[--full-phase2]\n"
+                     "       [--kernel scalar|avx2] "
+                     "[--pages normal|thp|hugetlb] [--no-solve] "
+                     "[--no-micro]\n", argv[0]);
+        return 2;
+    }
+    if (!config.output_path.empty() &&
+        !std::freopen(config.output_path.c_str(), "w", stdout))
+    {
+        std::fprintf(stderr, "Cannot write %s\n", config.output_path.c_str());
+        return 1;
+    }
+
+    TableOptions table_options;
+    table_options.full_phase1 = config.full_phase1;
+    table_options.full_phase2 = config.full_phase2;
+    table_options.placement.pages = config.pages;
+    SolverTables tables(table_options);
+    auto start = std::chrono::steady_clock::now();
+    bool loaded = tables.init(config.tables_path);
+    double table_seconds = seconds_since(start);
+
+    std::printf("{\n");
+    std::printf("  \"config\": {\"seed\": %llu, \"cubes\": %d, "
+                "\"node_limit\": %lld, \"multi_axis\": %s, "
+                "\"full_phase1\": %s, \"full_phase2\": %s, "
+                "\"kernel\": \"%s\", \"pages\": \"%s\"},\n",
+                (unsigned long long)config.seed, config.cubes,
+                config.node_limit, config.multi_axis ? "true" : "false",
+                config.full_phase1 ? "true" : "false",
+                config.full_phase2 ? "true" : "false",
+                cube_batch_kernel_name(config.kernel),
+                bench_page_names[config.pages]);
+    std::printf("  \"tables\": {\"loaded\": %s, \"seconds\": %.6g}%s\n",
+                loaded ? "true" : "false", table_seconds,
+                (config.solve || config.micro) ? "," : "");
+
+    if (config.solve)
+    {
+        solve_bench(tables, config, !config.micro);
+    }
+    if (config.micro)
+    {
+        micro_bench(tables);
+    }
+    std::printf("}\n");
+
+    return 0;
+}
@@ -0,0 +1,454 @@
+/******************************************************************************
+* File:    cubecache.cpp
+*
+* Purpose: Implementation of the on-disk table cache. Tables are written once
+*          to a versioned, checksummed binary file and later mapped back into
+*          memory with mmap, so that start-up becomes a page-fault-driven map
+*          instead of a search over millions of cube positions.
+******************************************************************************/
+
+/******************************************************************************
+* Dependencies
+******************************************************************************/
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cube.h>
+#include <cubecache.h>
+#include <cubemem.h>
+
+/******************************************************************************
+* Helper functions
+******************************************************************************/
+
+/******************************************************************************
+* Function:  align_up
+*
+* Purpose:   Rounds an offset up to the next table alignment boundary.
+*
+* Params:    offset - The offset to round.
+*
+* Returns:   The smallest multiple of CUBE_TABLE_ALIGN not less than offset.
+*
+* Operation: Standard power-of-two rounding.
+******************************************************************************/
+static uint64_t align_up(uint64_t offset)
+{
+    return (offset + CUBE_TABLE_ALIGN - 1) & ~(uint64_t)(CUBE_TABLE_ALIGN - 1);
+}
+
+/******************************************************************************
+* Function:  cube_checksum
+*
+* Purpose:   Calculates a 64-bit checksum of a block of memory.
+*
+* Params:    data  - Pointer to the start of the block.
+*            bytes - The length of the block.
+*
+* Returns:   The checksum value.
+*
+* Operation: A word-at-a-time variant of FNV-1a. Whole 64-bit words are mixed
+*            in first, then any trailing bytes one at a time.
+******************************************************************************/
+uint64_t cube_checksum(const void* data, size_t bytes)
+{
+    const uint64_t prime = 0x100000001b3ULL;
+    uint64_t hash = 0xcbf29ce484222325ULL;
+
+    const unsigned char* ptr = (const unsigned char*)data;
+    size_t words = bytes / sizeof(uint64_t);
+    for (size_t ii = 0; ii < words; ++ii)
+    {
+        uint64_t word;
+        std::memcpy(&word, ptr + ii * sizeof(uint64_t), sizeof(word));
+        hash = (hash ^ word) * prime;
+    }
+    for (size_t ii = words * sizeof(uint64_t); ii < bytes; ++ii)
+    {
+        hash = (hash ^ ptr[ii]) * prime;
+    }
+    return hash;
+}
+
+/******************************************************************************
+* CubeTableWriter class implementation
+******************************************************************************/
+
+/******************************************************************************
+* Function:  CubeTableWriter::add_section
+*
+* Purpose:   Adds a table to the file being built.
+*
+* Params:    type       - SECTION_TRANS or SECTION_PRUNE.
+*            rows, cols - The dimensions of the table.
+*            solved_pos - The coordinate of the solved cube (transition tables
+*                         only).
+*            data       - Pointer to the table contents.
+*            bytes      - Size of the table contents.
+*
+* Returns:   Nothing.
+*
+* Operation: Records the section descriptor and takes a copy of the data. The
+*            offset is assigned when the file is written.
+******************************************************************************/
+void CubeTableWriter::add_section(uint32_t type, uint32_t rows, uint32_t cols,
+                                  uint32_t solved_pos,
+                                  const void* data, size_t bytes)
+{
+    CubeTableSection section = {type, rows, cols, solved_pos, 0, bytes};
+    sections.push_back(section);
+
+    const char* ptr = (const char*)data;
+    payloads.push_back(std::vector<char>(ptr, ptr + bytes));
+}
+
+/******************************************************************************
+* Function:  CubeTableWriter::write
+*
+* Purpose:   Writes all sections added so far to a table file.
+*
+* Params:    path     - Where the file should be written.
+*            p1_moves - Bitmasks of the moves available in each phase, which
+*            p2_moves   are recorded so that stale files can be detected.
+*
+* Returns:   true if the file was written successfully, false otherwise.
+*
+* Operation: Lays out the header, the section descriptors and the aligned
+*            table data in memory, checksums the data, then writes to a
+*            temporary file which is renamed into place. Renaming means that a
+*            concurrent reader sees either the old file or the complete new
+*            one, never a partial write.
+******************************************************************************/
+bool CubeTableWriter::write(const std::string& path,
+                            uint32_t p1_moves, uint32_t p2_moves)
+{
+    // Work out where each section will live in the file.
+    uint64_t payload_start = align_up(sizeof(CubeTableHeader) +
+                                      sections.size() *
+                                      sizeof(CubeTableSection));
+    uint64_t offset = payload_start;
+    for (CubeTableSection& section : sections)
+    {
+        section.offset = offset;
+        offset = align_up(offset + section.bytes);
+    }
+
+    // Build the whole file image in memory.
+    std::vector<char> image(offset, 0);
+    for (int ii = 0; ii < (int)sections.size(); ++ii)
+    {
+        std::memcpy(&image[sections[ii].offset], payloads[ii].data(),
+                    sections[ii].bytes);
+    }
+
+    CubeTableHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, CUBE_TABLE_MAGIC, sizeof(CUBE_TABLE_MAGIC));
+    header.version = CUBE_TABLE_VERSION;
+    header.num_moves = NUM_MOVES;
+    header.p1_moves = p1_moves;
+    header.p2_moves = p2_moves;
+    header.num_sections = sections.size();
+    header.payload_bytes = offset - payload_start;
+    header.checksum = cube_checksum(&image[payload_start],
+                                    header.payload_bytes);
+
+    std::memcpy(&image[0], &header, sizeof(header));
+    std::memcpy(&image[sizeof(header)], sections.data(),
+                sections.size() * sizeof(CubeTableSection));
+
+    // Write to a temporary file and move it into place.
+    std::string tmp_path = path + ".tmp." + std::to_string(getpid());
+    std::FILE* file = std::fopen(tmp_path.c_str(), "wb");
+    if (file == nullptr)
+    {
+        return false;
+    }
+
+    bool ok = std::fwrite(image.data(), 1, image.size(), file) == image.size();
+    ok = (std::fclose(file) == 0) && ok;
+    if (ok)
+    {
+        ok = std::rename(tmp_path.c_str(), path.c_str()) == 0;
+    }
+    if (!ok)
+    {
+        std::remove(tmp_path.c_str());
+    }
+    return ok;
+}
+
+/******************************************************************************
+* CubeTableFile class implementation
+******************************************************************************/
+
+/******************************************************************************
+* Function:  CubeTableFile::CubeTableFile
+*
+* Purpose:   Constructor for the CubeTableFile class.
+*
+* Params:    None.
+*
+* Returns:   Nothing.
+*
+* Operation: Starts with no file mapped.
+******************************************************************************/
+CubeTableFile::CubeTableFile()
+{
+    mapping = nullptr;
+    mapping_bytes = 0;
+    mapping_copied = false;
+    mapping_pages = PAGES_NORMAL;
+    header = nullptr;
+    sections = nullptr;
+}
+
+/******************************************************************************
+* Function:  CubeTableFile::~CubeTableFile
+*
+* Purpose:   Destructor for the CubeTableFile class.
+*
+* Params:    None.
+*
+* Returns:   Nothing.
+*
+* Operation: Unmaps the file, if one is mapped.
+******************************************************************************/
+CubeTableFile::~CubeTableFile()
+{
+    close();
+}
+
+/******************************************************************************
+* Function:  CubeTableFile::open
+*
+* Purpose:   Maps a table file into memory and validates it.
+*
+* Params:    path      - The file to open.
+*            p1_moves  - Bitmasks of the moves available in each phase,
+*            p2_moves    which must match those recorded in the file.
+*            placement - Where to put the tables. The default maps the file
+*                        itself.
+*
+* Returns:   true if the file exists and is valid for this build, false if it
+*            is missing, truncated, from another version, or corrupt.
+*
+* Operation: Maps the whole file read-only, or for any other placement reads
+*            it into memory mapped with that placement, since the page cache
+*            behind a file mapping can be neither huge pages nor local to a
+*            chosen node. If that memory cannot be had, the file is mapped
+*            after all. Then checks the magic, version, move set, that every
+*            section lies within the file, and finally the checksum of the
+*            table data.
+******************************************************************************/
+bool CubeTableFile::open(const std::string& path,
+                         uint32_t p1_moves, uint32_t p2_moves,
+                         const CubePlacement& placement)
+{
+    close();
+
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < (off_t)sizeof(CubeTableHeader))
+    {
+        ::close(fd);
+        return false;
+    }
+
+    mapping_bytes = st.st_size;
+    if (!placement.is_default() && !read_placed(fd, placement))
+    {
+        ::close(fd);
+        close();
+        return false;
+    }
+    if (mapping == nullptr)
+    {
+        mapping = mmap(nullptr, mapping_bytes, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapping == MAP_FAILED)
+        {
+            mapping = nullptr;
+        }
+    }
+    ::close(fd);
+    if (mapping == nullptr)
+    {
+        mapping_bytes = 0;
+        return false;
+    }
+
+    // Validate the header before trusting anything else in the file.
+    header = (const CubeTableHeader*)mapping;
+    bool ok = std::memcmp(header->magic, CUBE_TABLE_MAGIC,
+                          sizeof(CUBE_TABLE_MAGIC)) == 0 &&
+              header->version == CUBE_TABLE_VERSION &&
+              header->num_moves == NUM_MOVES &&
+              header->p1_moves == p1_moves &&
+              header->p2_moves == p2_moves &&
+              sizeof(CubeTableHeader) +
+              (uint64_t)header->num_sections * sizeof(CubeTableSection)
+                                                           <= mapping_bytes;
+
+    // Check that every section lies within the payload.
+    uint64_t payload_start = 0;
+    if (ok)
+    {
+        sections = (const CubeTableSection*)(header + 1);
+        payload_start = align_up(sizeof(CubeTableHeader) +
+                                 header->num_sections *
+                                 sizeof(CubeTableSection));
+        ok = payload_start + header->payload_bytes <= mapping_bytes;
+
+        for (uint32_t ii = 0; ok && ii < header->num_sections; ++ii)
+        {
+            ok = sections[ii].offset >= payload_start &&
+                 sections[ii].offset + sections[ii].bytes <=
+                                        payload_start + header->payload_bytes;
+        }
+    }
+
+    // Finally check the table data has not been corrupted.
+    if (ok)
+    {
+        ok = cube_checksum((const char*)mapping + payload_start,
+                           header->payload_bytes) == header->checksum;
+    }
+
+    if (!ok)
+    {
+        close();
+    }
+    return ok;
+}
+
+/******************************************************************************
+* Function:  CubeTableFile::read_placed
+*
+* Purpose:   Reads an open table file into placed memory.
+*
+* Params:    fd        - The file, of mapping_bytes bytes.
+*            placement - Where to put it.
+*
+* Returns:   false if the file could not be read. If the memory could not be
+*            mapped, returns true with no mapping, so that the caller maps
+*            the file instead.
+*
+* Operation: Maps the memory, binding it to the node before it is touched,
+*            reads the whole file into it, and then makes it read-only like
+*            a file mapping.
+******************************************************************************/
+bool CubeTableFile::read_placed(int fd, const CubePlacement& placement)
+{
+    void* memory = cube_map_pages(mapping_bytes, placement);
+    if (memory == nullptr)
+    {
+        return true;
+    }
+    mapping = memory;
+    mapping_copied = true;
+    mapping_pages = placement.pages;
+
+    for (size_t done = 0; done < mapping_bytes; )
+    {
+        ssize_t count = pread(fd, (char*)memory + done, mapping_bytes - done,
+                              done);
+        if (count <= 0)
+        {
+            return false;
+        }
+        done += count;
+    }
+
+    mprotect(memory, cube_pages_size(mapping_bytes, mapping_pages),
+             PROT_READ);
+    return true;
+}
+
+/******************************************************************************
+* Function:  CubeTableFile::close
+*
+* Purpose:   Unmaps the file.
+*
+* Params:    None.
+*
+* Returns:   Nothing.
+*
+* Operation: Any pointers previously returned by section_data become invalid.
+******************************************************************************/
+void CubeTableFile::close()
+{
+    if (mapping_copied)
+    {
+        cube_unmap_pages(mapping, mapping_bytes, mapping_pages);
+    }
+    else if (mapping != nullptr)
+    {
+        munmap(mapping, mapping_bytes);
+    }
+    mapping = nullptr;
+    mapping_bytes = 0;
+    mapping_copied = false;
+    mapping_pages = PAGES_NORMAL;
+    header = nullptr;
+    sections = nullptr;
+}
+
+/******************************************************************************
+* Function:  CubeTableFile::num_sections
+*
+* Purpose:   Getter for the number of tables in the file.
+*
+* Params:    None.
+*
+* Returns:   The number of sections, or 0 if no file is open.
+*
+* Operation: Read from the header.
+******************************************************************************/
+int CubeTableFile::num_sections() const
+{
+    return (header == nullptr) ? 0 : header->num_sections;
+}
+
+/******************************************************************************
+* Function:  CubeTableFile::section
+*
+* Purpose:   Getter for a section descriptor.
+*
+* Params:    index - Which section to return.
+*
+* Returns:   The descriptor for that section.
+*
+* Operation: Simply index into the descriptor array.
+******************************************************************************/
+const CubeTableSection& CubeTableFile::section(int index) const
+{
+    return sections[index];
+}
+
+/******************************************************************************
+* Function:  CubeTableFile::section_data
+*
+* Purpose:   Getter for the data of a section.
+*
+* Params:    index - Which section to return.
+*
+* Returns:   Pointer to the start of the table data within the mapping.
+*
+* Operation: Offset from the start of the mapping.
+******************************************************************************/
+const void* CubeTableFile::section_data(int index) const
+{
+    return (const char*)mapping + sections[index].offset;
+}
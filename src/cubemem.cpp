@@ -0,0 +1,320 @@
+/******************************************************************************
+* File:    cubemem.cpp
+*
+* Purpose: Implementation of table memory placement: huge page mappings,
+*          NUMA node binding, and pinning threads to the processors of a
+*          node.
+******************************************************************************/
+
+/******************************************************************************
+* Dependencies
+******************************************************************************/
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <linux/mempolicy.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <cubemem.h>
+
+/******************************************************************************
+* Constants
+*
+* Where the kernel describes the NUMA topology.
+******************************************************************************/
+#define NODE_DIR "/sys/devices/system/node/"
+
+/******************************************************************************
+* Helper functions
+******************************************************************************/
+
+/******************************************************************************
+* Function:  parse_list
+*
+* Purpose:   Reads a list of numbers in the kernel's list format.
+*
+* Params:    path - The file holding the list, such as "0-3,8-11".
+*
+* Returns:   The numbers in the list, or none if the file cannot be read.
+*
+* Operation: Reads comma-separated entries, each a number or a range. The
+*            last entry may end with a newline, which strtol stops at.
+******************************************************************************/
+static std::vector<int> parse_list(const std::string& path)
+{
+    std::vector<int> values;
+    std::ifstream file(path);
+    std::string entry;
+
+    while (std::getline(file, entry, ','))
+    {
+        const char* text = entry.c_str();
+        char* end;
+        long first = std::strtol(text, &end, 10);
+        long last = first;
+        if (end == text)
+        {
+            return std::vector<int>();
+        }
+        if (*end == '-')
+        {
+            text = end + 1;
+            last = std::strtol(text, &end, 10);
+            if (end == text)
+            {
+                return std::vector<int>();
+            }
+        }
+        for (long value = first; value <= last; ++value)
+        {
+            values.push_back(value);
+        }
+    }
+    return values;
+}
+
+/******************************************************************************
+* Function:  bind_to_node
+*
+* Purpose:   Asks the kernel to place a mapping's pages on a NUMA node.
+*
+* Params:    memory - The start of the mapping.
+*            bytes  - The length of the mapping.
+*            node   - The node to prefer.
+*
+* Returns:   Nothing.
+*
+* Operation: Calls mbind directly, so that libnuma is not needed. It must be
+*            called before the pages are first touched, since pages already
+*            placed stay where they are. Failure leaves the kernel's default
+*            placement in force, which is still correct, only slower.
+******************************************************************************/
+static void bind_to_node(void* memory, size_t bytes, int node)
+{
+    const int bits = 8 * sizeof(unsigned long);
+    std::vector<unsigned long> mask(node / bits + 1, 0);
+    mask[node / bits] = 1UL << (node % bits);
+
+    syscall(SYS_mbind, memory, bytes, MPOL_PREFERRED, mask.data(),
+            mask.size() * bits + 1, 0);
+}
+
+/******************************************************************************
+* CubePlacement implementation
+******************************************************************************/
+
+/******************************************************************************
+* Function:  CubePlacement::is_default
+*
+* Purpose:   Tells whether a placement asks for anything special.
+*
+* Params:    None.
+*
+* Returns:   true for ordinary pages on no particular node.
+*
+* Operation: Compares against the default values.
+******************************************************************************/
+bool CubePlacement::is_default() const
+{
+    return pages == PAGES_NORMAL && node < 0;
+}
+
+/******************************************************************************
+* Memory functions
+******************************************************************************/
+
+/******************************************************************************
+* Function:  cube_pages_size
+*
+* Purpose:   Gives the size of the mapping made for a block of memory.
+*
+* Params:    bytes - The size asked for.
+*            pages - The kind of pages.
+*
+* Returns:   The size rounded up to a whole number of pages, counting huge
+*            pages for either huge page mode.
+*
+* Operation: Power-of-two rounding.
+******************************************************************************/
+size_t cube_pages_size(size_t bytes, CubePages pages)
+{
+    size_t page = (pages == PAGES_NORMAL) ? sysconf(_SC_PAGESIZE)
+                                          : CUBE_HUGE_PAGE;
+    return (bytes + page - 1) & ~(page - 1);
+}
+
+/******************************************************************************
+* Function:  cube_map_pages
+*
+* Purpose:   Maps zeroed memory for a table.
+*
+* Params:    bytes     - How much memory is needed.
+*            placement - Which pages to use and where to put them.
+*
+* Returns:   The memory, or nullptr if it could not be mapped. It must be
+*            released with cube_unmap_pages, passing the same size and kind
+*            of pages.
+*
+* Operation: A hugetlb mapping is tried first if asked for. Otherwise, or if
+*            that fails, an ordinary anonymous mapping is made. For
+*            transparent huge pages it is over-sized by one huge page and
+*            trimmed, so that it starts on a huge page boundary and every
+*            part of it can be backed by huge pages, which the kernel is
+*            then advised to do. The memory is bound to the node, if one is
+*            given, before anything touches it.
+******************************************************************************/
+void* cube_map_pages(size_t bytes, const CubePlacement& placement)
+{
+    size_t size = cube_pages_size(bytes, placement.pages);
+    void* memory = MAP_FAILED;
+
+    if (placement.pages == PAGES_HUGETLB)
+    {
+        memory = mmap(nullptr, size, PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    }
+
+    if (memory == MAP_FAILED && placement.pages == PAGES_NORMAL)
+    {
+        memory = mmap(nullptr, size, PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    }
+    else if (memory == MAP_FAILED)
+    {
+        void* raw = mmap(nullptr, size + CUBE_HUGE_PAGE,
+                         PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS,
+                         -1, 0);
+        if (raw != MAP_FAILED)
+        {
+            uintptr_t start = (uintptr_t)raw;
+            uintptr_t aligned = (start + CUBE_HUGE_PAGE - 1) &
+                                ~(CUBE_HUGE_PAGE - 1);
+            if (aligned > start)
+            {
+                munmap(raw, aligned - start);
+            }
+            munmap((void*)(aligned + size), start + CUBE_HUGE_PAGE - aligned);
+            memory = (void*)aligned;
+            madvise(memory, size, MADV_HUGEPAGE);
+        }
+    }
+
+    if (memory == MAP_FAILED)
+    {
+        return nullptr;
+    }
+    if (placement.node >= 0)
+    {
+        bind_to_node(memory, size, placement.node);
+    }
+    return memory;
+}
+
+/******************************************************************************
+* Function:  cube_unmap_pages
+*
+* Purpose:   Releases memory mapped by cube_map_pages.
+*
+* Params:    memory - The memory, which may be nullptr.
+*            bytes  - The size it was mapped with.
+*            pages  - The kind of pages it was mapped with.
+*
+* Returns:   Nothing.
+*
+* Operation: Unmaps the whole rounded size.
+******************************************************************************/
+void cube_unmap_pages(void* memory, size_t bytes, CubePages pages)
+{
+    if (memory != nullptr)
+    {
+        munmap(memory, cube_pages_size(bytes, pages));
+    }
+}
+
+/******************************************************************************
+* NUMA functions
+******************************************************************************/
+
+/******************************************************************************
+* Function:  cube_numa_nodes
+*
+* Purpose:   Counts the NUMA nodes of the machine.
+*
+* Params:    None.
+*
+* Returns:   One more than the highest online node, and at least 1.
+*
+* Operation: Reads the kernel's list of online nodes.
+******************************************************************************/
+int cube_numa_nodes()
+{
+    std::vector<int> nodes = parse_list(NODE_DIR "online");
+    return nodes.empty() ? 1 : nodes.back() + 1;
+}
+
+/******************************************************************************
+* Function:  cube_numa_cpus
+*
+* Purpose:   Lists the processors of a NUMA node.
+*
+* Params:    node - The node.
+*
+* Returns:   The processor numbers, which may be empty for a node with
+*            memory but no processors.
+*
+* Operation: Reads the node's processor list. If there is no topology to
+*            read, node 0 is taken to hold every processor.
+******************************************************************************/
+std::vector<int> cube_numa_cpus(int node)
+{
+    std::vector<int> cpus = parse_list(NODE_DIR "node" +
+                                       std::to_string(node) + "/cpulist");
+    if (cpus.empty() && node == 0 && parse_list(NODE_DIR "online").empty())
+    {
+        int count = std::thread::hardware_concurrency();
+        for (int cpu = 0; cpu < count; ++cpu)
+        {
+            cpus.push_back(cpu);
+        }
+    }
+    return cpus;
+}
+
+/******************************************************************************
+* Function:  cube_pin_thread
+*
+* Purpose:   Restricts the calling thread to the processors of a NUMA node.
+*
+* Params:    node - The node.
+*
+* Returns:   true if the thread was pinned.
+*
+* Operation: Sets the thread's affinity to the node's processors. Memory the
+*            thread first touches afterwards is then placed on that node by
+*            default too.
+******************************************************************************/
+bool cube_pin_thread(int node)
+{
+    std::vector<int> cpus = cube_numa_cpus(node);
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int cpu : cpus)
+    {
+        if (cpu < CPU_SETSIZE)
+        {
+            CPU_SET(cpu, &set);
+        }
+    }
+
+    return !cpus.empty() &&
+           pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+}
@@ -0,0 +1,571 @@
+/******************************************************************************
+* File:    cubeoptimal.cpp
+*
+* Purpose: Implementation of the OptimalSolver class, which finds the shortest
+*          solutions to the cube with an IDA* search over all 18 moves.
+******************************************************************************/
+
+/******************************************************************************
+* Dependencies
+******************************************************************************/
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+
+#include <cube.h>
+#include <cubeoptimal.h>
+#include <cubephase.h>
+#include <cubepool.h>
+#include <cubesolver.h>
+#include <cubesym.h>
+#include <cubetables.h>
+
+/******************************************************************************
+* OptimalSolver::Search class declaration. A Search holds the state of one
+* depth-first walk of the search tree. A sequential solve uses a single
+* Search; a parallel solve gives each subtree its own copy.
+*
+* As in CubeSolver, the walk is iterative, with one frame for each level of
+* the tree. Each frame holds the corner permutation of its node, and the
+* phase 1 coordinates of the node as seen along each axis, that is, of the
+* cube conjugated by the symmetry which brings that axis into the UD
+* position. A move of the cube is the conjugated move of each re-oriented
+* cube.
+******************************************************************************/
+class OptimalSolver::Search
+{
+private:
+    OptimalSolver& solver;
+    const SolverTables& tables;
+
+    // The node reached by the first k moves of the solution is in frame k.
+    struct Frame
+    {
+        int co[OPTIMAL_AXES];
+        int eo[OPTIMAL_AXES];
+        int ud_pos[OPTIMAL_AXES];
+        int cp;
+        int last;
+        const uint8_t* next;
+        const uint8_t* end;
+    };
+
+    Frame frames[OPTIMAL_MAX_MOVES + 1] = {};
+    int moves[OPTIMAL_MAX_MOVES] = {};
+    int length;
+    long long local_nodes;
+
+    // The move made along each axis by each move of the cube.
+    uint8_t axis_moves[OPTIMAL_AXES][NUM_MOVES];
+
+    bool out_of_budget();
+    void push_move(int move);
+    bool pruned(const Frame& frame, int depth) const;
+    bool solves() const;
+public:
+    Search(OptimalSolver& optimal_solver);
+    int bound() const;
+    bool search(int depth);
+    void split(int depth, int levels, CubeTaskGroup& group);
+    void flush();
+};
+
+/******************************************************************************
+* OptimalSolver::Search class implementation
+******************************************************************************/
+
+/******************************************************************************
+* Function:  OptimalSolver::Search::Search
+*
+* Purpose:   Constructor for the Search class.
+*
+* Params:    optimal_solver - The solver this search is working for.
+*
+* Returns:   Nothing.
+*
+* Operation: Starts the search at the root of the tree, that is, at the
+*            scrambled cube with no moves made. Axis k is the cube conjugated
+*            by the symmetry which turns the whole cube k times about the
+*            URF-DBL diagonal.
+******************************************************************************/
+OptimalSolver::Search::Search(OptimalSolver& optimal_solver)
+    : solver(optimal_solver), tables(optimal_solver.tables)
+{
+    Frame& root = frames[0];
+    for (int axis = 0; axis < OPTIMAL_AXES; ++axis)
+    {
+        int sym = NUM_SYMS_UD * axis;
+        Cube cube = cube_conjugate(solver.cube, sym);
+        root.co[axis] = cube.coord_corner_orientation();
+        root.eo[axis] = cube.coord_edge_orientation();
+        root.ud_pos[axis] = cube.coord_ud_unsorted();
+
+        for (int move = 0; move < NUM_MOVES; ++move)
+        {
+            axis_moves[axis][move] = cube_conjugate_move(move, sym);
+        }
+    }
+
+    Cube cube = solver.cube;
+    root.cp = cube.coord_corner_permutation();
+    root.last = NUM_MOVES;
+    root.next = root.end = nullptr;
+
+    length = 0;
+    local_nodes = 0;
+}
+
+/******************************************************************************
+* Function:  OptimalSolver::Search::out_of_budget
+*
+* Purpose:   Counts a search node and checks whether the search should stop.
+*
+* Params:    None.
+*
+* Returns:   true if the node limit or deadline has been reached, or a
+*            solution has been found.
+*
+* Operation: As in CubeSolver, nodes are only added to the shared total, where
+*            the limits are checked, every 1024 nodes.
+******************************************************************************/
+inline bool OptimalSolver::Search::out_of_budget()
+{
+    if (++local_nodes == 1024)
+    {
+        flush();
+    }
+    return solver.stopped.load(std::memory_order_relaxed);
+}
+
+/******************************************************************************
+* Function:  OptimalSolver::Search::push_move
+*
+* Purpose:   Adds a move to the end of the solution.
+*
+* Params:    move - The move to add.
+*
+* Returns:   Nothing.
+*
+* Operation: Fills in the coordinates of the next frame from those of the
+*            current one, applying the conjugated move along each axis.
+******************************************************************************/
+inline void OptimalSolver::Search::push_move(int move)
+{
+    const Frame& frame = frames[length];
+    Frame& next = frames[length + 1];
+
+    for (int axis = 0; axis < OPTIMAL_AXES; ++axis)
+    {
+        int axis_move = axis_moves[axis][move];
+        next.co[axis] = tables.co_trans(frame.co[axis], axis_move);
+        next.eo[axis] = tables.eo_trans(frame.eo[axis], axis_move);
+        next.ud_pos[axis] = tables.ud_unsorted_trans(frame.ud_pos[axis],
+                                                     axis_move);
+    }
+    next.cp = tables.cp_trans(frame.cp, move);
+    next.last = move;
+
+    moves[length++] = move;
+}
+
+/******************************************************************************
+* Function:  OptimalSolver::Search::pruned
+*
+* Purpose:   Decides whether a node can be cut off.
+*
+* Params:    frame - The node.
+*            depth - How many more moves may be made from it.
+*
+* Returns:   true if the node is known to need more than depth moves.
+*
+* Operation: Checks the phase-1 distance along each axis, then the corner
+*            distance, stopping at the first which is too far.
+******************************************************************************/
+inline bool OptimalSolver::Search::pruned(const Frame& frame, int depth) const
+{
+    for (int axis = 0; axis < OPTIMAL_AXES; ++axis)
+    {
+        if (tables.phase1_prune(frame.co[axis], frame.eo[axis],
+                                frame.ud_pos[axis]) > depth)
+        {
+            return true;
+        }
+    }
+    return tables.corner_prune(frame.cp, frame.co[0]) > depth;
+}
+
+/******************************************************************************
+* Function:  OptimalSolver::Search::solves
+*
+* Purpose:   Checks whether the moves made so far solve the cube.
+*
+* Params:    None.
+*
+* Returns:   true if they do.
+*
+* Operation: Positions with every bound at zero have their corners solved,
+*            and every edge oriented and in its own slice, but the edges can
+*            still be swapped within a slice. These positions are rare, so
+*            the moves are simply applied to the cube to check.
+******************************************************************************/
+bool OptimalSolver::Search::solves() const
+{
+    Cube cube = solver.cube;
+    for (int ii = 0; ii < length; ++ii)
+    {
+        cube.apply_move(moves[ii]);
+    }
+    return cube == Cube();
+}
+
+/******************************************************************************
+* Function:  OptimalSolver::Search::bound
+*
+* Purpose:   Gives a lower bound on the number of moves needed to solve the
+*            cube from the current node.
+*
+* Params:    None.
+*
+* Returns:   The largest of the bounds checked by pruned.
+*
+* Operation: Looks up every table.
+******************************************************************************/
+int OptimalSolver::Search::bound() const
+{
+    const Frame& frame = frames[length];
+    int value = tables.corner_prune(frame.cp, frame.co[0]);
+    for (int axis = 0; axis < OPTIMAL_AXES; ++axis)
+    {
+        value = std::max(value, tables.phase1_prune(frame.co[axis],
+                                                    frame.eo[axis],
+                                                    frame.ud_pos[axis]));
+    }
+    return value;
+}
+
+/******************************************************************************
+* Function:  OptimalSolver::Search::search
+*
+* Purpose:   Looks for solutions of a given length from the current node.
+*
+* Params:    depth - How many more moves the solutions should have. The
+*                    current node must not be pruned at this depth.
+*
+* Returns:   true if the subtree was searched in full, or false if the search
+*            was stopped first, by the budget or by a solution being found.
+*
+* Operation: A depth-first search over the frames from the current level
+*            down to depth moves further. Entering a node counts it and
+*            either checks whether it solves the cube, at the bottom, or sets
+*            up its list of moves. The loop then takes the next untried move
+*            of the deepest frame, entering the child unless it is pruned,
+*            and drops back a level once the moves are all tried. The first
+*            solution found stops every search taking part in the solve.
+******************************************************************************/
+bool OptimalSolver::Search::search(int depth)
+{
+    const int top = length;
+    const int bottom = length + depth;
+    bool entering = true;
+
+    for (;;)
+    {
+        Frame& frame = frames[length];
+
+        if (entering)
+        {
+            entering = false;
+            if (out_of_budget())
+            {
+                length = top;
+                return false;
+            }
+            if (length == bottom)
+            {
+                frame.next = frame.end = nullptr;
+                if (solves())
+                {
+                    solver.record_sol(moves, length, local_nodes);
+                }
+            }
+            else
+            {
+                const CubeMoveList& list = cube_p1_allowed_moves[frame.last];
+                frame.next = list.begin();
+                frame.end = list.end();
+            }
+        }
+
+        while (frame.next != frame.end)
+        {
+            push_move(*frame.next++);
+            if (!pruned(frames[length], bottom - length))
+            {
+                entering = true;
+                break;
+            }
+            --length;
+        }
+        if (entering)
+        {
+            continue;
+        }
+
+        if (length == top)
+        {
+            return true;
+        }
+        --length;
+        if (solver.stopped.load(std::memory_order_relaxed))
+        {
+            length = top;
+            return false;
+        }
+    }
+}
+
+/******************************************************************************
+* Function:  OptimalSolver::Search::split
+*
+* Purpose:   Splits a search into subtrees which can be searched in parallel.
+*
+* Params:    depth  - How many more moves the solutions should have.
+*            levels - How many more moves to make before handing off the rest
+*                     of the tree as a task.
+*            group  - The task group to which subtrees are submitted.
+*
+* Returns:   Nothing.
+*
+* Operation: Walks the top of the tree exactly as search would, applying the
+*            same pruning, and when levels reaches zero submits a copy of
+*            this search to continue from the current node. Only the first
+*            few levels are walked, so this is left recursive.
+******************************************************************************/
+void OptimalSolver::Search::split(int depth, int levels, CubeTaskGroup& group)
+{
+    if (levels == 0)
+    {
+        Search task = *this;
+        group.run([task, depth]() mutable
+        {
+            task.search(depth);
+            task.flush();
+        });
+        return;
+    }
+
+    for (int move : cube_p1_allowed_moves[frames[length].last])
+    {
+        push_move(move);
+        if (!pruned(frames[length], depth - 1))
+        {
+            split(depth - 1, levels - 1, group);
+        }
+        --length;
+    }
+}
+
+/******************************************************************************
+* Function:  OptimalSolver::Search::flush
+*
+* Purpose:   Adds the nodes this search has counted to the shared total.
+*
+* Params:    None.
+*
+* Returns:   Nothing.
+*
+* Operation: Must be called when a search finishes so that no nodes are lost.
+******************************************************************************/
+void OptimalSolver::Search::flush()
+{
+    solver.add_nodes(local_nodes);
+    local_nodes = 0;
+}
+
+/******************************************************************************
+* OptimalSolver class implementation
+******************************************************************************/
+
+/******************************************************************************
+* Function:  OptimalSolver::OptimalSolver
+*
+* Purpose:   Constructor for the OptimalSolver class.
+*
+* Params:    solver_tables  - The tables to search with, which must have been
+*                             built with the optimal option, must already
+*                             have been filled or loaded, and must outlive
+*                             this object.
+*            scrambled_cube - The cube to solve.
+*
+* Returns:   Nothing.
+*
+* Operation: Keeps the cube, from which each search works out its starting
+*            coordinates.
+******************************************************************************/
+OptimalSolver::OptimalSolver(const SolverTables& solver_tables,
+                             Cube scrambled_cube)
+    : tables(solver_tables), cube(scrambled_cube), stopped(false), nodes(0),
+      proved_depth(0)
+{
+}
+
+/******************************************************************************
+* Function:  OptimalSolver::record_sol
+*
+* Purpose:   Record a solution that has been found.
+*
+* Params:    solution    - The moves of the solution.
+*            length      - How many moves there are.
+*            local_nodes - Nodes counted by the finding search which have not
+*                          yet been added to the shared total.
+*
+* Returns:   Nothing.
+*
+* Operation: Under the result lock, stores the solution unless another search
+*            has already found one, which is then just as short, and passes
+*            it to the process_sol callback, if there is one. Stops the
+*            search, since nothing shorter can be found.
+******************************************************************************/
+void OptimalSolver::record_sol(const int* solution, int length,
+                               long long local_nodes)
+{
+    std::lock_guard<std::mutex> guard(result_lock);
+    if (result.length >= 0)
+    {
+        return;
+    }
+
+    std::chrono::duration<double> elapsed =
+                                  std::chrono::steady_clock::now() - start_time;
+
+    result.moves.assign(solution, solution + length);
+    result.length = length;
+    result.nodes = nodes + local_nodes;
+    result.improvements.push_back({result.length, result.nodes,
+                                   elapsed.count()});
+
+    if (options.process_sol)
+    {
+        options.process_sol(result);
+    }
+    stopped = true;
+}
+
+/******************************************************************************
+* Function:  OptimalSolver::add_nodes
+*
+* Purpose:   Adds to the shared count of nodes and checks the search budget.
+*
+* Params:    count - The number of nodes to add.
+*
+* Returns:   Nothing.
+*
+* Operation: Stops the search if the node limit or deadline has been reached.
+******************************************************************************/
+void OptimalSolver::add_nodes(long long count)
+{
+    long long total = nodes += count;
+    if (total >= options.node_limit ||
+        std::chrono::steady_clock::now() >= options.deadline)
+    {
+        stopped = true;
+    }
+}
+
+/******************************************************************************
+* Function:  OptimalSolver::parallel_search
+*
+* Purpose:   Runs one iteration of the deepening on the thread pool.
+*
+* Params:    root  - The search at the root of the tree.
+*            depth - The length of solutions to look for.
+*
+* Returns:   Nothing.
+*
+* Operation: Splits the tree split_depth moves down (but always leaving at
+*            least one move for the subtree), submits each surviving subtree
+*            as a task and waits for them all. The first solution found by
+*            any of them stops the rest.
+******************************************************************************/
+void OptimalSolver::parallel_search(Search& root, int depth)
+{
+    CubeTaskGroup group(*options.pool);
+    root.split(depth, std::min(options.split_depth, depth - 1), group);
+    group.wait();
+}
+
+/******************************************************************************
+* Function:  OptimalSolver::solve
+*
+* Purpose:   Finds an optimal solution to the cube, within limits.
+*
+* Params:    solve_options - When to stop searching; see the class
+*                            description for which options apply.
+*
+* Returns:   An optimal solution, or no solution if the search was stopped
+*            first or the tables were not built for it.
+*
+* Operation: Deepens the search from the root's own lower bound, since no
+*            shorter solution can exist, until a solution is found. Each
+*            iteration which finishes without one proves that the cube needs
+*            at least one more move. Shallow depths are always searched
+*            sequentially, since there is too little work in them to be
+*            worth splitting.
+******************************************************************************/
+SolveResult OptimalSolver::solve(const SolveOptions& solve_options)
+{
+    options = solve_options;
+    result = SolveResult();
+    start_time = std::chrono::steady_clock::now();
+    stopped = false;
+    nodes = 0;
+    proved_depth = 0;
+    if (!tables.options.optimal)
+    {
+        return result;
+    }
+
+    Search search(*this);
+    proved_depth = search.bound();
+    for (int depth = proved_depth; depth <= OPTIMAL_MAX_MOVES && !stopped;
+         ++depth)
+    {
+        if (options.pool != nullptr && options.split_depth > 0 && depth > 1)
+        {
+            parallel_search(search, depth);
+        }
+        else
+        {
+            search.search(depth);
+        }
+        if (!stopped)
+        {
+            proved_depth = depth + 1;
+        }
+    }
+    search.flush();
+
+    result.nodes = nodes;
+    return result;
+}
+
+/******************************************************************************
+* Function:  OptimalSolver::lower_bound
+*
+* Purpose:   Tells how many moves the cube is known to need.
+*
+* Params:    None.
+*
+* Returns:   The number of moves of the solution, if the last solve found
+*            one, which is then optimal. Otherwise the number of moves which
+*            the iterations it finished before stopping proved necessary.
+*
+* Operation: Every iteration from the root's bound up to the one before
+*            proved_depth found nothing.
+******************************************************************************/
+int OptimalSolver::lower_bound() const
+{
+    return proved_depth;
+}
@@ -0,0 +1,410 @@
+/******************************************************************************
+* File:    cubepool.cpp
+*
+* Purpose: Implementation of the CubeThreadPool and CubeTaskGroup classes,
+*          which spread searches over several cores using work stealing.
+******************************************************************************/
+
+/******************************************************************************
+* Dependencies
+******************************************************************************/
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <cubemem.h>
+#include <cubepool.h>
+
+/******************************************************************************
+* The index of the pool worker running on the current thread, or -1 if the
+* thread does not belong to a pool.
+******************************************************************************/
+static thread_local int current_worker = -1;
+static thread_local const CubeThreadPool* current_pool = nullptr;
+
+/******************************************************************************
+* CubeThreadPool class implementation
+******************************************************************************/
+
+/******************************************************************************
+* Function:  CubeThreadPool::CubeThreadPool
+*
+* Purpose:   Constructor for the CubeThreadPool class.
+*
+* Params:    num_threads - The number of worker threads to start. If zero, one
+*                          thread is started per hardware thread, or per
+*                          processor of the node if one is given.
+*            numa_node   - If not negative, the NUMA node whose processors the
+*                          workers are pinned to.
+*
+* Returns:   Nothing.
+*
+* Operation: Creates a task deque for each worker and then starts the worker
+*            threads.
+******************************************************************************/
+CubeThreadPool::CubeThreadPool(int num_threads, int numa_node)
+    : queued(0), next_worker(0), shutdown(false), node(numa_node)
+{
+    if (num_threads <= 0 && node >= 0)
+    {
+        num_threads = cube_numa_cpus(node).size();
+    }
+    if (num_threads <= 0)
+    {
+        num_threads = std::thread::hardware_concurrency();
+    }
+    if (num_threads <= 0)
+    {
+        num_threads = 1;
+    }
+
+    for (int ii = 0; ii < num_threads; ++ii)
+    {
+        workers.emplace_back(new Worker());
+    }
+    for (int ii = 0; ii < num_threads; ++ii)
+    {
+        threads.emplace_back(&CubeThreadPool::worker_main, this, ii);
+    }
+}
+
+/******************************************************************************
+* Function:  CubeThreadPool::~CubeThreadPool
+*
+* Purpose:   Destructor for the CubeThreadPool class.
+*
+* Params:    None.
+*
+* Returns:   Nothing.
+*
+* Operation: Wakes every worker, lets them drain any remaining tasks, and
+*            joins them.
+******************************************************************************/
+CubeThreadPool::~CubeThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> guard(sleep_lock);
+        shutdown = true;
+    }
+    wake.notify_all();
+
+    for (std::thread& thread : threads)
+    {
+        thread.join();
+    }
+}
+
+/******************************************************************************
+* Function:  CubeThreadPool::size
+*
+* Purpose:   Getter for the number of worker threads.
+*
+* Params:    None.
+*
+* Returns:   The number of worker threads.
+*
+* Operation: Simply return the value.
+******************************************************************************/
+int CubeThreadPool::size() const
+{
+    return workers.size();
+}
+
+/******************************************************************************
+* Function:  CubeThreadPool::submit
+*
+* Purpose:   Queues a task to be run by the pool.
+*
+* Params:    task - The task to run.
+*
+* Returns:   Nothing.
+*
+* Operation: A task submitted from one of this pool's workers goes on that
+*            worker's own deque, so it stays local unless another worker
+*            steals it. Tasks from outside the pool are dealt out round-robin.
+******************************************************************************/
+void CubeThreadPool::submit(std::function<void()> task)
+{
+    int index = (current_pool == this) ? current_worker
+                                       : next_worker++ % workers.size();
+
+    // Count the task before queueing it, under the sleep lock, so that the
+    // count never drops below zero and a worker which has just found nothing
+    // to do cannot miss the notification.
+    {
+        std::lock_guard<std::mutex> guard(sleep_lock);
+        ++queued;
+    }
+    {
+        std::lock_guard<std::mutex> guard(workers[index]->lock);
+        workers[index]->tasks.push_back(std::move(task));
+    }
+    wake.notify_one();
+}
+
+/******************************************************************************
+* Function:  CubeThreadPool::pop
+*
+* Purpose:   Takes the most recently queued task from a worker's own deque.
+*
+* Params:    index - The worker whose deque to take from.
+*            task  - Receives the task, if there is one.
+*
+* Returns:   true if a task was taken.
+*
+* Operation: Takes from the back of the deque.
+******************************************************************************/
+bool CubeThreadPool::pop(int index, std::function<void()>& task)
+{
+    std::lock_guard<std::mutex> guard(workers[index]->lock);
+    if (workers[index]->tasks.empty())
+    {
+        return false;
+    }
+    task = std::move(workers[index]->tasks.back());
+    workers[index]->tasks.pop_back();
+    --queued;
+    return true;
+}
+
+/******************************************************************************
+* Function:  CubeThreadPool::steal
+*
+* Purpose:   Takes the oldest queued task from some other worker's deque.
+*
+* Params:    index - The worker doing the stealing, or -1 for a thread outside
+*                    the pool.
+*            task  - Receives the task, if there is one.
+*
+* Returns:   true if a task was taken.
+*
+* Operation: Visits every other worker once, starting just after the thief,
+*            and takes from the front of the first non-empty deque.
+******************************************************************************/
+bool CubeThreadPool::steal(int index, std::function<void()>& task)
+{
+    int count = workers.size();
+    for (int ii = 1; ii <= count; ++ii)
+    {
+        int victim = (index + ii + count) % count;
+        if (victim == index)
+        {
+            continue;
+        }
+
+        std::lock_guard<std::mutex> guard(workers[victim]->lock);
+        if (!workers[victim]->tasks.empty())
+        {
+            task = std::move(workers[victim]->tasks.front());
+            workers[victim]->tasks.pop_front();
+            --queued;
+            return true;
+        }
+    }
+    return false;
+}
+
+/******************************************************************************
+* Function:  CubeThreadPool::run_one
+*
+* Purpose:   Runs a single queued task on the calling thread.
+*
+* Params:    None.
+*
+* Returns:   true if a task was run, false if there was nothing queued.
+*
+* Operation: A worker of this pool prefers its own deque; any other thread
+*            simply steals.
+******************************************************************************/
+bool CubeThreadPool::run_one()
+{
+    std::function<void()> task;
+    int index = (current_pool == this) ? current_worker : -1;
+
+    if ((index >= 0 && pop(index, task)) || steal(index, task))
+    {
+        task();
+        return true;
+    }
+    return false;
+}
+
+/******************************************************************************
+* Function:  CubeThreadPool::worker_main
+*
+* Purpose:   The main loop of a worker thread.
+*
+* Params:    index - Which worker this thread is.
+*
+* Returns:   Nothing.
+*
+* Operation: Pins the thread to the pool's node, if it has one. Then runs
+*            tasks for as long as there are any, and sleeps when every deque
+*            is empty. Exits once the pool is shut down and no tasks remain.
+******************************************************************************/
+void CubeThreadPool::worker_main(int index)
+{
+    current_worker = index;
+    current_pool = this;
+    if (node >= 0)
+    {
+        cube_pin_thread(node);
+    }
+
+    while (true)
+    {
+        if (run_one())
+        {
+            continue;
+        }
+
+        std::unique_lock<std::mutex> guard(sleep_lock);
+        wake.wait(guard, [this] { return shutdown || queued > 0; });
+        if (shutdown && queued == 0)
+        {
+            return;
+        }
+    }
+}
+
+/******************************************************************************
+* CubeTaskGroup class implementation
+******************************************************************************/
+
+/******************************************************************************
+* Function:  CubeTaskGroup::CubeTaskGroup
+*
+* Purpose:   Constructor for the CubeTaskGroup class.
+*
+* Params:    thread_pool - The pool which will run the group's tasks.
+*
+* Returns:   Nothing.
+*
+* Operation: Starts with no tasks pending.
+******************************************************************************/
+CubeTaskGroup::CubeTaskGroup(CubeThreadPool& thread_pool)
+    : pool(thread_pool), pending(0)
+{
+}
+
+/******************************************************************************
+* Function:  CubeTaskGroup::~CubeTaskGroup
+*
+* Purpose:   Destructor for the CubeTaskGroup class.
+*
+* Params:    None.
+*
+* Returns:   Nothing.
+*
+* Operation: Waits for any outstanding tasks, since they refer to the group.
+******************************************************************************/
+CubeTaskGroup::~CubeTaskGroup()
+{
+    wait();
+}
+
+/******************************************************************************
+* Function:  CubeTaskGroup::run
+*
+* Purpose:   Submits a task to the pool as part of this group.
+*
+* Params:    task - The task to run.
+*
+* Returns:   Nothing.
+*
+* Operation: Wraps the task so that the group is told when it finishes. The
+*            count is decremented under the lock so that a waiter cannot
+*            return, and destroy the group, while the lock is still held.
+******************************************************************************/
+void CubeTaskGroup::run(std::function<void()> task)
+{
+    ++pending;
+    pool.submit([this, task]
+    {
+        task();
+
+        std::lock_guard<std::mutex> guard(done_lock);
+        if (--pending == 0)
+        {
+            done.notify_all();
+        }
+    });
+}
+
+/******************************************************************************
+* Function:  CubeTaskGroup::wait
+*
+* Purpose:   Waits for every task in this group to finish.
+*
+* Params:    None.
+*
+* Returns:   Nothing.
+*
+* Operation: Helps by running queued tasks while any of the group's tasks are
+*            outstanding. When nothing is queued, the remaining tasks are
+*            already running elsewhere, so sleeps until one of them finishes.
+******************************************************************************/
+void CubeTaskGroup::wait()
+{
+    while (pending > 0)
+    {
+        if (!pool.run_one())
+        {
+            std::unique_lock<std::mutex> guard(done_lock);
+            done.wait_for(guard, std::chrono::milliseconds(1),
+                          [this] { return pending == 0; });
+        }
+    }
+
+    // Make sure the task which finished last has released the lock.
+    std::lock_guard<std::mutex> guard(done_lock);
+}
+
+/******************************************************************************
+* Parallel loop implementation
+******************************************************************************/
+
+/******************************************************************************
+* Function:  cube_parallel_for
+*
+* Purpose:   Runs a loop body over a range, in parallel.
+*
+* Params:    pool  - The pool to run on, or nullptr to run sequentially.
+*            count - The size of the range.
+*            chunk - How many elements each call of the body receives, apart
+*                    from the last, which may receive fewer.
+*            body  - Called with the bounds of each chunk.
+*
+* Returns:   Nothing.
+*
+* Operation: Submits one task per chunk as a task group and waits for the
+*            group, so that everything the body wrote is visible once this
+*            returns.
+******************************************************************************/
+void cube_parallel_for(CubeThreadPool* pool, long count, long chunk,
+                       const std::function<void(long begin, long end)>& body)
+{
+    if (pool == nullptr || pool->size() <= 1 || count <= chunk)
+    {
+        if (count > 0)
+        {
+            body(0, count);
+        }
+        return;
+    }
+
+    CubeTaskGroup group(*pool);
+    for (long begin = 0; begin < count; begin += chunk)
+    {
+        long end = std::min(begin + chunk, count);
+        group.run([&body, begin, end] { body(begin, end); });
+    }
+    group.wait();
+}
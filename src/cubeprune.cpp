@@ -8,124 +8,321 @@
 /******************************************************************************
 * Dependencies
 ******************************************************************************/
-#include <deque>
-#include <iostream>
-#include <utility>
-#include <vector>
+#include <atomic>
+#include <cstdint>
+#include <new>
 
 #include <cube.h>
+#include <cubecache.h>
+#include <cubemem.h>
 #include <cubephase.h>
+#include <cubepool.h>
 #include <cubeprune.h>
 #include <cubetrans.h>
 
 /******************************************************************************
-* CubePrune class implementation.
+* Constants
+*
+* The number of entries each task scans in one level of a parallel fill.
 ******************************************************************************/
+#define PRUNE_FILL_CHUNK (1L << 16)
 
 /******************************************************************************
-* Function:  CubePrune::CubePrune
+* CubeNibbleTable class implementation.
+******************************************************************************/
+
+static_assert(sizeof(std::atomic<uint8_t>) == 1,
+              "Packed pruning tables need single-byte atomics");
+
+/******************************************************************************
+* Function:  CubeNibbleTable::~CubeNibbleTable
 *
-* Purpose:   Constructor for the CubePrune class.
+* Purpose:   Destructor for the CubeNibbleTable class.
 *
-* Params:    phase_desc    - Whether this pruning table is relevant in phase 1
-*                            or phase 2 of the two-phase algorithm.
-*            trans_table_1 - Pointers to the transition tables of the cube
-*            trans_table_2 - coordinates that this table is for.
+* Params:    None.
 *
 * Returns:   Nothing.
 *
-* Operation: Uses the phase to store the available moves, and stores the
-*            transition tables. Allocates space for the data in the pruning
-*            table.
+* Operation: Releases the storage, if any.
 ******************************************************************************/
-CubePrune::CubePrune(int phase_desc,
-                     CubeTrans* trans_table_1, CubeTrans* trans_table_2)
+CubeNibbleTable::~CubeNibbleTable()
 {
-    phase = phase_desc;
-    transition_table_1 = trans_table_1;
-    transition_table_2 = trans_table_2;
-
-    table = std::vector<std::vector<int>>(
-                                  trans_table_1->size(),
-                                  std::vector<int>(trans_table_2->size(), -1));
+    clear();
 }
 
 /******************************************************************************
-* Function:  CubePrune::operator()
+* Function:  CubeNibbleTable::assign
 *
-* Purpose:   Returns an entry in the pruning table.
+* Purpose:   Allocates storage for a table, with every entry unvisited.
 *
-* Params:    coord_value_1 - The coordinate values of the position to look up.
-*            coord_value_2
+* Params:    entries   - The number of entries in the table.
+*            placement - Which pages to put the storage on, and where.
 *
-* Returns:   The value stored in the table for that combination of coordinates.
+* Returns:   Nothing.
 *
-* Operation: Simply return the value from the private table.
+* Operation: Replaces any existing storage. The padding after the last entry
+*            is also set, though it is never part of the table. If the pages
+*            asked for cannot be had, ordinary pages are used instead; if
+*            even those cannot, the allocation fails as new would. Setting
+*            the entries is the first touch of the new pages, so it is done
+*            here, on the thread which asked for the storage, after the
+*            mapping has been bound to its node.
 ******************************************************************************/
-int CubePrune::operator()(int coord_value_1, int coord_value_2)
+void CubeNibbleTable::assign(long entries, const CubePlacement& placement)
 {
-    return table[coord_value_1][coord_value_2];
+    clear();
+
+    num_bytes = (entries + 1) / 2;
+    long padded = (num_bytes + 3) & ~3L;
+
+    pages = placement.pages;
+    void* memory = cube_map_pages(padded, placement);
+    if (memory == nullptr && !placement.is_default())
+    {
+        pages = PAGES_NORMAL;
+        memory = cube_map_pages(padded, CubePlacement());
+    }
+    if (memory == nullptr)
+    {
+        num_bytes = 0;
+        throw std::bad_alloc();
+    }
+    mapped_bytes = padded;
+
+    bytes = static_cast<std::atomic<uint8_t>*>(memory);
+    for (long ii = 0; ii < padded; ++ii)
+    {
+        new (&bytes[ii]) std::atomic<uint8_t>((PRUNE_UNVISITED << 4) |
+                                              PRUNE_UNVISITED);
+    }
 }
 
 /******************************************************************************
-* Function:  CubePrune::fill
+* Function:  CubeNibbleTable::clear
 *
-* Purpose:   Fill in the entries in this pruning table.
+* Purpose:   Releases the storage.
 *
 * Params:    None.
 *
 * Returns:   Nothing.
 *
-* Operation: Starting from the solved position, at depth 0, perform a
-*            breadth-first search of the shared coordinate space and store the
-*            depth from solved of each position.
+* Operation: Used once a table has been loaded from a file instead.
 ******************************************************************************/
-void CubePrune::fill()
+void CubeNibbleTable::clear()
 {
-    // Local variables
-    std::pair<int, int> curr_position, next_position;
-    int depth;
+    cube_unmap_pages(bytes, mapped_bytes, pages);
+    bytes = nullptr;
+    num_bytes = 0;
+    mapped_bytes = 0;
+}
 
-    // Set up a deque which we will use to perform the breadth-first search.
-    std::deque<std::pair<int, int>> bfs;
+/******************************************************************************
+* Function:  CubeNibbleTable::size
+*
+* Purpose:   Getter for the size of the storage.
+*
+* Params:    None.
+*
+* Returns:   The number of bytes of storage.
+*
+* Operation: Simply return the value.
+******************************************************************************/
+long CubeNibbleTable::size() const
+{
+    return num_bytes;
+}
+
+/******************************************************************************
+* Function:  CubeNibbleTable::data
+*
+* Purpose:   Gives the packed entries.
+*
+* Params:    None.
+*
+* Returns:   A pointer to the bytes of the table.
+*
+* Operation: Single-byte atomics have the same representation as the bytes
+*            they hold, so once no thread is writing the table any longer the
+*            storage can be read directly.
+******************************************************************************/
+const uint8_t* CubeNibbleTable::data() const
+{
+    return reinterpret_cast<const uint8_t*>(bytes);
+}
 
-    // Push the solved position onto the deque and record the depth of the
-    // solved position.
-    int solved_1 = transition_table_1->solved_pos();
-    int solved_2 = transition_table_2->solved_pos();
-    bfs.push_back(std::make_pair(solved_1, solved_2));
-    table[solved_1][solved_2] = 0;
+/******************************************************************************
+* CubePrune class implementation.
+******************************************************************************/
+
+/******************************************************************************
+* Function:  CubePrune::CubePrune
+*
+* Purpose:   Constructor for the CubePrune class.
+*
+* Params:    phase_desc    - Whether this pruning table is relevant in phase 1
+*                            or phase 2 of the two-phase algorithm.
+*            trans_table_1 - Pointers to the transition tables of the cube
+*            trans_table_2 - coordinates that this table is for.
+*
+* Returns:   Nothing.
+*
+* Operation: Stores the phase, the transition tables and their sizes. Space
+*            for the data is not allocated until the table is filled, since it
+*            may instead be loaded from a table file.
+******************************************************************************/
+CubePrune::CubePrune(int phase_desc, const CubeTrans* trans_table_1,
+                                     const CubeTrans* trans_table_2)
+{
+    phase = phase_desc;
+    transition_table_1 = trans_table_1;
+    transition_table_2 = trans_table_2;
+    size_1 = trans_table_1->size();
+    size_2 = trans_table_2->size();
+    table = nullptr;
+}
+
+/******************************************************************************
+* Function:  CubePrune::fill
+*
+* Purpose:   Fill in the entries in this pruning table.
+*
+* Params:    pool      - If set, each level of the search is spread over this
+*                        pool.
+*            placement - Which pages to put the entries on, and where.
+*
+* Returns:   Nothing.
+*
+* Operation: Starting from the solved position, at depth 0, runs a
+*            breadth-first search of the shared coordinate space one depth at
+*            a time, storing the depth from solved of each position. Positions
+*            not yet visited are marked with PRUNE_UNVISITED.
+*
+*            Each level scans the whole table in chunks, which are shared out
+*            over the pool. While few entries are filled, each entry at the
+*            current depth claims its unvisited neighbours. Once more than
+*            half are filled, it is cheaper to run backwards: each unvisited
+*            entry looks for a neighbour at the current depth, which works
+*            because the inverse of every allowed move is also allowed. No
+*            entry changes more than once, so the threads need nothing more
+*            than the atomic claims to agree on the result, which is the same
+*            as that of a sequential search.
+******************************************************************************/
+void CubePrune::fill(CubeThreadPool* pool, const CubePlacement& placement)
+{
+    long total = (long)size_1 * size_2;
+    storage.assign(total, placement);
+    table = storage.data();
 
     // Work out the available moves
-    if (phase == PHASE_1)
-    {
-        allowed_moves = cube_p1_allowed_moves[NUM_MOVES];
-    }
-    else if (phase == PHASE_2)
-    {
-        allowed_moves = cube_p2_allowed_moves[NUM_MOVES];
-    }
+    const CubeMoveList& moves = (phase == PHASE_1) ?
+                                cube_p1_allowed_moves[NUM_MOVES] :
+                                cube_p2_allowed_moves[NUM_MOVES];
+
+    // Record the depth of the solved position.
+    storage.claim((long)transition_table_1->solved_pos() * size_2 +
+                  transition_table_2->solved_pos(), 0);
+    long done = 1;
+    std::atomic<long> added(1);
 
-    // Perform the breadth-first search
-    while (!bfs.empty())
+    for (int depth = 0; done < total && added > 0; ++depth)
     {
-        // Get the top position from the deque, and record the depths of all of
-        // its children positions.
-        curr_position = bfs.front();
-        depth = table[curr_position.first][curr_position.second];
-        bfs.pop_front();
+        bool backwards = (done > total / 2);
+        added = 0;
 
-        for (int move : allowed_moves)
+        cube_parallel_for(pool, total, PRUNE_FILL_CHUNK,
+                          [&](long begin, long end)
         {
-            next_position = std::make_pair(
-                            (*transition_table_1)(curr_position.first,  move),
-                            (*transition_table_2)(curr_position.second, move));
-
-            if (table[next_position.first][next_position.second] == -1)
+            long count = 0;
+            for (long index = begin; index < end; ++index)
             {
-                bfs.push_back(next_position);
-                table[next_position.first][next_position.second] = depth + 1;
+                int value = storage.get(index);
+                if (backwards ? (value != PRUNE_UNVISITED)
+                              : (value != depth))
+                {
+                    continue;
+                }
+
+                int coord_1 = index / size_2;
+                int coord_2 = index % size_2;
+                for (int move : moves)
+                {
+                    long next = (long)(*transition_table_1)(coord_1, move) *
+                                size_2 + (*transition_table_2)(coord_2, move);
+
+                    if (backwards && storage.get(next) == depth)
+                    {
+                        count += storage.claim(index, depth + 1);
+                        break;
+                    }
+                    if (!backwards)
+                    {
+                        count += storage.claim(next, depth + 1);
+                    }
+                }
             }
-        }
+            added += count;
+        });
+
+        done += added;
     }
 }
+
+/******************************************************************************
+* Function:  CubePrune::save
+*
+* Purpose:   Adds this pruning table to a table file.
+*
+* Params:    writer - The table file being built.
+*
+* Returns:   Nothing.
+*
+* Operation: The packed entries are recorded as is, along with the table
+*            dimensions.
+******************************************************************************/
+void CubePrune::save(CubeTableWriter& writer) const
+{
+    writer.add_section(SECTION_PRUNE, size_1, size_2, 0,
+                       table, ((long)size_1 * size_2 + 1) / 2);
+}
+
+/******************************************************************************
+* Function:  CubePrune::matches
+*
+* Purpose:   Checks whether a section of a table file holds this table.
+*
+* Params:    file  - A validated table file.
+*            index - Which section of the file to check.
+*
+* Returns:   true if the section type and dimensions match this table.
+*
+* Operation: Compares the section descriptor against this table.
+******************************************************************************/
+bool CubePrune::matches(const CubeTableFile& file, int index) const
+{
+    const CubeTableSection& section = file.section(index);
+    return section.type == SECTION_PRUNE &&
+           section.rows == (uint32_t)size_1 &&
+           section.cols == (uint32_t)size_2 &&
+           section.bytes == ((uint64_t)size_1 * size_2 + 1) / 2;
+}
+
+/******************************************************************************
+* Function:  CubePrune::load
+*
+* Purpose:   Points this pruning table at a section of a table file.
+*
+* Params:    file  - A validated table file, which must stay open for as long
+*                    as this table is in use.
+*            index - Which section of the file holds this table. The caller
+*                    must have checked it with matches.
+*
+* Returns:   Nothing.
+*
+* Operation: The packed entries are used directly from the mapping rather than
+*            being copied.
+******************************************************************************/
+void CubePrune::load(const CubeTableFile& file, int index)
+{
+    storage.clear();
+    table = (const uint8_t*)file.section_data(index);
+}
@@ -0,0 +1,251 @@
+/******************************************************************************
+* File:    cuberegistry.cpp
+*
+* Purpose: Implementation of the CubeTableRegistry class, which makes the
+*          solver tables ready on demand.
+******************************************************************************/
+
+/******************************************************************************
+* Dependencies
+******************************************************************************/
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include <cubepool.h>
+#include <cuberegistry.h>
+#include <cubetables.h>
+
+/******************************************************************************
+* Constants
+*
+* The tables each table is built from, which must be ready before it is
+* generated.
+******************************************************************************/
+static const uint32_t table_deps[NUM_SOLVER_TABLES] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 0,
+    TABLE_BIT(TABLE_CO_TRANS) | TABLE_BIT(TABLE_EO_TRANS),
+    TABLE_BIT(TABLE_CO_TRANS) | TABLE_BIT(TABLE_UD_UNSORTED_TRANS),
+    TABLE_BIT(TABLE_EO_TRANS) | TABLE_BIT(TABLE_UD_UNSORTED_TRANS),
+    TABLE_BIT(TABLE_EP_TRANS) | TABLE_BIT(TABLE_UD_PERM_TRANS),
+    TABLE_BIT(TABLE_CP_TRANS) | TABLE_BIT(TABLE_UD_PERM_TRANS),
+    TABLE_BIT(TABLE_CO_TRANS),
+    TABLE_BIT(TABLE_EP_TRANS),
+    TABLE_BIT(TABLE_CO_TRANS) | TABLE_BIT(TABLE_PHASE1)};
+
+/******************************************************************************
+* The order in which warm_up makes the tables ready: those read in phase 1
+* first, since every query needs them, then the rest of those read by
+* CubeSolver, and the optimal solver's table last.
+******************************************************************************/
+static const SolverTableId warm_order[NUM_SOLVER_TABLES] = {
+    TABLE_CO_TRANS, TABLE_EO_TRANS, TABLE_UD_UNSORTED_TRANS,
+    TABLE_CO_EO_PRUNE, TABLE_CO_UD_PRUNE, TABLE_EO_UD_PRUNE, TABLE_PHASE1,
+    TABLE_CP_TRANS, TABLE_UD_SORTED_TRANS, TABLE_RL_SORTED_TRANS,
+    TABLE_FB_SORTED_TRANS, TABLE_EP_TRANS, TABLE_UD_PERM_TRANS,
+    TABLE_EP_UD_PRUNE, TABLE_CP_UD_PRUNE, TABLE_PHASE2, TABLE_CORNER};
+
+/******************************************************************************
+* CubeTableRegistry class implementation
+******************************************************************************/
+
+/******************************************************************************
+* Function:  CubeTableRegistry::CubeTableRegistry
+*
+* Purpose:   Constructor for the CubeTableRegistry class.
+*
+* Params:    table_path    - The table file to load from, or create.
+*            table_options - Which optional tables to build.
+*
+* Returns:   Nothing.
+*
+* Operation: Sets up the tables, empty. Tables which the options do not
+*            enable count as ready from the start, so that asking for them
+*            costs nothing. Nothing is read or generated until a table is
+*            first asked for.
+******************************************************************************/
+CubeTableRegistry::CubeTableRegistry(const std::string& table_path,
+                                     const TableOptions& table_options)
+    : path(table_path), tables(table_options), loaded(false), ready_mask(0),
+      remaining(0)
+{
+    for (int table = 0; table < NUM_SOLVER_TABLES; ++table)
+    {
+        if (tables.uses_table((SolverTableId)table))
+        {
+            ++remaining;
+        }
+        else
+        {
+            ready_mask |= TABLE_BIT(table);
+        }
+    }
+}
+
+/******************************************************************************
+* Function:  CubeTableRegistry::~CubeTableRegistry
+*
+* Purpose:   Destructor for the CubeTableRegistry class.
+*
+* Params:    None.
+*
+* Returns:   Nothing.
+*
+* Operation: Waits for the warm-up thread, if it was started, since it is
+*            still using the tables.
+******************************************************************************/
+CubeTableRegistry::~CubeTableRegistry()
+{
+    if (warm_thread.joinable())
+    {
+        warm_thread.join();
+    }
+}
+
+/******************************************************************************
+* Function:  CubeTableRegistry::load
+*
+* Purpose:   Tries to load every table from the table file.
+*
+* Params:    None.
+*
+* Returns:   Nothing.
+*
+* Operation: Run once, before any table is generated. If the file loads,
+*            every table is ready. If not, a pool with one thread per core
+*            is created to generate them on.
+******************************************************************************/
+void CubeTableRegistry::load()
+{
+    loaded = tables.load(path);
+    if (loaded)
+    {
+        ready_mask.store(TABLES_ALL, std::memory_order_release);
+    }
+    else
+    {
+        pool.reset(new CubeThreadPool());
+    }
+}
+
+/******************************************************************************
+* Function:  CubeTableRegistry::make_ready
+*
+* Purpose:   Makes one table ready, if it is not already.
+*
+* Params:    table - The table, which must be enabled by the options.
+*
+* Returns:   Nothing, once the table is ready.
+*
+* Operation: The file is tried first, once. Then, under the table's own flag,
+*            the tables it is built from are made ready and the table is
+*            generated. A thread asking for a table being generated by
+*            another waits for it to finish; tables are never generated
+*            twice. Whichever thread generates the last table writes the
+*            file.
+******************************************************************************/
+void CubeTableRegistry::make_ready(SolverTableId table)
+{
+    std::call_once(load_once, [this] { load(); });
+    if (loaded)
+    {
+        return;
+    }
+
+    std::call_once(table_once[table], [this, table]
+    {
+        for (int dep = 0; dep < NUM_SOLVER_TABLES; ++dep)
+        {
+            if ((table_deps[table] >> dep) & 1)
+            {
+                make_ready((SolverTableId)dep);
+            }
+        }
+
+        tables.fill_table(table, pool.get());
+        ready_mask.fetch_or(TABLE_BIT(table), std::memory_order_release);
+        if (--remaining == 0)
+        {
+            tables.save(path);
+        }
+    });
+}
+
+/******************************************************************************
+* Function:  CubeTableRegistry::require
+*
+* Purpose:   Makes a set of tables ready.
+*
+* Params:    needs - The tables, as a mask of SolverTableId bits, such as
+*                    TABLES_SOLVER.
+*
+* Returns:   The tables, which may be read for everything in needs. Other
+*            tables may not be ready yet.
+*
+* Operation: Tables already ready are skipped without taking any lock. Each
+*            of the others is made ready in turn, generating it on the
+*            calling thread and the pool if no other thread has started on
+*            it.
+******************************************************************************/
+const SolverTables& CubeTableRegistry::require(uint32_t needs)
+{
+    for (int table = 0; table < NUM_SOLVER_TABLES; ++table)
+    {
+        uint32_t ready = ready_mask.load(std::memory_order_acquire);
+        if (((needs & ~ready) >> table) & 1)
+        {
+            make_ready((SolverTableId)table);
+        }
+    }
+    return tables;
+}
+
+/******************************************************************************
+* Function:  CubeTableRegistry::is_ready
+*
+* Purpose:   Tells whether a set of tables is ready, without waiting.
+*
+* Params:    needs - The tables, as a mask of SolverTableId bits.
+*
+* Returns:   true if require would return straight away.
+*
+* Operation: Checks the mask of ready tables.
+******************************************************************************/
+bool CubeTableRegistry::is_ready(uint32_t needs) const
+{
+    return (ready_mask.load(std::memory_order_acquire) & needs) == needs;
+}
+
+/******************************************************************************
+* Function:  CubeTableRegistry::warm_up
+*
+* Purpose:   Starts making every table ready in the background.
+*
+* Params:    None.
+*
+* Returns:   Nothing, straight away.
+*
+* Operation: Starts a thread which makes each table ready in warm_order. It
+*            shares the flags of require, so a table which a query is already
+*            generating is waited for rather than generated again, and a
+*            query arriving while the thread is generating a table it needs
+*            waits for that table alone. Calling this again does nothing.
+******************************************************************************/
+void CubeTableRegistry::warm_up()
+{
+    if (warm_thread.joinable())
+    {
+        return;
+    }
+
+    warm_thread = std::thread([this]
+    {
+        for (SolverTableId table : warm_order)
+        {
+            require(TABLE_BIT(table));
+        }
+    });
+}
@@ -0,0 +1,533 @@
+/******************************************************************************
+* File:    cubesolcache.cpp
+*
+* Purpose: Implementation of the solution cache, and of the canonical form of
+*          a position by which it is keyed.
+******************************************************************************/
+
+/******************************************************************************
+* Dependencies
+******************************************************************************/
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include <cube.h>
+#include <cubecache.h>
+#include <cubesolcache.h>
+#include <cubesolver.h>
+#include <cubesym.h>
+#include <cubetables.h>
+
+/******************************************************************************
+* Constants
+*
+* The number of values taken by each coordinate packed into a state.
+******************************************************************************/
+#define STATE_NUM_TWIST  2187
+#define STATE_FLIP_BITS  11
+#define STATE_NUM_SORTED 11880
+
+/******************************************************************************
+* Helper functions
+******************************************************************************/
+
+/******************************************************************************
+* Function:  encode_corners
+*
+* Purpose:   Packs the corners and edge orientation of a position into the
+*            first word of its state.
+*
+* Params:    cube - The position.
+*
+* Returns:   The word.
+*
+* Operation: Corner permutation, then corner orientation, then edge
+*            orientation, as a mixed-radix number. It is the more significant
+*            word, and the cheaper to work out, so most candidates for the
+*            canonical form are ruled out by it alone.
+******************************************************************************/
+static uint64_t encode_corners(Cube& cube)
+{
+    uint64_t corners = (uint64_t)cube.coord_corner_permutation() *
+                       STATE_NUM_TWIST + cube.coord_corner_orientation();
+    return (corners << STATE_FLIP_BITS) | cube.coord_edge_orientation();
+}
+
+/******************************************************************************
+* Function:  encode_edges
+*
+* Purpose:   Packs the edge permutation of a position into the second word of
+*            its state.
+*
+* Params:    cube - The position.
+*
+* Returns:   The word.
+*
+* Operation: The three sorted slice coordinates between them fix where every
+*            edge is, and fit comfortably in a word side by side.
+******************************************************************************/
+static uint64_t encode_edges(Cube& cube)
+{
+    CubeCoords coords = cube.coords();
+    return ((uint64_t)coords.ud_sorted * STATE_NUM_SORTED +
+            coords.rl_sorted) * STATE_NUM_SORTED + coords.fb_sorted;
+}
+
+/******************************************************************************
+* Function:  invert_moves
+*
+* Purpose:   Turns a solution of a position into a solution of its inverse.
+*
+* Params:    moves - The solution, which is changed in place.
+*
+* Returns:   Nothing.
+*
+* Operation: Reverses the moves and undoes each one, as the solver does for
+*            the inverse orientations of a multi-axis solve.
+******************************************************************************/
+static void invert_moves(std::vector<int>& moves)
+{
+    std::reverse(moves.begin(), moves.end());
+    for (int& move : moves)
+    {
+        move = 3 * (move / 3) + (2 - move % 3);
+    }
+}
+
+/******************************************************************************
+* Function:  cube_canonical
+*
+* Purpose:   Works out the canonical form of a position.
+*
+* Params:    cube - The position.
+*
+* Returns:   The canonical form, and how the position maps onto it.
+*
+* Operation: Conjugates the cube and its inverse by every symmetry and keeps
+*            the least encoding, comparing the first word before the second
+*            is worked out. The key is then hashed from the winning state, so
+*            every position sharing the form gets the same key.
+******************************************************************************/
+CubeCanonical cube_canonical(const Cube& cube)
+{
+    CubeCanonical canonical = {{UINT64_MAX, UINT64_MAX}, 0, 0, false};
+    Cube inverse = cube.inverse();
+
+    for (int inv = 0; inv < 2; ++inv)
+    {
+        for (int sym = 0; sym < NUM_SYMS; ++sym)
+        {
+            Cube candidate = cube_conjugate(inv ? inverse : cube, sym);
+            uint64_t corners = encode_corners(candidate);
+            if (corners > canonical.state[0])
+            {
+                continue;
+            }
+
+            uint64_t edges = encode_edges(candidate);
+            if (corners < canonical.state[0] || edges < canonical.state[1])
+            {
+                canonical.state[0] = corners;
+                canonical.state[1] = edges;
+                canonical.sym = sym;
+                canonical.inverse = (inv == 1);
+            }
+        }
+    }
+
+    canonical.key = cube_checksum(canonical.state, sizeof(canonical.state));
+    return canonical;
+}
+
+/******************************************************************************
+* Function:  cube_to_canonical
+*
+* Purpose:   Turns a solution of a position into one of its canonical form.
+*
+* Params:    canonical - The canonical form of the position.
+*            moves     - A solution of the position.
+*
+* Returns:   The solution of the canonical position.
+*
+* Operation: Inverts the solution if the canonical form came from the
+*            inverse, then conjugates each move by the symmetry.
+******************************************************************************/
+std::vector<int> cube_to_canonical(const CubeCanonical& canonical,
+                                   const std::vector<int>& moves)
+{
+    std::vector<int> result = moves;
+    if (canonical.inverse)
+    {
+        invert_moves(result);
+    }
+    for (int& move : result)
+    {
+        move = cube_conjugate_move(move, canonical.sym);
+    }
+    return result;
+}
+
+/******************************************************************************
+* Function:  cube_from_canonical
+*
+* Purpose:   Turns a solution of a canonical position back into one of a
+*            position with that canonical form.
+*
+* Params:    canonical - The canonical form of the position.
+*            moves     - A solution of the canonical position.
+*
+* Returns:   The solution of the position.
+*
+* Operation: The reverse of cube_to_canonical: conjugates each move by the
+*            inverse symmetry, then inverts the solution if the canonical
+*            form came from the inverse.
+******************************************************************************/
+std::vector<int> cube_from_canonical(const CubeCanonical& canonical,
+                                     const std::vector<int>& moves)
+{
+    int sym_inverse = cube_sym_inverse(canonical.sym);
+    std::vector<int> result = moves;
+    for (int& move : result)
+    {
+        move = cube_conjugate_move(move, sym_inverse);
+    }
+    if (canonical.inverse)
+    {
+        invert_moves(result);
+    }
+    return result;
+}
+
+/******************************************************************************
+* CubeSolutionCache class implementation
+******************************************************************************/
+
+/******************************************************************************
+* Function:  CubeSolutionCache::CubeSolutionCache
+*
+* Purpose:   Constructor for the CubeSolutionCache class.
+*
+* Params:    capacity    - The most positions the cache should hold.
+*            shard_count - How many shards to spread them over. More shards
+*                          mean less waiting on locks when many threads use
+*                          the cache.
+*
+* Returns:   Nothing.
+*
+* Operation: Creates empty shards, sharing out the capacity evenly and giving
+*            every shard room for at least one entry.
+******************************************************************************/
+CubeSolutionCache::CubeSolutionCache(size_t capacity, int shard_count)
+    : hit_count(0), miss_count(0)
+{
+    num_shards = std::max(shard_count, 1);
+    shard_capacity = std::max<size_t>((capacity + num_shards - 1) / num_shards,
+                                      1);
+    shards.reset(new Shard[num_shards]);
+}
+
+/******************************************************************************
+* Function:  CubeSolutionCache::shard_for
+*
+* Purpose:   Finds the shard holding a key.
+*
+* Params:    key - The key of a canonical form.
+*
+* Returns:   The shard.
+*
+* Operation: Uses the top half of the key, since the bottom half picks the
+*            bucket within the shard's index.
+******************************************************************************/
+CubeSolutionCache::Shard& CubeSolutionCache::shard_for(uint64_t key)
+{
+    return shards[(key >> 32) % num_shards];
+}
+
+/******************************************************************************
+* Function:  CubeSolutionCache::lookup
+*
+* Purpose:   Looks up the solution held for a position.
+*
+* Params:    cube     - The position.
+*            solution - Set to the solution held, for this position, if
+*                       there is one.
+*
+* Returns:   true if the cache held a solution.
+*
+* Operation: Works out the canonical form and looks that up.
+******************************************************************************/
+bool CubeSolutionCache::lookup(const Cube& cube, CubeCachedSolution& solution)
+{
+    return lookup(cube_canonical(cube), solution);
+}
+
+/******************************************************************************
+* Function:  CubeSolutionCache::lookup
+*
+* Purpose:   Looks up the solution held for a position whose canonical form
+*            has already been worked out.
+*
+* Params:    canonical - The canonical form of the position.
+*            solution  - Set to the solution held, for this position, if
+*                        there is one.
+*
+* Returns:   true if the cache held a solution.
+*
+* Operation: Under the shard lock, finds the entry, checks its full state,
+*            moves it to the front of the shard as the most recently used,
+*            and copies out its moves. They are conjugated back to the
+*            position once the lock has been released.
+******************************************************************************/
+bool CubeSolutionCache::lookup(const CubeCanonical& canonical,
+                               CubeCachedSolution& solution)
+{
+    Shard& shard = shard_for(canonical.key);
+    std::vector<int> moves;
+    int bound;
+    {
+        std::lock_guard<std::mutex> guard(shard.lock);
+        auto found = shard.index.find(canonical.key);
+        if (found == shard.index.end() ||
+            found->second->state[0] != canonical.state[0] ||
+            found->second->state[1] != canonical.state[1])
+        {
+            ++miss_count;
+            return false;
+        }
+
+        shard.entries.splice(shard.entries.begin(), shard.entries,
+                             found->second);
+        const Entry& entry = *found->second;
+        moves.assign(entry.moves, entry.moves + entry.length);
+        bound = entry.bound;
+    }
+
+    ++hit_count;
+    solution.moves = cube_from_canonical(canonical, moves);
+    solution.bound = bound;
+    return true;
+}
+
+/******************************************************************************
+* Function:  CubeSolutionCache::store
+*
+* Purpose:   Records a solution of a position.
+*
+* Params:    cube  - The position.
+*            moves - A solution of the position.
+*            bound - A length which no solution is known to be shorter than,
+*                    such as CubeSolver::lower_bound gives.
+*
+* Returns:   true if the cache now holds the solution, or one at least as
+*            short; false if it is too long to be held.
+*
+* Operation: Works out the canonical form and stores against that.
+******************************************************************************/
+bool CubeSolutionCache::store(const Cube& cube, const std::vector<int>& moves,
+                              int bound)
+{
+    return store(cube_canonical(cube), moves, bound);
+}
+
+/******************************************************************************
+* Function:  CubeSolutionCache::store
+*
+* Purpose:   Records a solution of a position whose canonical form has
+*            already been worked out.
+*
+* Params:    canonical - The canonical form of the position.
+*            moves     - A solution of the position.
+*            bound     - A length which no solution is known to be shorter
+*                        than.
+*
+* Returns:   true if the cache now holds the solution, or one at least as
+*            short; false if it is too long to be held.
+*
+* Operation: Conjugates the solution onto the canonical position before
+*            taking the shard lock. An entry already held for the position
+*            keeps the shorter solution and the higher bound, so several
+*            threads storing at once can only make it better. An entry
+*            whose key collides but whose state differs is replaced. New
+*            entries go at the front, evicting from the back once the shard
+*            is full.
+******************************************************************************/
+bool CubeSolutionCache::store(const CubeCanonical& canonical,
+                              const std::vector<int>& moves, int bound)
+{
+    if (moves.size() > SOLCACHE_MAX_MOVES)
+    {
+        return false;
+    }
+
+    Entry entry;
+    entry.state[0] = canonical.state[0];
+    entry.state[1] = canonical.state[1];
+    std::vector<int> canonical_moves = cube_to_canonical(canonical, moves);
+    std::copy(canonical_moves.begin(), canonical_moves.end(), entry.moves);
+    entry.length = moves.size();
+    entry.bound = std::max(0, std::min(bound, (int)entry.length));
+
+    Shard& shard = shard_for(canonical.key);
+    std::lock_guard<std::mutex> guard(shard.lock);
+    auto found = shard.index.find(canonical.key);
+    if (found != shard.index.end())
+    {
+        Entry& held = *found->second;
+        if (held.state[0] == entry.state[0] &&
+            held.state[1] == entry.state[1])
+        {
+            entry.bound = std::max(entry.bound, held.bound);
+            if (held.length <= entry.length)
+            {
+                std::copy(held.moves, held.moves + held.length, entry.moves);
+                entry.length = held.length;
+            }
+        }
+        held = entry;
+        shard.entries.splice(shard.entries.begin(), shard.entries,
+                             found->second);
+        return true;
+    }
+
+    shard.entries.push_front(entry);
+    shard.index[canonical.key] = shard.entries.begin();
+    if (shard.entries.size() > shard_capacity)
+    {
+        shard.index.erase(cube_checksum(shard.entries.back().state,
+                                        sizeof(entry.state)));
+        shard.entries.pop_back();
+    }
+    return true;
+}
+
+/******************************************************************************
+* Function:  CubeSolutionCache::solve
+*
+* Purpose:   Solves a position, going through the cache.
+*
+* Params:    tables  - The tables to search with.
+*            cube    - The position to solve.
+*            options - How to solve the position if it has to be searched.
+*
+* Returns:   The result, which for a hit records no nodes or improvements.
+*
+* Operation: A cached solution is returned at once if it is short enough to
+*            meet the target, or proved optimal. Otherwise the cube is
+*            searched, and the better of the two solutions is both stored and
+*            returned, along with the bound the search proved.
+******************************************************************************/
+SolveResult CubeSolutionCache::solve(const SolverTables& tables,
+                                     const Cube& cube,
+                                     const SolveOptions& options)
+{
+    CubeCanonical canonical = cube_canonical(cube);
+    CubeCachedSolution cached;
+    bool hit = lookup(canonical, cached);
+    int cached_length = cached.moves.size();
+
+    if (hit && (cached_length <= options.target_length ||
+                cached_length <= cached.bound))
+    {
+        SolveResult result;
+        result.moves = cached.moves;
+        result.length = cached_length;
+        return result;
+    }
+
+    CubeSolver solver(tables, cube);
+    SolveResult result = solver.solve(options);
+    if (hit && (result.length < 0 || cached_length < result.length))
+    {
+        result.moves = cached.moves;
+        result.length = cached_length;
+    }
+    if (result.length >= 0)
+    {
+        store(canonical, result.moves,
+              std::max(solver.lower_bound(), hit ? cached.bound : 0));
+    }
+    return result;
+}
+
+/******************************************************************************
+* Function:  CubeSolutionCache::clear
+*
+* Purpose:   Empties the cache.
+*
+* Params:    None.
+*
+* Returns:   Nothing.
+*
+* Operation: Clears each shard under its lock. The hit and miss counts are
+*            kept.
+******************************************************************************/
+void CubeSolutionCache::clear()
+{
+    for (int ii = 0; ii < num_shards; ++ii)
+    {
+        std::lock_guard<std::mutex> guard(shards[ii].lock);
+        shards[ii].index.clear();
+        shards[ii].entries.clear();
+    }
+}
+
+/******************************************************************************
+* Function:  CubeSolutionCache::size
+*
+* Purpose:   Counts the positions held.
+*
+* Params:    None.
+*
+* Returns:   The number of entries over every shard.
+*
+* Operation: Takes each shard lock in turn, so the total may be slightly out
+*            of date if other threads are storing at the same time.
+******************************************************************************/
+size_t CubeSolutionCache::size()
+{
+    size_t total = 0;
+    for (int ii = 0; ii < num_shards; ++ii)
+    {
+        std::lock_guard<std::mutex> guard(shards[ii].lock);
+        total += shards[ii].entries.size();
+    }
+    return total;
+}
+
+/******************************************************************************
+* Function:  CubeSolutionCache::hits
+*
+* Purpose:   Counts the lookups which found a solution.
+*
+* Params:    None.
+*
+* Returns:   The number of hits since the cache was created.
+*
+* Operation: Reads the shared counter.
+******************************************************************************/
+long long CubeSolutionCache::hits() const
+{
+    return hit_count;
+}
+
+/******************************************************************************
+* Function:  CubeSolutionCache::misses
+*
+* Purpose:   Counts the lookups which found nothing.
+*
+* Params:    None.
+*
+* Returns:   The number of misses since the cache was created.
+*
+* Operation: Reads the shared counter.
+******************************************************************************/
+long long CubeSolutionCache::misses() const
+{
+    return miss_count;
+}
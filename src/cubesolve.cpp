@@ -0,0 +1,625 @@
+/******************************************************************************
+* File:    cubesolve.cpp
+*
+* Purpose: Command-line solver for files of scrambles. Reads one cube per
+*          line, as facelets or as a move sequence, solves the cubes in
+*          parallel and writes one result per cube, in input order, as JSON
+*          lines or compact binary records.
+******************************************************************************/
+
+/******************************************************************************
+* Dependencies
+******************************************************************************/
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include <cube.h>
+#include <cubeoptimal.h>
+#include <cubesolver.h>
+#include <cubetables.h>
+
+/******************************************************************************
+* Constants
+*
+* SOLVE_IO_BUFFER  - The size of the input buffer, and how much output is
+*                    gathered before it is written.
+* SOLVE_WINDOW     - The default number of cubes which may be in the
+*                    pipeline at once for each solving thread, counting those
+*                    queued, being solved and waiting to be written in order.
+******************************************************************************/
+#define SOLVE_IO_BUFFER (1 << 20)
+#define SOLVE_WINDOW    16
+
+/******************************************************************************
+* The status byte which starts each binary record. A solved record is
+* followed by a length byte and that many move bytes, each a move number as
+* in cube.h; the others are followed by a zero length byte.
+******************************************************************************/
+enum {RECORD_SOLVED, RECORD_UNSOLVED, RECORD_INVALID};
+
+/******************************************************************************
+* The settings for one run, taken from the command line.
+******************************************************************************/
+struct SolveConfig
+{
+    std::string tables_path = "cubetables.dat";
+    std::string input_path;
+    std::string output_path;
+    bool binary = false;
+    bool line_buffered = false;
+    int threads = 0;
+    int window = 0;
+    long long node_limit = 5000000;
+    int target_length = 0;
+    double seconds = 0;
+    bool full_phase1 = false;
+    bool full_phase2 = false;
+    bool optimal = false;
+};
+
+/******************************************************************************
+* One cube on its way through the pipeline. A job is read into a slot of the
+* reorder window, solved there, then written once every earlier job has
+* been.
+*
+* line        - The line of the input the cube was read from, counting
+*               from 1.
+* cube        - The cube, if valid.
+* valid       - Whether the line described a solvable cube.
+* done        - Whether the job has been solved and may be written.
+* result      - The solution found.
+* lower_bound - For an optimal solve, the moves the cube is known to need.
+* seconds     - How long the solve took.
+******************************************************************************/
+struct SolveJob
+{
+    uint64_t line = 0;
+    Cube cube;
+    bool valid = false;
+    bool done = false;
+    SolveResult result;
+    int lower_bound = 0;
+    double seconds = 0;
+};
+
+/******************************************************************************
+* The state shared by the stages of the pipeline, all under one lock. Jobs
+* are numbered in input order; job n lives in slots[n % slots.size()].
+* Reading waits while the window is full, that is, until the oldest job has
+* been written, which bounds the memory used however large the input is.
+*
+* queue    - Jobs read but not yet claimed by a solving thread.
+* read     - How many jobs have been read.
+* written  - How many jobs have been written.
+* finished - Whether the input has been read to the end.
+******************************************************************************/
+struct SolvePipeline
+{
+    std::mutex lock;
+    std::condition_variable space;
+    std::condition_variable work;
+    std::condition_variable ready;
+    std::vector<SolveJob> slots;
+    std::deque<uint64_t> queue;
+    uint64_t read = 0;
+    uint64_t written = 0;
+    bool finished = false;
+};
+
+/******************************************************************************
+* Function:  parse_cube
+*
+* Purpose:   Reads a cube from one line of input.
+*
+* Params:    text - The line, without its line ending.
+*            cube - Receives the cube.
+*
+* Returns:   true if the line describes a cube which can be solved.
+*
+* Operation: A 54-character line is tried as facelets first. Anything else,
+*            or a line which is not valid facelets, is read as moves.
+******************************************************************************/
+static bool parse_cube(std::string_view text, Cube& cube)
+{
+    return (text.size() == 54 && Cube::from_facelets(text, cube)) ||
+           Cube::from_moves(text, cube);
+}
+
+/******************************************************************************
+* Function:  read_stage
+*
+* Purpose:   Reads the input into the pipeline.
+*
+* Params:    input    - The input, read to the end.
+*            pipeline - The pipeline.
+*
+* Returns:   Nothing.
+*
+* Operation: Reads a line at a time, reusing one buffer, so the input is never
+*            held in memory. Surrounding white space is ignored, and blank
+*            lines are skipped. Each line is parsed before the lock is taken,
+*            then waits for a free slot.
+******************************************************************************/
+static void read_stage(FILE* input, SolvePipeline& pipeline)
+{
+    char* buffer = nullptr;
+    size_t capacity = 0;
+    ssize_t size;
+    uint64_t line = 0;
+
+    while ((size = getline(&buffer, &capacity, input)) >= 0)
+    {
+        ++line;
+        std::string_view text(buffer, size);
+        size_t first = text.find_first_not_of(" \t\r\n");
+        if (first == std::string_view::npos)
+        {
+            continue;
+        }
+        text = text.substr(first, text.find_last_not_of(" \t\r\n") + 1 -
+                                  first);
+
+        Cube cube;
+        bool valid = parse_cube(text, cube);
+
+        std::unique_lock<std::mutex> guard(pipeline.lock);
+        pipeline.space.wait(guard, [&pipeline]
+        {
+            return pipeline.read - pipeline.written < pipeline.slots.size();
+        });
+
+        SolveJob& job = pipeline.slots[pipeline.read % pipeline.slots.size()];
+        job.line = line;
+        job.cube = cube;
+        job.valid = valid;
+        job.done = false;
+        pipeline.queue.push_back(pipeline.read++);
+        pipeline.work.notify_one();
+    }
+    std::free(buffer);
+
+    std::lock_guard<std::mutex> guard(pipeline.lock);
+    pipeline.finished = true;
+    pipeline.work.notify_all();
+    pipeline.ready.notify_all();
+}
+
+/******************************************************************************
+* Function:  solve_stage
+*
+* Purpose:   The loop run by each solving thread.
+*
+* Params:    tables   - The tables to search with.
+*            config   - The settings for the run.
+*            pipeline - The pipeline.
+*
+* Returns:   Nothing, once the input is finished and every job is claimed.
+*
+* Operation: Claims the oldest queued job and solves it outside the lock.
+*            Nothing else touches a claimed job's slot until it is marked
+*            done, so it is written without copying. Each cube is searched
+*            sequentially; the threads between them keep every core busy.
+******************************************************************************/
+static void solve_stage(const SolverTables& tables, const SolveConfig& config,
+                        SolvePipeline& pipeline)
+{
+    for (;;)
+    {
+        uint64_t index;
+        {
+            std::unique_lock<std::mutex> guard(pipeline.lock);
+            pipeline.work.wait(guard, [&pipeline]
+            {
+                return !pipeline.queue.empty() || pipeline.finished;
+            });
+            if (pipeline.queue.empty())
+            {
+                return;
+            }
+            index = pipeline.queue.front();
+            pipeline.queue.pop_front();
+        }
+
+        SolveJob& job = pipeline.slots[index % pipeline.slots.size()];
+        job.result = SolveResult();
+        job.lower_bound = 0;
+        auto start = std::chrono::steady_clock::now();
+        if (job.valid)
+        {
+            SolveOptions options;
+            options.node_limit = config.node_limit;
+            options.target_length = config.target_length;
+            if (config.seconds > 0)
+            {
+                options.deadline = start +
+                                   std::chrono::duration_cast<
+                                       std::chrono::steady_clock::duration>(
+                                       std::chrono::duration<double>(
+                                           config.seconds));
+            }
+
+            if (config.optimal)
+            {
+                OptimalSolver solver(tables, job.cube);
+                job.result = solver.solve(options);
+                job.lower_bound = solver.lower_bound();
+            }
+            else
+            {
+                CubeSolver solver(tables, job.cube);
+                job.result = solver.solve(options);
+            }
+        }
+        job.seconds = std::chrono::duration<double>(
+                          std::chrono::steady_clock::now() - start).count();
+
+        std::lock_guard<std::mutex> guard(pipeline.lock);
+        job.done = true;
+        if (index == pipeline.written)
+        {
+            pipeline.ready.notify_one();
+        }
+    }
+}
+
+/******************************************************************************
+* Function:  format_json
+*
+* Purpose:   Appends the JSON line for a job to the output.
+*
+* Params:    job     - The job, which has been solved.
+*            optimal - Whether the run uses the optimal solver, in which case
+*                      the proved lower bound is included.
+*            out     - The output gathered so far.
+*
+* Returns:   Nothing.
+*
+* Operation: The moves are formatted straight into the output with
+*            cube_format_moves, dropping the trailing space.
+******************************************************************************/
+static void format_json(const SolveJob& job, bool optimal, std::string& out)
+{
+    char text[128];
+    std::snprintf(text, sizeof(text), "{\"line\": %llu",
+                  (unsigned long long)job.line);
+    out += text;
+    if (!job.valid)
+    {
+        out += ", \"error\": \"invalid cube\"}\n";
+        return;
+    }
+
+    const SolveResult& result = job.result;
+    std::snprintf(text, sizeof(text), ", \"length\": %d, \"moves\": ",
+                  result.length);
+    out += text;
+    if (result.length < 0)
+    {
+        out += "null";
+    }
+    else
+    {
+        size_t start = out.size();
+        out.resize(start + 1 + 3 * result.moves.size());
+        out[start] = '"';
+        size_t written = cube_format_moves(result.moves.data(),
+                                           result.moves.size(),
+                                           &out[start + 1]);
+        out.resize(start + 1 + (written > 0 ? written - 1 : 0));
+        out += '"';
+    }
+    if (optimal)
+    {
+        std::snprintf(text, sizeof(text), ", \"lower_bound\": %d",
+                      job.lower_bound);
+        out += text;
+    }
+    std::snprintf(text, sizeof(text),
+                  ", \"nodes\": %lld, \"seconds\": %.6g}\n", result.nodes,
+                  job.seconds);
+    out += text;
+}
+
+/******************************************************************************
+* Function:  format_binary
+*
+* Purpose:   Appends the binary record for a job to the output.
+*
+* Params:    job - The job, which has been solved.
+*            out - The output gathered so far.
+*
+* Returns:   Nothing.
+*
+* Operation: Writes the status byte, the length byte and the moves, as laid
+*            out above the record status constants.
+******************************************************************************/
+static void format_binary(const SolveJob& job, std::string& out)
+{
+    if (!job.valid || job.result.length < 0)
+    {
+        out += (char)(job.valid ? RECORD_UNSOLVED : RECORD_INVALID);
+        out += (char)0;
+        return;
+    }
+
+    out += (char)RECORD_SOLVED;
+    out += (char)job.result.length;
+    for (int move : job.result.moves)
+    {
+        out += (char)move;
+    }
+}
+
+/******************************************************************************
+* Function:  write_stage
+*
+* Purpose:   Writes the results in input order.
+*
+* Params:    config   - The settings for the run.
+*            output   - Where to write the results.
+*            pipeline - The pipeline.
+*
+* Returns:   The number of cubes solved, or -1 if the output could not be
+*            written.
+*
+* Operation: Waits for the oldest unwritten job to be done, however many
+*            later ones have finished first, formats it, and frees its slot
+*            for the reader. Output is gathered in a buffer and written in
+*            large blocks, and only flushed at the end, unless it is line
+*            buffered, when each result is flushed as soon as it is
+*            formatted, for a consumer reading the output as it goes.
+******************************************************************************/
+static long long write_stage(const SolveConfig& config, FILE* output,
+                             SolvePipeline& pipeline)
+{
+    std::string out;
+    out.reserve(2 * SOLVE_IO_BUFFER);
+    long long solved = 0;
+    bool failed = false;
+
+    for (;;)
+    {
+        {
+            std::unique_lock<std::mutex> guard(pipeline.lock);
+            size_t slot = pipeline.written % pipeline.slots.size();
+            pipeline.ready.wait(guard, [&pipeline, slot]
+            {
+                return pipeline.written < pipeline.read ?
+                       pipeline.slots[slot].done : pipeline.finished;
+            });
+            if (pipeline.written == pipeline.read)
+            {
+                break;
+            }
+
+            const SolveJob& job = pipeline.slots[slot];
+            if (config.binary)
+            {
+                format_binary(job, out);
+            }
+            else
+            {
+                format_json(job, config.optimal, out);
+            }
+            solved += (job.valid && job.result.length >= 0);
+
+            ++pipeline.written;
+            pipeline.space.notify_one();
+        }
+
+        if (out.size() >= SOLVE_IO_BUFFER || config.line_buffered)
+        {
+            failed = failed ||
+                     std::fwrite(out.data(), 1, out.size(), output) !=
+                     out.size() ||
+                     (config.line_buffered && std::fflush(output) != 0);
+            out.clear();
+        }
+    }
+
+    failed = failed ||
+             std::fwrite(out.data(), 1, out.size(), output) != out.size() ||
+             std::fflush(output) != 0;
+    return failed ? -1 : solved;
+}
+
+/******************************************************************************
+* Function:  parse_args
+*
+* Purpose:   Reads the settings from the command line.
+*
+* Params:    argc, argv - The command line.
+*            config     - Receives the settings.
+*
+* Returns:   false if the command line is not understood.
+*
+* Operation: Every option other than the flags takes one value.
+******************************************************************************/
+static bool parse_args(int argc, char** argv, SolveConfig& config)
+{
+    for (int ii = 1; ii < argc; ++ii)
+    {
+        const char* arg = argv[ii];
+        const char* value = (ii + 1 < argc) ? argv[ii + 1] : nullptr;
+
+        if (!std::strcmp(arg, "--binary"))
+        {
+            config.binary = true;
+        }
+        else if (!std::strcmp(arg, "--line-buffered"))
+        {
+            config.line_buffered = true;
+        }
+        else if (!std::strcmp(arg, "--full-phase1"))
+        {
+            config.full_phase1 = true;
+        }
+        else if (!std::strcmp(arg, "--full-phase2"))
+        {
+            config.full_phase2 = true;
+        }
+        else if (!std::strcmp(arg, "--optimal"))
+        {
+            config.optimal = true;
+        }
+        else if (value == nullptr)
+        {
+            return false;
+        }
+        else if (!std::strcmp(arg, "--tables"))
+        {
+            config.tables_path = value;
+            ++ii;
+        }
+        else if (!std::strcmp(arg, "--input"))
+        {
+            config.input_path = value;
+            ++ii;
+        }
+        else if (!std::strcmp(arg, "--output"))
+        {
+            config.output_path = value;
+            ++ii;
+        }
+        else if (!std::strcmp(arg, "--threads"))
+        {
+            config.threads = std::atoi(value);
+            ++ii;
+        }
+        else if (!std::strcmp(arg, "--window"))
+        {
+            config.window = std::atoi(value);
+            ++ii;
+        }
+        else if (!std::strcmp(arg, "--nodes"))
+        {
+            config.node_limit = std::atoll(value);
+            ++ii;
+        }
+        else if (!std::strcmp(arg, "--target"))
+        {
+            config.target_length = std::atoi(value);
+            ++ii;
+        }
+        else if (!std::strcmp(arg, "--seconds"))
+        {
+            config.seconds = std::atof(value);
+            ++ii;
+        }
+        else
+        {
+            return false;
+        }
+    }
+
+    return config.threads >= 0 && config.window >= 0 &&
+           config.node_limit > 0 && config.seconds >= 0;
+}
+
+/******************************************************************************
+* Function:  main
+*
+* Purpose:   Solves every cube in the input.
+*
+* Params:    argc, argv - The command line; see the usage message.
+*
+* Returns:   0 on success, 1 if a file cannot be opened or written, 2 if the
+*            command line is not understood.
+*
+* Operation: Reads from standard input unless --input is given, and writes
+*            to standard output unless --output is given. Loads or builds the
+*            tables, then runs the reader and one solving thread per core
+*            (or --threads), writing the results on this thread. A summary
+*            goes to standard error.
+******************************************************************************/
+int main(int argc, char** argv)
+{
+    SolveConfig config;
+    if (!parse_args(argc, argv, config))
+    {
+        std::fprintf(stderr,
+                     "Usage: %s [--tables FILE] [--input FILE] "
+                     "[--output FILE] [--binary] [--line-buffered]\n"
+                     "       [--threads N] [--window N] [--nodes N] "
+                     "[--target N] [--seconds S]\n"
+                     "       [--full-phase1] [--full-phase2] "
+                     "[--optimal]\n", argv[0]);
+        return 2;
+    }
+
+    FILE* input = stdin;
+    if (!config.input_path.empty() &&
+        !(input = std::fopen(config.input_path.c_str(), "r")))
+    {
+        std::fprintf(stderr, "Cannot read %s\n", config.input_path.c_str());
+        return 1;
+    }
+    FILE* output = stdout;
+    if (!config.output_path.empty() &&
+        !(output = std::fopen(config.output_path.c_str(),
+                              config.binary ? "wb" : "w")))
+    {
+        std::fprintf(stderr, "Cannot write %s\n", config.output_path.c_str());
+        return 1;
+    }
+    std::setvbuf(input, nullptr, _IOFBF, SOLVE_IO_BUFFER);
+
+    TableOptions table_options;
+    table_options.full_phase1 = config.full_phase1;
+    table_options.full_phase2 = config.full_phase2;
+    table_options.optimal = config.optimal;
+    SolverTables tables(table_options);
+    if (!tables.init(config.tables_path))
+    {
+        std::fprintf(stderr, "Tables generated and cached in %s\n",
+                     config.tables_path.c_str());
+    }
+
+    int threads = (config.threads > 0) ? config.threads :
+                  std::max(1u, std::thread::hardware_concurrency());
+    SolvePipeline pipeline;
+    pipeline.slots.resize((config.window > 0) ? config.window :
+                                                SOLVE_WINDOW * threads);
+
+    auto start = std::chrono::steady_clock::now();
+    std::thread reader(read_stage, input, std::ref(pipeline));
+    std::vector<std::thread> solvers;
+    for (int ii = 0; ii < threads; ++ii)
+    {
+        solvers.emplace_back(solve_stage, std::cref(tables),
+                             std::cref(config), std::ref(pipeline));
+    }
+    long long solved = write_stage(config, output, pipeline);
+    reader.join();
+    for (std::thread& solver : solvers)
+    {
+        solver.join();
+    }
+    double seconds = std::chrono::duration<double>(
+                         std::chrono::steady_clock::now() - start).count();
+
+    std::fprintf(stderr, "Solved %lld of %llu cubes in %.3fs\n",
+                 solved < 0 ? 0 : solved,
+                 (unsigned long long)pipeline.written, seconds);
+    if (output != stdout && std::fclose(output) != 0)
+    {
+        solved = -1;
+    }
+    if (solved < 0)
+    {
+        std::fprintf(stderr, "Cannot write the results\n");
+        return 1;
+    }
+    return 0;
+}
@@ -9,331 +9,2314 @@
 * Dependencies
 ******************************************************************************/
 #include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <climits>
-#include <iostream>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
 #include <vector>
 
 #include <cube.h>
+#include <cubebatch.h>
+#include <cubemem.h>
 #include <cubephase.h>
+#include <cubepool.h>
+#include <cubesym.h>
 #include <cubetables.h>
 #include <cubesolver.h>
 
+/******************************************************************************
+* Statistics gathering. CUBE_STAT wraps each statement which updates the
+* statistics, so that none of them is compiled unless CUBE_STATS is defined.
+******************************************************************************/
+#ifdef CUBE_STATS
+#define CUBE_STAT(statement) statement
+#else
+#define CUBE_STAT(statement)
+#endif
+
+/******************************************************************************
+* Constants
+*
+* The most moves a search ever holds. Phase 1 never needs more than 12 moves
+* and phase 2 never more than 18, so the first solution found has at most 30,
+* and after that only shorter solutions are looked for.
+******************************************************************************/
+#define SEARCH_MAX_MOVES 32
+
+/******************************************************************************
+* Saved sessions start with a magic number and a format version, which must
+* match for a session to be loaded. Within a saved search, SESSION_NO_CURSOR
+* marks a level whose node has no list of moves in progress. Saved times
+* longer than SESSION_MAX_SECONDS, about 30 years, are rejected, keeping
+* clear of the range of the clock.
+******************************************************************************/
+#define SESSION_MAGIC 0x53455343u
+#define SESSION_VERSION 1
+#define SESSION_NO_CURSOR 0xFF
+#define SESSION_MAX_SECONDS 1e9
+
+/******************************************************************************
+* Helper functions
+******************************************************************************/
+
+/******************************************************************************
+* Function:  cube_format_moves
+*
+* Purpose:   Formats a sequence of moves in standard notation into a buffer.
+*
+* Params:    moves  - The moves to format.
+*            count  - How many moves there are.
+*            buffer - Where to write the text, which must have room for at
+*                     least 3 * count characters. No terminator is written.
+*
+* Returns:   The number of characters written.
+*
+* Operation: Writes the face letter of each move, then its suffix, if any,
+*            then a space, using lookup tables indexed by the move number.
+******************************************************************************/
+size_t cube_format_moves(const int* moves, size_t count, char* buffer)
+{
+    static constexpr char face_letters[] = "ULFRBD";
+    static constexpr char amount_suffix[] = " 2'";
+
+    char* out = buffer;
+    for (size_t ii = 0; ii < count; ++ii)
+    {
+        *out++ = face_letters[moves[ii] / 3];
+        if (moves[ii] % 3 != 0)
+        {
+            *out++ = amount_suffix[moves[ii] % 3];
+        }
+        *out++ = ' ';
+    }
+    return out - buffer;
+}
+
+/******************************************************************************
+* Function:  cube_solution_string
+*
+* Purpose:   Formats a sequence of moves in standard notation.
+*
+* Params:    moves - The moves to format.
+*
+* Returns:   A string such as "R U2 F' ", with each move followed by a space.
+*
+* Operation: Sizes the string for the longest possible text, formats into
+*            it, and trims it to the length actually written.
+******************************************************************************/
+std::string cube_solution_string(const std::vector<int>& moves)
+{
+    std::string str(3 * moves.size(), ' ');
+    str.resize(cube_format_moves(moves.data(), moves.size(), &str[0]));
+    return str;
+}
+
+/******************************************************************************
+* Function:  put_bytes
+*
+* Purpose:   Appends a number to a saved session.
+*
+* Params:    out   - The saved session.
+*            value - The number.
+*            bytes - How many bytes to write it in.
+*
+* Returns:   Nothing.
+*
+* Operation: Writes the bytes least significant first, so that sessions can
+*            be moved between machines.
+******************************************************************************/
+static void put_bytes(std::vector<uint8_t>& out, uint64_t value, int bytes)
+{
+    for (int ii = 0; ii < bytes; ++ii)
+    {
+        out.push_back((uint8_t)(value >> (8 * ii)));
+    }
+}
+
+/******************************************************************************
+* Function:  get_bytes
+*
+* Purpose:   Reads a number written by put_bytes.
+*
+* Params:    pos   - Where to read from, which is moved past the number.
+*            end   - The end of the saved session.
+*            bytes - How many bytes the number was written in.
+*            value - Set to the number.
+*
+* Returns:   true if the session was long enough to hold the number.
+*
+* Operation: Reassembles the bytes least significant first.
+******************************************************************************/
+static bool get_bytes(const uint8_t*& pos, const uint8_t* end, int bytes,
+                      uint64_t& value)
+{
+    if (end - pos < bytes)
+    {
+        return false;
+    }
+
+    value = 0;
+    for (int ii = 0; ii < bytes; ++ii)
+    {
+        value |= (uint64_t)*pos++ << (8 * ii);
+    }
+    return true;
+}
+
+/******************************************************************************
+* Function:  double_bits
+*
+* Purpose:   Gives the bit pattern of a time in seconds, for saving.
+*
+* Params:    seconds - The time.
+*
+* Returns:   The bits of the double.
+*
+* Operation: Copies the bytes, which is the defined way of doing so.
+******************************************************************************/
+static uint64_t double_bits(double seconds)
+{
+    uint64_t bits;
+    std::memcpy(&bits, &seconds, sizeof(bits));
+    return bits;
+}
+
+/******************************************************************************
+* Function:  bits_double
+*
+* Purpose:   Turns a bit pattern from double_bits back into a time.
+*
+* Params:    bits - The bits of the double.
+*
+* Returns:   The time in seconds.
+*
+* Operation: Copies the bytes back.
+******************************************************************************/
+static double bits_double(uint64_t bits)
+{
+    double seconds;
+    std::memcpy(&seconds, &bits, sizeof(seconds));
+    return seconds;
+}
+
+/******************************************************************************
+* Function:  valid_seconds
+*
+* Purpose:   Checks a time read from a saved session.
+*
+* Params:    seconds - The time.
+*
+* Returns:   true if the time is finite, not negative and no longer than
+*            SESSION_MAX_SECONDS.
+*
+* Operation: NaN fails both comparisons.
+******************************************************************************/
+static bool valid_seconds(double seconds)
+{
+    return std::isfinite(seconds) && seconds >= 0 &&
+           seconds <= SESSION_MAX_SECONDS;
+}
+
+/******************************************************************************
+* Function:  stats_depth
+*
+* Purpose:   Gives the entry of a by-depth statistics array to count in.
+*
+* Params:    depth - The depth being counted.
+*
+* Returns:   The index of the entry.
+*
+* Operation: Depths beyond the end of the array share its last entry.
+******************************************************************************/
+static inline int stats_depth(int depth)
+{
+    return std::min(depth, SOLVE_STATS_DEPTHS - 1);
+}
+
+/******************************************************************************
+* SolveStats implementation
+******************************************************************************/
+
+/******************************************************************************
+* Function:  SolveStats::add
+*
+* Purpose:   Adds another set of statistics into this one.
+*
+* Params:    other - The statistics to add.
+*
+* Returns:   Nothing.
+*
+* Operation: Every count, and every time, is summed. The result is enabled if
+*            either set was.
+******************************************************************************/
+void SolveStats::add(const SolveStats& other)
+{
+    enabled = enabled || other.enabled;
+    for (int ii = 0; ii < SOLVE_STATS_DEPTHS; ++ii)
+    {
+        phase1_nodes[ii] += other.phase1_nodes[ii];
+        phase2_nodes[ii] += other.phase2_nodes[ii];
+        iteration_seconds[ii] += other.iteration_seconds[ii];
+    }
+    for (int ii = 0; ii < NUM_PRUNE_TABLES; ++ii)
+    {
+        prunes[ii] += other.prunes[ii];
+    }
+    phase1_leaves += other.phase1_leaves;
+    phase2_searches += other.phase2_searches;
+}
+
+/******************************************************************************
+* CubeSolver::Search class declaration. A Search holds the state of one
+* depth-first walk of the search tree. A sequential solve uses a single
+* Search; a parallel solve gives each subtree its own copy.
+*
+* The walk is iterative. Each level of the tree has a frame holding the
+* coordinates of the node at that level and how far through its moves the
+* search has got, so nothing is allocated while searching and the whole state
+* of the walk can be copied or put aside. When a phase 1 node is expanded, the
+* pruning values of all its children are looked up together, by the batched
+* kernel chosen for this processor, so that only the survivors are entered.
+******************************************************************************/
+class CubeSolver::Search
+{
+private:
+    CubeSolver& solver;
+    const SolverTables& tables;
+    int orientation;
+
+    // The node reached by the first k moves of the solution is in frame k.
+    // The phase 1 coordinates are used at every level, and the phase 2 ones
+    // from the end of phase 1 onwards. The auxiliary coordinates are only
+    // needed to start phase 2, so are not tracked during phase 1;
+    // entry_valid is one more than the last level at which they are up to
+    // date. In phase 1, survivors has bit m set if the child reached by
+    // move m passed the pruning tables.
+    struct Frame
+    {
+        int co, eo, ud_pos;
+        int cp, ep, ud_perm;
+        int ud_sorted, rl_sorted, fb_sorted;
+        int last;
+        uint32_t survivors;
+        const uint8_t* next;
+        const uint8_t* end;
+    };
+
+    Frame frames[SEARCH_MAX_MOVES + 1] = {};
+    int moves[SEARCH_MAX_MOVES] = {};
+    int length;
+    int entry_valid;
+    long long local_nodes;
+    CubeP1Survivors p1_survivors;
+
+    // Where the current walk runs between, and, once it has been suspended,
+    // how to pick it up again: the phase it was in, the depth of the phase
+    // 2 iteration if that was phase 2, and whether the node in the deepest
+    // frame had yet to be entered.
+    int walk_top;
+    int walk_bottom;
+    int walk_phase;
+    int walk_depth2;
+    bool walk_entering;
+    bool suspended;
+
+#ifdef CUBE_STATS
+    // Statistics for this search alone, added to the result when it finishes.
+    // phase1_length is the length of the phase 1 solution being extended by
+    // the current phase 2 search.
+    SolveStats stats;
+    int phase1_length;
+#endif
+
+    bool out_of_budget();
+    void push_phase1_move(int move);
+    void push_phase2_move(int move);
+    void start_phase2();
+    int phase1_bound(const Frame& frame) const;
+    bool phase1_pruned(const Frame& frame, int depth);
+    uint32_t phase1_survivors(const Frame& frame, int depth);
+    bool skip_phase1_child(const Frame& frame, int move, int depth);
+    bool phase2_pruned(const Frame& frame, int depth);
+    bool suspend(int phase, int depth2, bool entering);
+    bool phase1_walk(bool entering);
+    bool phase2_deepen(int first);
+    bool phase2_walk(int depth, bool entering);
+    const CubeMoveList& level_moves(int level) const;
+public:
+    Search(CubeSolver& cube_solver, int start_orientation = 0);
+    bool phase1_search(int depth);
+    bool resume();
+    bool is_suspended() const;
+    void save(std::vector<uint8_t>& out) const;
+    bool restore(int depth, const uint8_t* data, size_t size);
+    void split(int depth, int levels, CubeTaskGroup& group);
+    void flush();
+    void finish();
+};
+
+/******************************************************************************
+* CubeSolver::Search class implementation
+******************************************************************************/
+
+/******************************************************************************
+* Function:  CubeSolver::Search::Search
+*
+* Purpose:   Constructor for the Search class.
+*
+* Params:    cube_solver       - The solver this search is working for.
+*            start_orientation - Which of the solver's starting orientations
+*                                of the cube to search.
+*
+* Returns:   Nothing.
+*
+* Operation: Starts the search at the root of the tree, that is, at the
+*            scrambled cube with no moves made.
+******************************************************************************/
+CubeSolver::Search::Search(CubeSolver& cube_solver, int start_orientation)
+    : solver(cube_solver), tables(cube_solver.tables),
+      orientation(start_orientation)
+{
+    const Start& start = solver.starts[orientation];
+    Frame& root = frames[0];
+
+    root.co = start.co;
+    root.eo = start.eo;
+    root.ud_pos = start.ud_pos;
+    root.cp = start.cp;
+    root.ep = root.ud_perm = 0;
+    root.ud_sorted = start.ud_sorted;
+    root.rl_sorted = start.rl_sorted;
+    root.fb_sorted = start.fb_sorted;
+    root.last = NUM_MOVES;
+    root.next = root.end = nullptr;
+
+    length = 0;
+    entry_valid = 1;
+    local_nodes = 0;
+    p1_survivors = cube_p1_survivors();
+
+    walk_top = walk_bottom = 0;
+    walk_phase = PHASE_1;
+    walk_depth2 = 0;
+    walk_entering = true;
+    suspended = false;
+
+    CUBE_STAT(stats.enabled = true);
+    CUBE_STAT(phase1_length = 0);
+}
+
+/******************************************************************************
+* Function:  CubeSolver::Search::push_phase1_move
+*
+* Purpose:   Adds a phase 1 move to the end of the solution.
+*
+* Params:    move - The move to add.
+*
+* Returns:   Nothing.
+*
+* Operation: Fills in the phase 1 coordinates of the next frame from those
+*            of the current one. Any auxiliary coordinates computed for an
+*            earlier move at this level are now out of date.
+******************************************************************************/
+inline void CubeSolver::Search::push_phase1_move(int move)
+{
+    const Frame& frame = frames[length];
+    Frame& next = frames[length + 1];
+
+    next.co = tables.co_trans(frame.co, move);
+    next.eo = tables.eo_trans(frame.eo, move);
+    next.ud_pos = tables.ud_unsorted_trans(frame.ud_pos, move);
+    next.last = move;
+
+    moves[length++] = move;
+    entry_valid = std::min(entry_valid, length);
+}
+
+/******************************************************************************
+* Function:  CubeSolver::Search::push_phase2_move
+*
+* Purpose:   Adds a phase 2 move to the end of the solution.
+*
+* Params:    move - The move to add.
+*
+* Returns:   Nothing.
+*
+* Operation: Fills in the phase 2 coordinates of the next frame from those
+*            of the current one.
+******************************************************************************/
+inline void CubeSolver::Search::push_phase2_move(int move)
+{
+    const Frame& frame = frames[length];
+    Frame& next = frames[length + 1];
+
+    next.cp = tables.cp_trans(frame.cp, move);
+    next.ep = tables.ep_trans(frame.ep, move);
+    next.ud_perm = tables.ud_perm_trans(frame.ud_perm, move);
+    next.last = move;
+
+    moves[length++] = move;
+}
+
+/******************************************************************************
+* Function:  CubeSolver::Search::start_phase2
+*
+* Purpose:   Works out the phase 2 coordinates at the end of the solution.
+*
+* Params:    None.
+*
+* Returns:   Nothing.
+*
+* Operation: Extends the auxiliary coordinates from the last level at which
+*            they are still up to date. Neighbouring phase 1 leaves share all
+*            but the last few moves, so this is usually only a step or two,
+*            and no work at all is done along paths which never reach a leaf.
+*            The phase 2 coordinates of the current frame are then derived
+*            from them.
+******************************************************************************/
+void CubeSolver::Search::start_phase2()
+{
+    for (; entry_valid <= length; ++entry_valid)
+    {
+        const Frame& prev = frames[entry_valid - 1];
+        Frame& next = frames[entry_valid];
+        int move = moves[entry_valid - 1];
+
+        next.ud_sorted = tables.ud_sorted_trans(prev.ud_sorted, move);
+        next.rl_sorted = tables.rl_sorted_trans(prev.rl_sorted, move);
+        next.fb_sorted = tables.fb_sorted_trans(prev.fb_sorted, move);
+        next.cp = tables.cp_trans(prev.cp, move);
+    }
+
+    Frame& frame = frames[length];
+    frame.ep = Cube::edge_permutation_calc(frame.rl_sorted, frame.fb_sorted);
+    frame.ud_perm = Cube::ud_permutation_calc(frame.ud_sorted);
+}
+
+/******************************************************************************
+* Function:  CubeSolver::Search::out_of_budget
+*
+* Purpose:   Counts a search node and checks whether the search should stop.
+*
+* Params:    None.
+*
+* Returns:   true if the node limit or deadline has been reached, or the
+*            search has been stopped for some other reason.
+*
+* Operation: Nodes are counted locally and only added to the shared total,
+*            which is where the limits are checked, every 1024 nodes. This
+*            keeps both the atomic update and the clock read off the per-node
+*            cost.
+******************************************************************************/
+inline bool CubeSolver::Search::out_of_budget()
+{
+    if (++local_nodes == 1024)
+    {
+        flush();
+    }
+    return solver.stopped.load(std::memory_order_relaxed);
+}
+
+/******************************************************************************
+* Function:  CubeSolver::Search::phase1_bound
+*
+* Purpose:   Gives a lower bound on the number of moves needed to finish
+*            phase 1 from a node.
+*
+* Params:    frame - The node.
+*
+* Returns:   The bound.
+*
+* Operation: Uses the full phase-1 table, which gives the exact distance, if
+*            it was built, and otherwise the largest of the pairwise tables.
+******************************************************************************/
+inline int CubeSolver::Search::phase1_bound(const Frame& frame) const
+{
+    if (tables.options.full_phase1)
+    {
+        return tables.phase1_prune(frame.co, frame.eo, frame.ud_pos);
+    }
+
+    return std::max({tables.co_eo_prune(frame.co, frame.eo),
+                     tables.co_ud_prune(frame.co, frame.ud_pos),
+                     tables.eo_ud_prune(frame.eo, frame.ud_pos)});
+}
+
+/******************************************************************************
+* Function:  CubeSolver::Search::phase1_pruned
+*
+* Purpose:   Checks whether a node can be cut off in phase 1.
+*
+* Params:    frame - The node.
+*            depth - The number of phase 1 moves left to make.
+*
+* Returns:   true if the pruning tables show that phase 1 cannot be finished
+*            in that many moves.
+*
+* Operation: The same test as comparing phase1_bound against depth. When
+*            gathering statistics the tables are tried one at a time, so that
+*            the prune can be credited to the first which is enough.
+******************************************************************************/
+inline bool CubeSolver::Search::phase1_pruned(const Frame& frame, int depth)
+{
+#ifdef CUBE_STATS
+    int table = NUM_PRUNE_TABLES;
+    if (tables.options.full_phase1)
+    {
+        if (tables.phase1_prune(frame.co, frame.eo, frame.ud_pos) > depth)
+        {
+            table = PRUNE_PHASE1;
+        }
+    }
+    else if (tables.co_eo_prune(frame.co, frame.eo) > depth)
+    {
+        table = PRUNE_CO_EO;
+    }
+    else if (tables.co_ud_prune(frame.co, frame.ud_pos) > depth)
+    {
+        table = PRUNE_CO_UD;
+    }
+    else if (tables.eo_ud_prune(frame.eo, frame.ud_pos) > depth)
+    {
+        table = PRUNE_EO_UD;
+    }
+
+    if (table == NUM_PRUNE_TABLES)
+    {
+        return false;
+    }
+    ++stats.prunes[table];
+    return true;
+#else
+    return phase1_bound(frame) > depth;
+#endif
+}
+
+/******************************************************************************
+* Function:  CubeSolver::Search::phase1_survivors
+*
+* Purpose:   Finds which children of a phase 1 node survive pruning.
+*
+* Params:    frame - The node.
+*            depth - The number of phase 1 moves left after the child's move.
+*
+* Returns:   A mask with bit m set if the child reached by move m may finish
+*            phase 1 in depth moves. Only the bits of the moves allowed after
+*            the node are meaningful.
+*
+* Operation: Uses the batched kernel on the pairwise tables. The full phase-1
+*            table needs a symmetry lookup per child, which does not batch,
+*            so with it the children are looked up one at a time.
+******************************************************************************/
+inline uint32_t CubeSolver::Search::phase1_survivors(const Frame& frame,
+                                                     int depth)
+{
+    if (!tables.options.full_phase1)
+    {
+        return p1_survivors(tables, frame.co, frame.eo, frame.ud_pos, depth);
+    }
+
+    uint32_t survivors = 0;
+    for (int move : cube_p1_allowed_moves[frame.last])
+    {
+        if (tables.phase1_prune(tables.co_trans(frame.co, move),
+                                tables.eo_trans(frame.eo, move),
+                                tables.ud_unsorted_trans(frame.ud_pos, move))
+            <= depth)
+        {
+            survivors |= 1u << move;
+        }
+    }
+    return survivors;
+}
+
+/******************************************************************************
+* Function:  CubeSolver::Search::skip_phase1_child
+*
+* Purpose:   Accounts for a child of a phase 1 node which was pruned without
+*            being entered.
+*
+* Params:    frame - The node.
+*            move  - The move reaching the child.
+*            depth - The number of phase 1 moves left after that move.
+*
+* Returns:   true if the search should stop.
+*
+* Operation: The child is counted as a node, exactly as if it had been
+*            entered and cut off, so that node counts and budgets do not
+*            depend on the kernel. When gathering statistics, the prune is
+*            credited to the table which made it.
+******************************************************************************/
+inline bool CubeSolver::Search::skip_phase1_child(const Frame& frame,
+                                                  int move, int depth)
+{
+    if (out_of_budget())
+    {
+        return true;
+    }
+
+#ifdef CUBE_STATS
+    ++stats.phase1_nodes[stats_depth(length + 1)];
+    if (depth > 0)
+    {
+        Frame child = frame;
+        child.co = tables.co_trans(frame.co, move);
+        child.eo = tables.eo_trans(frame.eo, move);
+        child.ud_pos = tables.ud_unsorted_trans(frame.ud_pos, move);
+        phase1_pruned(child, depth);
+    }
+#else
+    (void)frame;
+    (void)move;
+    (void)depth;
+#endif
+    return false;
+}
+
+/******************************************************************************
+* Function:  CubeSolver::Search::phase2_pruned
+*
+* Purpose:   Checks whether a node can be cut off in phase 2.
+*
+* Params:    frame - The node.
+*            depth - The number of phase 2 moves left to make.
+*
+* Returns:   true if the pruning tables show that the cube cannot be solved in
+*            that many moves.
+*
+* Operation: Tries the corner and edge permutation table first, if it was
+*            built, since it prunes hardest, then the corner table, crediting
+*            the prune to whichever table made it when gathering statistics.
+******************************************************************************/
+inline bool CubeSolver::Search::phase2_pruned(const Frame& frame, int depth)
+{
+    if (tables.options.full_phase2 &&
+        tables.phase2_prune(frame.cp, frame.ep) > depth)
+    {
+        CUBE_STAT(++stats.prunes[PRUNE_PHASE2]);
+        return true;
+    }
+    if (tables.cp_ud_prune(frame.cp, frame.ud_perm) > depth)
+    {
+        CUBE_STAT(++stats.prunes[PRUNE_CP_UD]);
+        return true;
+    }
+    if (tables.ep_ud_prune(frame.ep, frame.ud_perm) > depth)
+    {
+        CUBE_STAT(++stats.prunes[PRUNE_EP_UD]);
+        return true;
+    }
+    return false;
+}
+
+/******************************************************************************
+* Function:  CubeSolver::Search::flush
+*
+* Purpose:   Adds the nodes counted by this search to the shared total.
+*
+* Params:    None.
+*
+* Returns:   Nothing.
+*
+* Operation: Must be called when a search finishes so that no nodes are lost.
+******************************************************************************/
+void CubeSolver::Search::flush()
+{
+    solver.add_nodes(local_nodes);
+    local_nodes = 0;
+}
+
+/******************************************************************************
+* Function:  CubeSolver::Search::finish
+*
+* Purpose:   Hands everything this search has counted over to the solver.
+*
+* Params:    None.
+*
+* Returns:   Nothing.
+*
+* Operation: Flushes the node count, then adds in the statistics, if they are
+*            being gathered. Must be called once when a search finishes.
+******************************************************************************/
+void CubeSolver::Search::finish()
+{
+    flush();
+    CUBE_STAT(solver.add_stats(stats));
+    CUBE_STAT(stats = SolveStats());
+    CUBE_STAT(stats.enabled = true);
+}
+
+/******************************************************************************
+* Function:  CubeSolver::Search::suspend
+*
+* Purpose:   Notes where a walk stopped, so that resume can carry on from
+*            there.
+*
+* Params:    phase    - Which phase the walk was in.
+*            depth2   - In phase 2, the depth of the phase 2 iteration.
+*            entering - Whether the node in the deepest frame had yet to be
+*                       entered.
+*
+* Returns:   false, for the walk to pass back to its caller.
+*
+* Operation: Everything else the walk needs is already in the frames, which
+*            are left as they are.
+******************************************************************************/
+bool CubeSolver::Search::suspend(int phase, int depth2, bool entering)
+{
+    suspended = true;
+    walk_phase = phase;
+    walk_depth2 = depth2;
+    walk_entering = entering;
+    return false;
+}
+
+/******************************************************************************
+* Function:  CubeSolver::Search::phase1_search
+*
+* Purpose:   Finds solutions to phase 1 of the Kociemba algorithm.
+*
+* Params:    depth - How deep in the tree we should go from the current cube
+*                    position.
+*
+* Returns:   true if the search finished, or false if it was stopped first,
+*            in which case it can be carried on with resume.
+*
+* Operation: Starts a phase 1 walk at the current level; see phase1_walk.
+******************************************************************************/
+bool CubeSolver::Search::phase1_search(int depth)
+{
+    walk_top = length;
+    walk_bottom = length + depth;
+    suspended = false;
+    return phase1_walk(true);
+}
+
+/******************************************************************************
+* Function:  CubeSolver::Search::resume
+*
+* Purpose:   Carries on with a phase 1 search which was stopped.
+*
+* Params:    None.
+*
+* Returns:   true if the search finished, or false if it was stopped again.
+*
+* Operation: If the search stopped in phase 2, first finishes the phase 2
+*            iteration it was in and the deeper ones which follow it, just
+*            as the phase 1 leaf would have, then goes back to walking
+*            phase 1 from the leaf.
+******************************************************************************/
+bool CubeSolver::Search::resume()
+{
+    suspended = false;
+    bool entering = walk_entering;
+    if (walk_phase == PHASE_2)
+    {
+        if (!phase2_walk(walk_depth2, entering) ||
+            !phase2_deepen(walk_depth2 + 1))
+        {
+            return false;
+        }
+        entering = false;
+    }
+    return phase1_walk(entering);
+}
+
+/******************************************************************************
+* Function:  CubeSolver::Search::phase1_walk
+*
+* Purpose:   Walks the phase 1 tree between the levels set by phase1_search.
+*
+* Params:    entering - Whether the node in the deepest frame has yet to be
+*                       entered.
+*
+* Returns:   true if the walk finished, or false if it was stopped first.
+*
+* Operation: A depth-first search over the frames from walk_top down to
+*            walk_bottom. Entering a node counts it and either checks for a
+*            phase 1 solution, at the bottom, or sets up the node's list of
+*            moves and finds which of its children survive pruning. Only the
+*            node at the top has to be checked itself; every other node was
+*            checked with its siblings. The loop then takes the next untried
+*            move of the deepest frame, entering the child if it survived and
+*            only counting it if not, and drops back a level once the moves
+*            are all tried. When a phase 1 solution is found, phase 2 is
+*            deepened from that position. Phase 1 solutions ending in a phase
+*            2 move are skipped, since the same solutions are found from the
+*            shorter phase 1 solution without that move.
+*
+*            Once the search has been stopped the walk is suspended where it
+*            is, rather than unwound, so that it can be resumed later.
+******************************************************************************/
+bool CubeSolver::Search::phase1_walk(bool entering)
+{
+    const int top = walk_top;
+    const int bottom = walk_bottom;
+
+    for (;;)
+    {
+        Frame& frame = frames[length];
+
+        if (entering)
+        {
+            if (out_of_budget())
+            {
+                return suspend(PHASE_1, 0, true);
+            }
+            entering = false;
+            if (length == bottom)
+            {
+                CUBE_STAT(++stats.phase1_nodes[stats_depth(length)]);
+                frame.next = frame.end = nullptr;
+                if (frame.co == tables.co_trans.solved_pos() &&
+                    frame.eo == tables.eo_trans.solved_pos() &&
+                    frame.ud_pos == tables.ud_unsorted_trans.solved_pos())
+                {
+                    CUBE_STAT(++stats.phase1_leaves);
+                    if (!((cube_p2_moves >> frame.last) & 1))
+                    {
+                        CUBE_STAT(++stats.phase2_searches);
+                        CUBE_STAT(phase1_length = length);
+
+                        start_phase2();
+                        if (!phase2_deepen(0))
+                        {
+                            return false;
+                        }
+                    }
+                }
+            }
+            else
+            {
+                CUBE_STAT(++stats.phase1_nodes[stats_depth(length)]);
+                if (length == top && phase1_pruned(frame, bottom - length))
+                {
+                    frame.next = frame.end = nullptr;
+                }
+                else
+                {
+                    const CubeMoveList& list =
+                                            cube_p1_allowed_moves[frame.last];
+                    frame.next = list.begin();
+                    frame.end = list.end();
+                    frame.survivors = phase1_survivors(frame,
+                                                       bottom - length - 1);
+                }
+            }
+        }
+
+        while (frame.next != frame.end)
+        {
+            int move = *frame.next++;
+            if ((frame.survivors >> move) & 1)
+            {
+                push_phase1_move(move);
+                entering = true;
+                break;
+            }
+            if (skip_phase1_child(frame, move, bottom - length - 1))
+            {
+                return suspend(PHASE_1, 0, false);
+            }
+        }
+        if (entering)
+        {
+            continue;
+        }
+
+        if (length == top)
+        {
+            return true;
+        }
+        --length;
+        if (solver.stopped.load(std::memory_order_relaxed))
+        {
+            return suspend(PHASE_1, 0, false);
+        }
+    }
+}
+
+/******************************************************************************
+* Function:  CubeSolver::Search::phase2_deepen
+*
+* Purpose:   Runs the phase 2 iterations from a phase 1 leaf.
+*
+* Params:    first - The depth of the first iteration to run.
+*
+* Returns:   true if every iteration which could beat the best length found
+*            so far was run, or false if the search was stopped first.
+*
+* Operation: Deepens phase 2 one move at a time from the current level.
+******************************************************************************/
+bool CubeSolver::Search::phase2_deepen(int first)
+{
+    for (int depth2 = first; depth2 + length <= solver.max_length; ++depth2)
+    {
+        if (solver.stopped.load(std::memory_order_relaxed))
+        {
+            return suspend(PHASE_2, depth2, true);
+        }
+        if (!phase2_walk(depth2, true))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+/******************************************************************************
+* Function:  CubeSolver::Search::phase2_walk
+*
+* Purpose:   Finds solutions to phase 2 of the Kociemba algorithm.
+*
+* Params:    depth    - How many phase 2 moves to make from the phase 1 leaf.
+*            entering - Whether the node in the deepest frame has yet to be
+*                       entered.
+*
+* Returns:   true if the walk finished, or false if it was stopped first.
+*
+* Operation: A depth-first search over the frames below the phase 1 leaf in
+*            the same way as phase1_walk, and when a solution is found,
+*            passes it to the solver to record. Every node is first checked
+*            against the best length found so far, which is shared, so other
+*            searches' solutions prune here too.
+******************************************************************************/
+bool CubeSolver::Search::phase2_walk(int depth, bool entering)
+{
+    const int top = walk_bottom;
+    const int bottom = top + depth;
+
+    for (;;)
+    {
+        Frame& frame = frames[length];
+
+        if (entering)
+        {
+            // Give up on the node if a solution of this length, or shorter,
+            // has already been found.
+            entering = false;
+            frame.next = frame.end = nullptr;
+            if (bottom <= solver.max_length.load(std::memory_order_relaxed))
+            {
+                if (out_of_budget())
+                {
+                    return suspend(PHASE_2, depth, true);
+                }
+
+                CUBE_STAT(++stats.phase2_nodes[stats_depth(length -
+                                                           phase1_length)]);
+                if (length == bottom)
+                {
+                    if (frame.cp == tables.cp_trans.solved_pos() &&
+                        frame.ep == tables.ep_trans.solved_pos() &&
+                        frame.ud_perm == tables.ud_perm_trans.solved_pos())
+                    {
+                        solver.record_sol(moves, length, orientation,
+                                          local_nodes);
+                    }
+                }
+                else if (!phase2_pruned(frame, bottom - length))
+                {
+                    const CubeMoveList& list =
+                                            cube_p2_allowed_moves[frame.last];
+                    frame.next = list.begin();
+                    frame.end = list.end();
+                }
+            }
+        }
+
+        if (frame.next != frame.end)
+        {
+            push_phase2_move(*frame.next++);
+            entering = true;
+            continue;
+        }
+
+        if (length == top)
+        {
+            return true;
+        }
+        --length;
+        if (solver.stopped.load(std::memory_order_relaxed))
+        {
+            return suspend(PHASE_2, depth, false);
+        }
+    }
+}
+
+/******************************************************************************
+* Function:  CubeSolver::Search::is_suspended
+*
+* Purpose:   Tells whether the last walk was stopped part way through.
+*
+* Params:    None.
+*
+* Returns:   true if resume would carry on with a walk.
+*
+* Operation: Reports the flag kept by suspend.
+******************************************************************************/
+bool CubeSolver::Search::is_suspended() const
+{
+    return suspended;
+}
+
+/******************************************************************************
+* Function:  CubeSolver::Search::level_moves
+*
+* Purpose:   Gives the list of moves which the node at a level works through.
+*
+* Params:    level - The level of the node in the current walk.
+*
+* Returns:   The list.
+*
+* Operation: Levels from the end of phase 1 onwards make phase 2 moves once
+*            the walk has reached phase 2, and phase 1 moves otherwise.
+******************************************************************************/
+const CubeMoveList& CubeSolver::Search::level_moves(int level) const
+{
+    if (walk_phase == PHASE_2 && level >= walk_bottom)
+    {
+        return cube_p2_allowed_moves[frames[level].last];
+    }
+    return cube_p1_allowed_moves[frames[level].last];
+}
+
+/******************************************************************************
+* Function:  CubeSolver::Search::save
+*
+* Purpose:   Records how far the walk has got, so that it can be restored.
+*
+* Params:    out - Where to append the record.
+*
+* Returns:   Nothing.
+*
+* Operation: Writes a byte saying whether the walk is suspended. If it is,
+*            follows that with the phase, phase 2 depth and entering flag
+*            from suspend, the number of moves made, the moves themselves,
+*            and for each level the number of moves its node has left to
+*            try, or SESSION_NO_CURSOR if it has none to work through. All
+*            of these fit in a byte. The coordinates are not recorded, since
+*            replaying the moves gives them back.
+******************************************************************************/
+void CubeSolver::Search::save(std::vector<uint8_t>& out) const
+{
+    out.push_back(suspended);
+    if (!suspended)
+    {
+        return;
+    }
+
+    out.push_back(walk_phase);
+    out.push_back(walk_depth2);
+    out.push_back(walk_entering);
+    out.push_back(length);
+    out.insert(out.end(), moves, moves + length);
+    for (int level = 0; level <= length; ++level)
+    {
+        const Frame& frame = frames[level];
+        if (frame.next == nullptr || (walk_entering && level == length))
+        {
+            out.push_back(SESSION_NO_CURSOR);
+        }
+        else
+        {
+            out.push_back(frame.end - frame.next);
+        }
+    }
+}
+
+/******************************************************************************
+* Function:  CubeSolver::Search::restore
+*
+* Purpose:   Puts a new search back where a saved one had got to.
+*
+* Params:    depth - The depth of the phase 1 iteration the saved search was
+*                    running.
+*            data  - The record written by save.
+*            size  - The size of the record in bytes.
+*
+* Returns:   true if the record was restored, or false if it does not
+*            describe a walk of a phase 1 iteration of that depth.
+*
+* Operation: Must be called on a search which is still at the root. Replays
+*            the recorded moves, filling in the frames as the walk did, and
+*            points each level's cursor back into its list of moves. Each
+*            move is checked against the move just before the cursor of its
+*            level, which is the one the walk last took there, so a record
+*            which does not fit the cube is turned down rather than searched.
+*            The phase 1 survivors are looked up again for every level that
+*            still has moves to try.
+******************************************************************************/
+bool CubeSolver::Search::restore(int depth, const uint8_t* data, size_t size)
+{
+    walk_top = 0;
+    walk_bottom = depth;
+    suspended = false;
+    if (size == 0 || data[0] > 1)
+    {
+        return false;
+    }
+    if (data[0] == 0)
+    {
+        return size == 1;
+    }
+    if (size < 5)
+    {
+        return false;
+    }
+
+    int phase = data[1];
+    int depth2 = data[2];
+    bool entering = data[3];
+    int saved = data[4];
+    const uint8_t* path = data + 5;
+    const uint8_t* remaining = path + saved;
+
+    int deepest = (phase == PHASE_2) ? depth + depth2 : depth;
+    if ((phase != PHASE_1 && phase != PHASE_2) || data[3] > 1 ||
+        deepest > SEARCH_MAX_MOVES || saved > deepest ||
+        (phase == PHASE_2 && saved < depth) ||
+        size != 5 + 2 * (size_t)saved + 1)
+    {
+        return false;
+    }
+    walk_phase = phase;
+    CUBE_STAT(phase1_length = depth);
+
+    for (int level = 0; ; ++level)
+    {
+        Frame& frame = frames[level];
+        bool in_phase2 = (phase == PHASE_2 && level >= depth);
+        if (in_phase2 && level == depth)
+        {
+            start_phase2();
+        }
+
+        const CubeMoveList& list = level_moves(level);
+        frame.next = frame.end = nullptr;
+        if (remaining[level] != SESSION_NO_CURSOR)
+        {
+            if (remaining[level] > list.count ||
+                (entering && level == saved) ||
+                (!in_phase2 && level == depth))
+            {
+                return false;
+            }
+            frame.end = list.end();
+            frame.next = frame.end - remaining[level];
+            if (!in_phase2)
+            {
+                frame.survivors = phase1_survivors(frame, depth - level - 1);
+            }
+        }
+
+        if (level == saved)
+        {
+            break;
+        }
+        if (frame.next == nullptr || frame.next == list.begin() ||
+            frame.next[-1] != path[level])
+        {
+            return false;
+        }
+        if (in_phase2)
+        {
+            push_phase2_move(path[level]);
+        }
+        else
+        {
+            push_phase1_move(path[level]);
+        }
+    }
+
+    walk_depth2 = depth2;
+    walk_entering = entering;
+    suspended = true;
+    return true;
+}
+
+/******************************************************************************
+* Function:  CubeSolver::Search::split
+*
+* Purpose:   Splits the phase 1 search tree into subtrees which can be
+*            searched in parallel.
+*
+* Params:    depth  - How deep in the tree we should go from the current cube
+*                     position.
+*            levels - How many more moves to make before handing off the rest
+*                     of the tree as a task.
+*            group  - The task group to which subtrees are submitted.
+*
+* Returns:   Nothing.
+*
+* Operation: Walks the top of the tree exactly as phase1_search would,
+*            applying the same pruning, and when levels reaches zero submits a
+*            copy of this search to continue from the current node. Only the
+*            first few levels are walked, so this is left recursive.
+******************************************************************************/
+void CubeSolver::Search::split(int depth, int levels, CubeTaskGroup& group)
+{
+    if (levels == 0)
+    {
+        Search task = *this;
+        group.run([task, depth]() mutable
+        {
+            task.phase1_search(depth);
+            task.finish();
+        });
+        return;
+    }
+
+    if (phase1_bound(frames[length]) <= depth)
+    {
+        for (int move : cube_p1_allowed_moves[frames[length].last])
+        {
+            push_phase1_move(move);
+            split(depth - 1, levels - 1, group);
+            --length;
+        }
+    }
+}
+
 /******************************************************************************
 * CubeSolver class implementation
 ******************************************************************************/
 
 /******************************************************************************
-* Function:  CubeSolver::CubeSolver
+* Function:  CubeSolver::CubeSolver
+*
+* Purpose:   Default constructor for the CubeSolver class.
+*
+* Params:    solver_tables - The tables to search with, which must already
+*                            have been filled or loaded, and must outlive
+*                            this object.
+*
+* Returns:   Nothing.
+*
+* Operation: Sets up a CubeSolver instance which will try to find a solution
+*            to a cube given by the default Constructor of the Cube class.
+******************************************************************************/
+CubeSolver::CubeSolver(const SolverTables& solver_tables)
+    : CubeSolver(solver_tables, Cube())
+{
+}
+
+/******************************************************************************
+* Function:  CubeSolver::CubeSolver
+*
+* Purpose:   Constructor for the CubeSolver class.
+*
+* Params:    solver_tables  - The tables to search with, which must already
+*                             have been filled or loaded, and must outlive
+*                             this object.
+*            scrambled_cube - a Cube object which is in the state we are
+*                             trying to find a solution to.
+*
+* Returns:   Nothing.
+*
+* Operation: Calculates the starting coordinates of the cube which was passed
+*            in, in every orientation. Orientation k is the cube, inverted if
+*            k is odd, then conjugated by the symmetry which turns the whole
+*            cube k / 2 times about the URF-DBL diagonal, bringing a
+*            different axis into the UD position.
+******************************************************************************/
+CubeSolver::CubeSolver(const SolverTables& solver_tables, Cube scrambled_cube)
+    : tables(solver_tables), max_length(INT_MAX), stopped(false), nodes(0),
+      session_depth(0), session_seconds(0), solved_depth(0)
+{
+    for (int ii = 0; ii < SOLVE_ORIENTATIONS; ++ii)
+    {
+        Cube cube = (ii % 2 == 0) ? scrambled_cube : scrambled_cube.inverse();
+        cube = cube_conjugate(cube, NUM_SYMS_UD * (ii / 2));
+        Start& start = starts[ii];
+
+        // Calculate the starting values of the phase 1 and auxiliary
+        // coordinates together.
+        CubeCoords coords = cube.coords();
+        start.co = coords.corner_orientation;
+        start.eo = coords.edge_orientation;
+        start.ud_pos = Cube::ud_unsorted_calc(coords.ud_sorted);
+        start.ud_sorted = coords.ud_sorted;
+        start.rl_sorted = coords.rl_sorted;
+        start.fb_sorted = coords.fb_sorted;
+        start.cp = coords.corner_permutation;
+    }
+}
+
+/******************************************************************************
+* Function:  CubeSolver::~CubeSolver
+*
+* Purpose:   Destructor for the CubeSolver class.
+*
+* Params:    None.
+*
+* Returns:   Nothing.
+*
+* Operation: Frees the session search, if there is one. Defined here, where
+*            the Search class is complete.
+******************************************************************************/
+CubeSolver::~CubeSolver()
+{
+}
+
+/******************************************************************************
+* Function:  CubeSolver::record_sol
+*
+* Purpose:   Record a solution that has been found.
+*
+* Params:    solution    - The moves of the solution.
+*            length      - How many moves there are.
+*            orientation - Which orientation of the cube the solution is for.
+*            local_nodes - Nodes counted by the finding search which have not
+*                          yet been added to the shared total.
+*
+* Returns:   Nothing.
+*
+* Operation: Under the result lock, checks that the solution still beats the
+*            best one (another search may have got there first), then stores
+*            it, tightens max_length, notes when it was found, and passes the
+*            result so far to the process_sol callback, if there is one.
+*            Stops the search altogether if the solution is short enough.
+*
+*            A solution for a re-oriented cube is conjugated back by the
+*            inverse symmetry, move by move, and a solution for the inverse
+*            cube is reversed with each move undone.
+******************************************************************************/
+void CubeSolver::record_sol(const int* solution, int length, int orientation,
+                            long long local_nodes)
+{
+    std::lock_guard<std::mutex> guard(result_lock);
+    if (length > max_length)
+    {
+        return;
+    }
+
+    std::chrono::duration<double> elapsed =
+                                  std::chrono::steady_clock::now() - start_time;
+
+    int sym_inverse = cube_sym_inverse(NUM_SYMS_UD * (orientation / 2));
+    std::vector<int> moves;
+    for (int ii = 0; ii < length; ++ii)
+    {
+        moves.push_back(cube_conjugate_move(solution[ii], sym_inverse));
+    }
+    if (orientation % 2 == 1)
+    {
+        std::reverse(moves.begin(), moves.end());
+        for (int& move : moves)
+        {
+            move = 3 * (move / 3) + (2 - move % 3);
+        }
+    }
+
+    max_length = length - 1;
+    result.moves = moves;
+    result.length = length;
+    result.nodes = nodes + local_nodes;
+    result.improvements.push_back({result.length, result.nodes,
+                                   elapsed.count()});
+
+    if (options.process_sol)
+    {
+        options.process_sol(result);
+    }
+
+    if (result.length <= options.target_length)
+    {
+        stopped = true;
+    }
+}
+
+/******************************************************************************
+* Function:  CubeSolver::add_nodes
+*
+* Purpose:   Adds to the shared count of nodes and checks the search budget.
+*
+* Params:    count - The number of nodes to add.
+*
+* Returns:   Nothing.
+*
+* Operation: Stops the search if the node limit or deadline has been reached.
+******************************************************************************/
+void CubeSolver::add_nodes(long long count)
+{
+    long long total = nodes += count;
+    if (total >= options.node_limit ||
+        std::chrono::steady_clock::now() >= options.deadline)
+    {
+        stopped = true;
+    }
+}
+
+/******************************************************************************
+* Function:  CubeSolver::add_stats
+*
+* Purpose:   Adds the statistics gathered by one search to the result.
+*
+* Params:    stats - The statistics to add.
+*
+* Returns:   Nothing.
+*
+* Operation: Takes the result lock, since searches finish concurrently.
+******************************************************************************/
+void CubeSolver::add_stats(const SolveStats& stats)
+{
+    std::lock_guard<std::mutex> guard(result_lock);
+    result.stats.add(stats);
+}
+
+/******************************************************************************
+* Function:  CubeSolver::add_iteration
+*
+* Purpose:   Records the time taken by a phase 1 deepening iteration.
+*
+* Params:    depth - The depth of the iteration.
+*            start - When the iteration started.
+*
+* Returns:   Nothing.
+*
+* Operation: Adds the time since start to the statistics, under the result
+*            lock. Does nothing unless statistics are being gathered.
+******************************************************************************/
+void CubeSolver::add_iteration(int depth,
+                               std::chrono::steady_clock::time_point start)
+{
+#ifdef CUBE_STATS
+    std::chrono::duration<double> elapsed =
+                                  std::chrono::steady_clock::now() - start;
+    std::lock_guard<std::mutex> guard(result_lock);
+    result.stats.iteration_seconds[stats_depth(depth)] += elapsed.count();
+#else
+    (void)depth;
+    (void)start;
+#endif
+}
+
+/******************************************************************************
+* Function:  CubeSolver::parallel_search
+*
+* Purpose:   Runs one iteration of the phase 1 deepening on the thread pool.
+*
+* Params:    depth - The length of phase 1 solutions to look for.
+*
+* Returns:   Nothing.
+*
+* Operation: Splits the tree split_depth moves down (but always leaving at
+*            least one move for the subtree), submits each surviving subtree
+*            as a task and waits for them all. The tasks share max_length, so
+*            a solution found by any of them prunes all the others.
+******************************************************************************/
+void CubeSolver::parallel_search(int depth)
+{
+    CubeTaskGroup group(*options.pool);
+    Search root(*this);
+    root.split(depth, std::min(options.split_depth, depth - 1), group);
+    group.wait();
+}
+
+/******************************************************************************
+* Function:  CubeSolver::multi_axis_search
 *
-* Purpose:   Default constructor for the CubeSolver class.
+* Purpose:   Searches every orientation of the cube at once.
 *
 * Params:    None.
 *
 * Returns:   Nothing.
 *
-* Operation: Sets up a CubeSolver instance which will try to find a solution
-*            to a cube given by the default Constructor of the Cube class.
+* Operation: With a pool, runs one task per orientation, each deepening its
+*            own phase 1 search until the shared max_length proves that it
+*            cannot find anything shorter. Without one, the orientations
+*            take turns on this thread, each running one iteration of the
+*            deepening before the next, so that no threads are started for
+*            the call. Either way a solution from any orientation tightens
+*            the bound for all of them.
+******************************************************************************/
+void CubeSolver::multi_axis_search()
+{
+    if (options.pool == nullptr)
+    {
+        std::vector<std::unique_ptr<Search>> searches;
+        for (int ii = 0; ii < SOLVE_ORIENTATIONS; ++ii)
+        {
+            searches.emplace_back(new Search(*this, ii));
+        }
+        for (int depth = 0; depth <= max_length && !stopped; ++depth)
+        {
+            CUBE_STAT(auto start = std::chrono::steady_clock::now());
+            for (std::unique_ptr<Search>& search : searches)
+            {
+                if (depth <= max_length && !stopped)
+                {
+                    search->phase1_search(depth);
+                }
+            }
+            CUBE_STAT(add_iteration(depth, start));
+        }
+        for (std::unique_ptr<Search>& search : searches)
+        {
+            search->finish();
+        }
+        return;
+    }
+
+    CubeTaskGroup group(*options.pool);
+    for (int ii = 0; ii < SOLVE_ORIENTATIONS; ++ii)
+    {
+        group.run([this, ii]
+        {
+            Search search(*this, ii);
+            for (int depth = 0; depth <= max_length && !stopped; ++depth)
+            {
+                CUBE_STAT(auto start = std::chrono::steady_clock::now());
+                search.phase1_search(depth);
+                CUBE_STAT(add_iteration(depth, start));
+            }
+            search.finish();
+        });
+    }
+    group.wait();
+}
+
+/******************************************************************************
+* Function:  CubeSolver::solve
+*
+* Purpose:   Finds solutions to the current cube state, within limits.
+*
+* Params:    solve_options - When to stop searching; see SolveOptions.
+*
+* Returns:   The best solution found before the search stopped, along with
+*            statistics about the search.
+*
+* Operation: Uses the two-phase Kociemba algorithm with transition tables and
+*            pruning to find solutions, deepening phase 1 until the shortest
+*            solution is proved or one of the stopping rules fires. Shallow
+*            depths are always searched sequentially, since there is too
+*            little work in them to be worth splitting. In multi-axis mode
+*            the orientations are searched concurrently instead. Any session
+*            which was running is ended.
 ******************************************************************************/
-CubeSolver::CubeSolver()
+SolveResult CubeSolver::solve(const SolveOptions& solve_options)
 {
-    Cube cube;
+    // Reset private member variables to their starting values
+    session.reset();
+    max_length = INT_MAX;
+    options = solve_options;
+    result = SolveResult();
+    start_time = std::chrono::steady_clock::now();
+    stopped = false;
+    nodes = 0;
+    solved_depth = 0;
+    CUBE_STAT(result.stats.enabled = true);
+
+    // Begin searching for solutions.
+    if (options.multi_axis)
+    {
+        multi_axis_search();
+        if (!stopped)
+        {
+            solved_depth = INT_MAX;
+        }
+        result.nodes = nodes;
+        return result;
+    }
 
-    // Calculate the starting values of the phase 1 coordinates.
-    curr_co = cube.coord_corner_orientation();
-    curr_eo = cube.coord_edge_orientation();
-    curr_ud_pos = cube.coord_ud_unsorted();
+    Search search(*this);
+    for (int depth = 0; depth <= max_length && !stopped; ++depth)
+    {
+        CUBE_STAT(auto start = std::chrono::steady_clock::now());
+        if (options.pool != nullptr && options.split_depth > 0 && depth > 1)
+        {
+            parallel_search(depth);
+        }
+        else
+        {
+            search.phase1_search(depth);
+        }
+        CUBE_STAT(add_iteration(depth, start));
+        if (!stopped)
+        {
+            solved_depth = depth + 1;
+        }
+    }
+    search.finish();
 
-    // Calculate the starting values of the auxiliary coordinates.
-    start_ud_sorted = cube.coord_ud_sorted();
-    start_rl_sorted = cube.coord_rl_sorted();
-    start_fb_sorted = cube.coord_fb_sorted();
-    start_cp  = cube.coord_corner_permutation();
+    result.nodes = nodes;
+    return result;
 }
 
 /******************************************************************************
-* Function:  CubeSolver::CubeSolver
+* Function:  CubeSolver::start
 *
-* Purpose:   Constructor for the CubeSolver class.
+* Purpose:   Starts a session, in which the search is run a piece at a time.
 *
-* Params:    scrambled_cube - a Cube object which is in the state we are
-*                             trying to find a solution to.
+* Params:    None.
 *
 * Returns:   Nothing.
 *
-* Operation: Sets the private member variable cube to be equal to the cube
-*            object which was passed in.
+* Operation: Clears the result and bound, as solve does, and sets up a
+*            sequential search of the cube as given, at the root of the tree
+*            with the depth 0 iteration to run first. Nothing is searched
+*            until improve is called.
 ******************************************************************************/
-CubeSolver::CubeSolver(Cube scrambled_cube)
+void CubeSolver::start()
 {
-    // Calculate the starting values of the phase 1 coordinates.
-    curr_co = scrambled_cube.coord_corner_orientation();
-    curr_eo = scrambled_cube.coord_edge_orientation();
-    curr_ud_pos = scrambled_cube.coord_ud_unsorted();
+    max_length = INT_MAX;
+    options = SolveOptions();
+    result = SolveResult();
+    stopped = false;
+    nodes = 0;
+    CUBE_STAT(result.stats.enabled = true);
 
-    // Calculate the starting values of the auxiliary coordinates.
-    start_ud_sorted = scrambled_cube.coord_ud_sorted();
-    start_rl_sorted = scrambled_cube.coord_rl_sorted();
-    start_fb_sorted = scrambled_cube.coord_fb_sorted();
-    start_cp  = scrambled_cube.coord_corner_permutation();
+    session.reset(new Search(*this));
+    session_depth = 0;
+    session_seconds = 0;
 }
 
 /******************************************************************************
-* Function:  CubeSolver::phase1_search
+* Function:  CubeSolver::improve
 *
-* Purpose:   Finds solutions to phase 1 of the Kociemba algorithm.
+* Purpose:   Runs the session's search for a while longer.
 *
-* Params:    depth - How deep in the tree we should go from the current cube
-*                    position.
+* Params:    budget - When to stop this time; see SolveOptions. node_limit
+*                     counts only the nodes expanded by this call, and pool
+*                     and multi_axis are ignored.
 *
-* Returns:   Nothing.
+* Returns:   The best solution found by the session so far, with the totals
+*            over every call.
 *
-* Operation: Uses a depth-first search to find phase-1 solutions, and when a
-*            solution is found, starts a phase 2 search from that position.
+* Operation: Starts the session first if that has not been done. Resumes
+*            the suspended walk, if the last call stopped in the middle of
+*            one, and then deepens phase 1 exactly as a sequential solve
+*            does, until the budget runs out or the shortest solution is
+*            proved. Times are measured from the start of the session,
+*            counting only the time spent in improve, so every improvement
+*            is stamped with the search time it took to find.
 ******************************************************************************/
-void CubeSolver::phase1_search(int depth)
+SolveResult CubeSolver::improve(const SolveOptions& budget)
 {
-    // If the depth is zero, then check if we have a valid phase 1 solution.
-    if (depth == 0 &&
-        curr_co == cube_co_trans.solved_pos() &&
-        curr_eo == cube_eo_trans.solved_pos() &&
-        curr_ud_pos == cube_ud_unsorted_trans.solved_pos() &&
-        std::find(cube_p2_allowed_moves[NUM_MOVES].begin(),
-                  cube_p2_allowed_moves[NUM_MOVES].end(), last_move)
-                                     == cube_p2_allowed_moves[NUM_MOVES].end())
+    if (!session)
     {
-        // Initialise the phase 2 starting coordinates and call into the phase
-        // 2 search from this position
-        int ud_sorted = start_ud_sorted;
-        int rl_sorted = start_rl_sorted;
-        int fb_sorted = start_fb_sorted;
-        int coord_cp  = start_cp;
+        start();
+    }
 
-        for (int move : solution)
-        {
-            ud_sorted = cube_ud_sorted_trans(ud_sorted, move);
-            rl_sorted = cube_rl_sorted_trans(rl_sorted, move);
-            fb_sorted = cube_fb_sorted_trans(fb_sorted, move);
-            coord_cp  = cube_cp_trans(coord_cp, move);
-        }
+    long long spent = nodes;
+    options = budget;
+    options.pool = nullptr;
+    options.multi_axis = false;
+    options.node_limit = (budget.node_limit > LLONG_MAX - spent)
+                       ? LLONG_MAX : spent + budget.node_limit;
 
-        curr_cp = coord_cp;
-        curr_ep = Cube::edge_permutation_calc(rl_sorted, fb_sorted);
-        curr_ud_perm = Cube::ud_permutation_calc(ud_sorted);
+    std::chrono::duration<double> spent_seconds(session_seconds);
+    start_time = std::chrono::steady_clock::now() -
+                 std::chrono::duration_cast<
+                     std::chrono::steady_clock::duration>(spent_seconds);
+    stopped = (result.length >= 0 && result.length <= options.target_length);
 
-        for (int depth2 = 0;
-             (int)(depth2 + solution.size()) <= max_length;
-             ++depth2)
+    while (!stopped && session_depth <= max_length)
+    {
+        CUBE_STAT(auto start = std::chrono::steady_clock::now());
+        bool finished = session->is_suspended()
+                      ? session->resume()
+                      : session->phase1_search(session_depth);
+        CUBE_STAT(add_iteration(session_depth, start));
+        if (!finished)
         {
-            phase2_search(depth2);
+            break;
         }
+        ++session_depth;
     }
+    session->finish();
 
-    // If the depth is not zero, then check the pruning tables to see if we
-    // should prune this branch or not, and then check all available moves.
-    else if (depth > 0)
-    {
-        if (cube_co_eo_prune(curr_co, curr_eo) <= depth &&
-            cube_co_ud_prune(curr_co, curr_ud_pos) <= depth &&
-            cube_eo_ud_prune(curr_eo, curr_ud_pos) <= depth)
-        {
-            int old_co = curr_co;
-            int old_eo = curr_eo;
-            int old_ud_pos = curr_ud_pos;
+    std::chrono::duration<double> elapsed =
+                                  std::chrono::steady_clock::now() - start_time;
+    session_seconds = elapsed.count();
+    result.nodes = nodes;
+    return result;
+}
 
-            for (int move : cube_p1_allowed_moves[last_move])
-            {
-                curr_co = cube_co_trans(old_co, move);
-                curr_eo = cube_eo_trans(old_eo, move);
-                curr_ud_pos = cube_ud_unsorted_trans(old_ud_pos, move);
+/******************************************************************************
+* Function:  CubeSolver::best
+*
+* Purpose:   Gives the best solution found so far.
+*
+* Params:    None.
+*
+* Returns:   The result of the session, or of the last call to solve.
+*
+* Operation: The result is only changed by solve, start, improve and
+*            load_session, so reading it between calls needs no lock.
+******************************************************************************/
+const SolveResult& CubeSolver::best() const
+{
+    return result;
+}
+
+/******************************************************************************
+* Function:  CubeSolver::exhausted
+*
+* Purpose:   Tells whether the session has nothing more to search.
+*
+* Params:    None.
+*
+* Returns:   true once every phase 1 depth which could lead to a shorter
+*            solution has been searched. No solution is then shorter than
+*            best, and lower_bound gives its length.
+*
+* Operation: Compares the depth reached against the bound, as the deepening
+*            loop in improve does. Every solution of at most max_length
+*            moves would have been found by then, as lower_bound explains.
+******************************************************************************/
+bool CubeSolver::exhausted() const
+{
+    return session && session_depth > max_length;
+}
+
+/******************************************************************************
+* Function:  CubeSolver::lower_bound
+*
+* Purpose:   Gives the fewest moves any solution of the cube could have, as
+*            far as the search so far has proved.
+*
+* Params:    None.
+*
+* Returns:   A length which no solution is shorter than. When this equals the
+*            length of the best solution, that solution is optimal.
+*
+* Operation: Once the phase 1 iterations up to depth d have all finished,
+*            every solution of at most d moves which beats the best so far
+*            has been found, since such a solution is itself a phase 1
+*            solution for its length, or ends in a phase 2 move and is found
+*            from the one before. So either the best solution is the
+*            shortest, or none has fewer than d + 1 moves. Uses the
+*            session's depth if a session is running, and otherwise the
+*            depth finished by the last solve.
+******************************************************************************/
+int CubeSolver::lower_bound() const
+{
+    int depth = session ? session_depth : solved_depth;
+    return (result.length >= 0) ? std::min(depth, result.length) : depth;
+}
 
-                last_move = move;
-                solution.push_back(move);
+/******************************************************************************
+* Function:  CubeSolver::save_session
+*
+* Purpose:   Saves the state of the session, so that it can be carried on
+*            later.
+*
+* Params:    None.
+*
+* Returns:   The saved session.
+*
+* Operation: Writes, in fixed-size little-endian fields:
+*
+*            - SESSION_MAGIC and SESSION_VERSION.
+*            - The starting coordinates of the cube, 2 bytes each, which
+*              between them identify it, so that the session is only ever
+*              loaded for the same cube.
+*            - The nodes expanded and seconds spent, 8 bytes each.
+*            - The depth of the phase 1 iteration reached, 1 byte.
+*            - The length of the best solution, 1 byte, or 0xFF if none has
+*              been found, and its moves, 1 byte each.
+*            - The number of improvements, 1 byte, and for each its length,
+*              nodes and seconds.
+*            - The search itself, as written by Search::save.
+*
+*            The statistics are not saved. If no session has been started,
+*            the result is saved as the start of one, from depth 0.
+******************************************************************************/
+std::vector<uint8_t> CubeSolver::save_session() const
+{
+    std::vector<uint8_t> out;
+    put_bytes(out, SESSION_MAGIC, 4);
+    put_bytes(out, SESSION_VERSION, 1);
 
-                phase1_search(depth - 1);
+    const Start& start = starts[0];
+    for (int coord : {start.co, start.eo, start.ud_pos, start.ud_sorted,
+                      start.rl_sorted, start.fb_sorted, start.cp})
+    {
+        put_bytes(out, coord, 2);
+    }
 
-                solution.pop_back();
-                last_move = (solution.empty()) ? NUM_MOVES : solution.back();
-            }
+    put_bytes(out, nodes, 8);
+    put_bytes(out, double_bits(session_seconds), 8);
+    put_bytes(out, session ? session_depth : 0, 1);
 
-            curr_co = old_co;
-            curr_eo = old_eo;
-            curr_ud_pos = old_ud_pos;
-        }
+    put_bytes(out, result.length < 0 ? 0xFF : result.length, 1);
+    for (int move : result.moves)
+    {
+        put_bytes(out, move, 1);
+    }
+
+    put_bytes(out, result.improvements.size(), 1);
+    for (const SolveImprovement& improvement : result.improvements)
+    {
+        put_bytes(out, improvement.length, 1);
+        put_bytes(out, improvement.nodes, 8);
+        put_bytes(out, double_bits(improvement.seconds), 8);
+    }
+
+    if (session)
+    {
+        session->save(out);
+    }
+    else
+    {
+        put_bytes(out, 0, 1);
     }
+    return out;
 }
 
 /******************************************************************************
-* Function:  CubeSolver::phase2_search
+* Function:  CubeSolver::solves
 *
-* Purpose:   Finds solutions to phase 2 of the Kociemba algorithm.
+* Purpose:   Checks that a sequence of moves solves the cube.
 *
-* Params:    depth - How deep in the tree we should go from the current cube
-*                    cube position.
+* Params:    moves - The moves.
 *
-* Returns:   Nothing.
+* Returns:   true if the moves take the cube as given to the solved state.
 *
-* Operation: Uses a depth-first search to find phase-2 solutions, and when a
-*            solution is found, calls print_sol on it.
+* Operation: Follows the moves from the starting coordinates through the
+*            transition tables. The corner orientation, edge orientation and
+*            corner permutation, with the sorted positions of the three
+*            slices' edges, between them fix the whole cube, and every one
+*            of their tables covers every move.
 ******************************************************************************/
-void CubeSolver::phase2_search(int depth)
+bool CubeSolver::solves(const std::vector<int>& moves) const
 {
-    // Break out early if we're looking for a solution of the same length as
-    // one we've already found, or longer.
-    if ((int)(depth + solution.size()) >= max_length)
+    const Start& start = starts[0];
+    int co = start.co, eo = start.eo, cp = start.cp;
+    int ud_sorted = start.ud_sorted;
+    int rl_sorted = start.rl_sorted;
+    int fb_sorted = start.fb_sorted;
+    for (int move : moves)
     {
-        return;
+        co = tables.co_trans(co, move);
+        eo = tables.eo_trans(eo, move);
+        cp = tables.cp_trans(cp, move);
+        ud_sorted = tables.ud_sorted_trans(ud_sorted, move);
+        rl_sorted = tables.rl_sorted_trans(rl_sorted, move);
+        fb_sorted = tables.fb_sorted_trans(fb_sorted, move);
     }
+    return co == tables.co_trans.solved_pos() &&
+           eo == tables.eo_trans.solved_pos() &&
+           cp == tables.cp_trans.solved_pos() &&
+           ud_sorted == tables.ud_sorted_trans.solved_pos() &&
+           rl_sorted == tables.rl_sorted_trans.solved_pos() &&
+           fb_sorted == tables.fb_sorted_trans.solved_pos();
+}
+
+/******************************************************************************
+* Function:  CubeSolver::load_session
+*
+* Purpose:   Carries on a session saved by save_session.
+*
+* Params:    data - The saved session.
+*
+* Returns:   true if the session was loaded, or false if it is not a valid
+*            session for this cube, in which case the solver is unchanged.
+*
+* Operation: Reads every field, checking each against its limits, and
+*            restores the search into a new Search at the root. The best
+*            solution is replayed against the cube, since the bound is
+*            taken from it and a false one would later be reported as
+*            proved optimal. Only once all of that has succeeded does it
+*            replace the solver's result, bound and session. The next call
+*            to improve then resumes the search where the saved one left
+*            off.
+******************************************************************************/
+bool CubeSolver::load_session(const std::vector<uint8_t>& data)
+{
+    const uint8_t* pos = data.data();
+    const uint8_t* end = pos + data.size();
+    uint64_t value;
 
-    // If the depth is zero, then check if we have a valid phase 2 solution.
-    if (depth == 0 &&
-        curr_cp == cube_cp_trans.solved_pos() &&
-        curr_ep == cube_ep_trans.solved_pos() &&
-        curr_ud_perm == cube_ud_perm_trans.solved_pos())
+    if (!get_bytes(pos, end, 4, value) || value != SESSION_MAGIC ||
+        !get_bytes(pos, end, 1, value) || value != SESSION_VERSION)
     {
-        // We've found a solution, so update the max_length, and execute the
-        // callback on the solution
-        max_length = solution.size() - 1;
-        print_sol();
+        return false;
     }
 
-    // If the depth is not zero, then check the pruning tables to see if we
-    // should prune this branch or not, and then check all available moves.
-    else if (depth > 0)
+    const Start& start = starts[0];
+    for (int coord : {start.co, start.eo, start.ud_pos, start.ud_sorted,
+                      start.rl_sorted, start.fb_sorted, start.cp})
     {
-        if (cube_cp_ud_prune(curr_cp, curr_ud_perm) <= depth &&
-            cube_ep_ud_prune(curr_ep, curr_ud_perm) <= depth)
+        if (!get_bytes(pos, end, 2, value) || value != (uint64_t)coord)
         {
-            int old_cp = curr_cp;
-            int old_ep = curr_ep;
-            int old_ud_perm = curr_ud_perm;
+            return false;
+        }
+    }
 
-            for (int move : cube_p2_allowed_moves[last_move])
+    uint64_t saved_nodes, saved_seconds, depth, length;
+    if (!get_bytes(pos, end, 8, saved_nodes) ||
+        saved_nodes > (uint64_t)LLONG_MAX ||
+        !get_bytes(pos, end, 8, saved_seconds) ||
+        !valid_seconds(bits_double(saved_seconds)) ||
+        !get_bytes(pos, end, 1, depth) || depth > SEARCH_MAX_MOVES ||
+        !get_bytes(pos, end, 1, length) ||
+        (length != 0xFF && length > SEARCH_MAX_MOVES))
+    {
+        return false;
+    }
+
+    SolveResult saved;
+    CUBE_STAT(saved.stats.enabled = true);
+    if (length != 0xFF)
+    {
+        saved.length = length;
+        for (uint64_t ii = 0; ii < length; ++ii)
+        {
+            if (!get_bytes(pos, end, 1, value) || value >= NUM_MOVES)
             {
-                curr_cp = cube_cp_trans(old_cp, move);
-                curr_ep = cube_ep_trans(old_ep, move);
-                curr_ud_perm = cube_ud_perm_trans(old_ud_perm, move);
+                return false;
+            }
+            saved.moves.push_back(value);
+        }
+        if (!solves(saved.moves))
+        {
+            return false;
+        }
+    }
+
+    uint64_t count;
+    if (!get_bytes(pos, end, 1, count))
+    {
+        return false;
+    }
+    for (uint64_t ii = 0; ii < count; ++ii)
+    {
+        uint64_t improvement_length, improvement_nodes, improvement_seconds;
+        if (!get_bytes(pos, end, 1, improvement_length) ||
+            !get_bytes(pos, end, 8, improvement_nodes) ||
+            improvement_nodes > (uint64_t)LLONG_MAX ||
+            !get_bytes(pos, end, 8, improvement_seconds) ||
+            !valid_seconds(bits_double(improvement_seconds)))
+        {
+            return false;
+        }
+        saved.improvements.push_back({(int)improvement_length,
+                                      (long long)improvement_nodes,
+                                      bits_double(improvement_seconds)});
+    }
+    saved.nodes = saved_nodes;
+
+    std::unique_ptr<Search> search(new Search(*this));
+    if (!search->restore(depth, pos, end - pos))
+    {
+        return false;
+    }
 
-                last_move = move;
-                solution.push_back(move);
+    max_length = (saved.length < 0) ? INT_MAX : saved.length - 1;
+    options = SolveOptions();
+    result = saved;
+    stopped = false;
+    nodes = saved_nodes;
+    session = std::move(search);
+    session_depth = depth;
+    session_seconds = bits_double(saved_seconds);
+    return true;
+}
 
-                phase2_search(depth - 1);
+/******************************************************************************
+* Phase 1 query implementation
+******************************************************************************/
 
-                solution.pop_back();
-                last_move = (solution.empty()) ? NUM_MOVES : solution.back();
-            }
+/******************************************************************************
+* Function:  phase1_distance
+*
+* Purpose:   Gives a lower bound on the number of moves needed to solve
+*            phase 1 from a position.
+*
+* Params:    tables - The tables to look it up in.
+*            co     - The corner orientation coordinate of the position.
+*            eo     - The edge orientation coordinate of the position.
+*            ud_pos - The unsorted UD-slice coordinate of the position.
+*
+* Returns:   The bound, which is exact if the full phase-1 table was built.
+*
+* Operation: As CubeSolver::Search::phase1_bound.
+******************************************************************************/
+static int phase1_distance(const SolverTables& tables, int co, int eo,
+                           int ud_pos)
+{
+    if (tables.options.full_phase1)
+    {
+        return tables.phase1_prune(co, eo, ud_pos);
+    }
+
+    return std::max({tables.co_eo_prune(co, eo),
+                     tables.co_ud_prune(co, ud_pos),
+                     tables.eo_ud_prune(eo, ud_pos)});
+}
+
+/******************************************************************************
+* Function:  phase1_walk
+*
+* Purpose:   Looks for a phase 1 solution of a given length.
+*
+* Params:    tables - The tables to search with.
+*            co     - The corner orientation coordinate of the position.
+*            eo     - The edge orientation coordinate of the position.
+*            ud_pos - The unsorted UD-slice coordinate of the position.
+*            depth  - How many more moves to make.
+*            last   - The last move made, or NUM_MOVES at the start.
+*            moves  - The moves made so far, to which the solution is added.
+*
+* Returns:   true if a solution was found.
+*
+* Operation: A plain depth-first search, pruned by phase1_distance. It is
+*            only ever a few moves deep, and is usually led straight to a
+*            solution by the pruning tables, so it is left recursive.
+******************************************************************************/
+static bool phase1_walk(const SolverTables& tables, int co, int eo,
+                        int ud_pos, int depth, int last,
+                        std::vector<int>& moves)
+{
+    if (depth == 0)
+    {
+        return co == tables.co_trans.solved_pos() &&
+               eo == tables.eo_trans.solved_pos() &&
+               ud_pos == tables.ud_unsorted_trans.solved_pos();
+    }
+
+    for (int move : cube_p1_allowed_moves[last])
+    {
+        int next_co = tables.co_trans(co, move);
+        int next_eo = tables.eo_trans(eo, move);
+        int next_ud_pos = tables.ud_unsorted_trans(ud_pos, move);
+        if (phase1_distance(tables, next_co, next_eo, next_ud_pos) >= depth)
+        {
+            continue;
+        }
 
-            curr_cp = old_cp;
-            curr_ep = old_ep;
-            curr_ud_perm = old_ud_perm;
+        moves.push_back(move);
+        if (phase1_walk(tables, next_co, next_eo, next_ud_pos, depth - 1,
+                        move, moves))
+        {
+            return true;
         }
+        moves.pop_back();
     }
+    return false;
 }
 
 /******************************************************************************
-* Function:  CubeSolver::print_sol
+* Function:  cube_solve_phase1
 *
-* Purpose:   Display a solution that has been found.
+* Purpose:   Finds a shortest sequence of moves which solves phase 1.
 *
-* Params:    None.
+* Params:    tables - The tables to search with. Only the phase 1 tables
+*                     are read.
+*            cube   - The cube.
+*
+* Returns:   The moves, which take the cube into the group generated by U, D,
+*            R2, L2, F2 and B2.
+*
+* Operation: Deepens a phase 1 search from the cube's lower bound until it
+*            finds a solution, which takes at most 12 moves.
+******************************************************************************/
+std::vector<int> cube_solve_phase1(const SolverTables& tables,
+                                   const Cube& cube)
+{
+    Cube start = cube;
+    int co = start.coord_corner_orientation();
+    int eo = start.coord_edge_orientation();
+    int ud_pos = start.coord_ud_unsorted();
+
+    std::vector<int> moves;
+    int depth = phase1_distance(tables, co, eo, ud_pos);
+    while (!phase1_walk(tables, co, eo, ud_pos, depth, NUM_MOVES, moves))
+    {
+        ++depth;
+    }
+    return moves;
+}
+
+/******************************************************************************
+* Batch solving implementation
+******************************************************************************/
+
+/******************************************************************************
+* The state shared by every worker of one batch.
+******************************************************************************/
+struct BatchState
+{
+    const Cube* cubes;
+    size_t count;
+    SolveOptions options;
+    const BatchCallback& on_complete;
+    std::vector<SolveResult> results;
+    std::atomic<size_t> next;
+    std::mutex callback_lock;
+
+    BatchState(const Cube* batch_cubes, size_t batch_count,
+               const SolveOptions& batch_options,
+               const BatchCallback& batch_on_complete)
+        : cubes(batch_cubes), count(batch_count), options(batch_options),
+          on_complete(batch_on_complete), results(batch_count), next(0)
+    {
+        options.pool = nullptr;
+    }
+};
+
+/******************************************************************************
+* Function:  batch_worker
+*
+* Purpose:   The loop run by each worker of a batch.
+*
+* Params:    tables - The tables for this worker to search with.
+*            batch  - The batch being solved.
 *
 * Returns:   Nothing.
 *
-* Operation: Prints out the length and the moves of the currently stored
-*            solution.
+* Operation: Repeatedly claims the next unsolved cube from the shared counter
+*            and solves it sequentially, until there are none left.
 ******************************************************************************/
-void CubeSolver::print_sol()
+static void batch_worker(const SolverTables& tables, BatchState& batch)
 {
-    std::cout << "Length: " << solution.size() << std::endl;
-    for (int ii = 0; ii < solution.size(); ++ii)
+    size_t index;
+    while ((index = batch.next++) < batch.count)
     {
-        switch (solution[ii])
+        CubeSolver solver(tables, batch.cubes[index]);
+        batch.results[index] = solver.solve(batch.options);
+
+        if (batch.on_complete)
         {
-            case MOVE_U:
-            case MOVE_U2:
-            case MOVE_UP:
-                std::cout << "U";
-                break;
-            case MOVE_L:
-            case MOVE_L2:
-            case MOVE_LP:
-                std::cout << "L";
-                break;
-            case MOVE_F:
-            case MOVE_F2:
-            case MOVE_FP:
-                std::cout << "F";
-                break;
-            case MOVE_R:
-            case MOVE_R2:
-            case MOVE_RP:
-                std::cout << "R";
-                break;
-            case MOVE_B:
-            case MOVE_B2:
-            case MOVE_BP:
-                std::cout << "B";
-                break;
-            case MOVE_D:
-            case MOVE_D2:
-            case MOVE_DP:
-                std::cout << "D";
-                break;
+            std::lock_guard<std::mutex> guard(batch.callback_lock);
+            batch.on_complete(index, batch.results[index]);
         }
+    }
+}
+
+/******************************************************************************
+* Function:  cube_solve_batch
+*
+* Purpose:   Solves many cubes in parallel.
+*
+* Params:    tables      - The tables to search with, shared by every thread.
+*            cubes       - The cubes to solve.
+*            count       - How many cubes there are.
+*            options     - How to solve each cube. If options.pool is set the
+*                          cubes are spread over it, otherwise over a pool
+*                          created for the call with one thread per core. Each
+*                          individual cube is searched sequentially, taking
+*                          the orientations of a multi-axis solve in turn,
+*                          and the deadline applies to the batch as a whole.
+*            on_complete - If set, called with the index and result of each
+*                          cube as it finishes.
+*
+* Returns:   The results, in the same order as the cubes.
+*
+* Operation: Runs one task per pool thread, each of which repeatedly claims
+*            the next unsolved cube from a shared counter. This balances the
+*            load without queueing a task per cube.
+******************************************************************************/
+std::vector<SolveResult> cube_solve_batch(const SolverTables& tables,
+                                          const Cube* cubes, size_t count,
+                                          const SolveOptions& options,
+                                          const BatchCallback& on_complete)
+{
+    std::unique_ptr<CubeThreadPool> own_pool;
+    CubeThreadPool* pool = options.pool;
+    if (pool == nullptr)
+    {
+        own_pool.reset(new CubeThreadPool());
+        pool = own_pool.get();
+    }
 
-        switch (solution[ii])
+    BatchState batch(cubes, count, options, on_complete);
+    {
+        CubeTaskGroup group(*pool);
+        for (int ii = 0; ii < pool->size(); ++ii)
         {
-            case MOVE_U:
-            case MOVE_L:
-            case MOVE_F:
-            case MOVE_R:
-            case MOVE_B:
-            case MOVE_D:
-                std::cout << " ";
-                break;
-            case MOVE_U2:
-            case MOVE_L2:
-            case MOVE_F2:
-            case MOVE_R2:
-            case MOVE_B2:
-            case MOVE_D2:
-                std::cout << "2 ";
-                break;
-            case MOVE_UP:
-            case MOVE_LP:
-            case MOVE_FP:
-            case MOVE_RP:
-            case MOVE_BP:
-            case MOVE_DP:
-                std::cout << "' ";
-                break;
+            group.run([&]
+            {
+                batch_worker(tables, batch);
+            });
         }
+        group.wait();
     }
-    std::cout << std::endl << std::endl;
+
+    return std::move(batch.results);
 }
 
 /******************************************************************************
-* Function:  CubeSolver::solve
+* Function:  cube_solve_batch
 *
-* Purpose:   Finds solutions to the current cube state.
+* Purpose:   Solves many cubes in parallel.
 *
-* Params:    process_sol - A callback which will be called on each solution as
-*                          it is discovered.
+* Params:    tables      - The tables to search with, shared by every thread.
+*            cubes       - The cubes to solve.
+*            options     - How to solve each cube.
+*            on_complete - If set, called with the index and result of each
+*                          cube as it finishes.
 *
-* Returns:   Nothing.
+* Returns:   The results, in the same order as the cubes.
 *
-* Operation: Uses the two-phase Kociemba algorithm with transition tables and
-*            pruning to find solutions.
+* Operation: Convenience overload of the pointer and count version.
 ******************************************************************************/
-void CubeSolver::solve()
+std::vector<SolveResult> cube_solve_batch(const SolverTables& tables,
+                                          const std::vector<Cube>& cubes,
+                                          const SolveOptions& options,
+                                          const BatchCallback& on_complete)
 {
-    // Reset private member variables to their starting values
-    max_length = INT_MAX;
-    solution = {};
-    last_move = NUM_MOVES;
+    return cube_solve_batch(tables, cubes.data(), cubes.size(), options,
+                            on_complete);
+}
 
-    // Begin searching for solutions.
-    for (int depth = 0; depth <= max_length; ++depth)
+/******************************************************************************
+* Function:  cube_solve_batch
+*
+* Purpose:   Solves many cubes in parallel across NUMA nodes.
+*
+* Params:    replicas    - One set of tables per node with processors.
+*            cubes       - The cubes to solve.
+*            count       - How many cubes there are.
+*            options     - How to solve each cube. options.pool is ignored,
+*                          since the workers must be pinned to their nodes.
+*            on_complete - If set, called with the index and result of each
+*                          cube as it finishes.
+*
+* Returns:   The results, in the same order as the cubes.
+*
+* Operation: Creates a pool for each replica, with its workers pinned to
+*            the replica's node, or unpinned for a replica tied to no node,
+*            and runs one task per worker searching with that replica.
+*            Every worker claims cubes from the same counter, so the load is
+*            still balanced across nodes.
+******************************************************************************/
+std::vector<SolveResult> cube_solve_batch(const CubeTableReplicas& replicas,
+                                          const Cube* cubes, size_t count,
+                                          const SolveOptions& options,
+                                          const BatchCallback& on_complete)
+{
+    BatchState batch(cubes, count, options, on_complete);
+
+    std::vector<std::unique_ptr<CubeThreadPool>> pools;
+    std::vector<std::unique_ptr<CubeTaskGroup>> groups;
+    for (int index = 0; index < replicas.size(); ++index)
+    {
+        pools.emplace_back(new CubeThreadPool(0, replicas.node(index)));
+        groups.emplace_back(new CubeTaskGroup(*pools.back()));
+        const SolverTables& tables = replicas.tables(index);
+        for (int ii = 0; ii < pools.back()->size(); ++ii)
+        {
+            groups.back()->run([&tables, &batch]
+            {
+                batch_worker(tables, batch);
+            });
+        }
+    }
+    for (std::unique_ptr<CubeTaskGroup>& group : groups)
     {
-        phase1_search(depth);
+        group->wait();
     }
-}
\ No newline at end of file
+    groups.clear();
+
+    return std::move(batch.results);
+}
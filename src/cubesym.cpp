@@ -0,0 +1,255 @@
+/******************************************************************************
+* File:    cubesym.cpp
+*
+* Purpose: Builds the 48 symmetries of the cube at the cubie level, along with
+*          their multiplication table and their action on moves, and uses
+*          them to conjugate cube positions.
+******************************************************************************/
+
+/******************************************************************************
+* Dependencies
+******************************************************************************/
+#include <vector>
+
+#include <cube.h>
+#include <cubesym.h>
+
+/******************************************************************************
+* Symmetry tables
+******************************************************************************/
+
+/******************************************************************************
+* Structure holding every symmetry together with the index of its inverse,
+* the index of the product of each pair, and the move each move becomes when
+* conjugated by each symmetry.
+******************************************************************************/
+struct SymmetryTables
+{
+    std::vector<Cube> syms;
+    int inverse[NUM_SYMS];
+    int product[NUM_SYMS][NUM_SYMS];
+    int move_conj[NUM_MOVES][NUM_SYMS];
+};
+
+/******************************************************************************
+* Function:  make_symmetry_tables
+*
+* Purpose:   Builds the symmetry tables.
+*
+* Params:    None.
+*
+* Returns:   The tables.
+*
+* Operation: The four basic symmetries are given at the cubie level, with a
+*            corner orientation of 3 marking the reflection. Every symmetry is
+*            a product of powers of these, built up in the order which gives
+*            the numbering described in cubesym.h. The remaining tables are
+*            found by searching for the symmetry or move equal to each product
+*            or conjugate.
+******************************************************************************/
+static SymmetryTables make_symmetry_tables()
+{
+    // Quarter turn of the whole cube about the URF-DBL diagonal.
+    Cube urf3({CORNER_URF, CORNER_DFR, CORNER_DLF, CORNER_UFL,
+               CORNER_UBR, CORNER_DRB, CORNER_DBL, CORNER_ULB},
+              {1, 2, 1, 2, 2, 1, 2, 1},
+              {EDGE_FR, EDGE_DF, EDGE_FL, EDGE_UF,
+               EDGE_BR, EDGE_DB, EDGE_BL, EDGE_UB,
+               EDGE_UR, EDGE_DR, EDGE_DL, EDGE_UL},
+              {0, 1, 0, 1, 0, 1, 0, 1, 1, 1, 1, 1});
+
+    // Half turn of the whole cube about the FB axis.
+    Cube f2({CORNER_DLF, CORNER_DFR, CORNER_DRB, CORNER_DBL,
+             CORNER_UFL, CORNER_URF, CORNER_UBR, CORNER_ULB},
+            {0, 0, 0, 0, 0, 0, 0, 0},
+            {EDGE_DF, EDGE_DR, EDGE_DB, EDGE_DL,
+             EDGE_UF, EDGE_UR, EDGE_UB, EDGE_UL,
+             EDGE_FL, EDGE_FR, EDGE_BR, EDGE_BL},
+            {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0});
+
+    // Quarter turn of the whole cube about the UD axis.
+    Cube u4({CORNER_UBR, CORNER_URF, CORNER_UFL, CORNER_ULB,
+             CORNER_DRB, CORNER_DFR, CORNER_DLF, CORNER_DBL},
+            {0, 0, 0, 0, 0, 0, 0, 0},
+            {EDGE_UR, EDGE_UF, EDGE_UL, EDGE_UB,
+             EDGE_DR, EDGE_DF, EDGE_DL, EDGE_DB,
+             EDGE_BR, EDGE_FR, EDGE_FL, EDGE_BL},
+            {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1});
+
+    // Reflection in the plane between the R and L faces.
+    Cube lr2({CORNER_UFL, CORNER_URF, CORNER_UBR, CORNER_ULB,
+              CORNER_DLF, CORNER_DFR, CORNER_DRB, CORNER_DBL},
+             {3, 3, 3, 3, 3, 3, 3, 3},
+             {EDGE_UF, EDGE_UR, EDGE_UB, EDGE_UL,
+              EDGE_DF, EDGE_DR, EDGE_DB, EDGE_DL,
+              EDGE_FL, EDGE_FR, EDGE_BR, EDGE_BL},
+             {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0});
+
+    SymmetryTables tables;
+    Cube cube;
+    for (int ii = 0; ii < 3; ++ii)
+    {
+        for (int jj = 0; jj < 2; ++jj)
+        {
+            for (int kk = 0; kk < 4; ++kk)
+            {
+                for (int ll = 0; ll < 2; ++ll)
+                {
+                    tables.syms.push_back(cube);
+                    cube = cube.multiply(lr2);
+                }
+                cube = cube.multiply(u4);
+            }
+            cube = cube.multiply(f2);
+        }
+        cube = cube.multiply(urf3);
+    }
+
+    for (int ii = 0; ii < NUM_SYMS; ++ii)
+    {
+        for (int jj = 0; jj < NUM_SYMS; ++jj)
+        {
+            Cube product = tables.syms[ii].multiply(tables.syms[jj]);
+            for (int kk = 0; kk < NUM_SYMS; ++kk)
+            {
+                if (product == tables.syms[kk])
+                {
+                    tables.product[ii][jj] = kk;
+                    break;
+                }
+            }
+            if (product == Cube())
+            {
+                tables.inverse[ii] = jj;
+            }
+        }
+    }
+
+    for (int move = 0; move < NUM_MOVES; ++move)
+    {
+        Cube move_cube = Cube().perform_move(move);
+        for (int sym = 0; sym < NUM_SYMS; ++sym)
+        {
+            Cube conj = tables.syms[sym].multiply(move_cube)
+                                 .multiply(tables.syms[tables.inverse[sym]]);
+            for (int ii = 0; ii < NUM_MOVES; ++ii)
+            {
+                if (conj == Cube().perform_move(ii))
+                {
+                    tables.move_conj[move][sym] = ii;
+                    break;
+                }
+            }
+        }
+    }
+    return tables;
+}
+
+/******************************************************************************
+* Function:  symmetry_tables
+*
+* Purpose:   Gives access to the symmetry tables.
+*
+* Params:    None.
+*
+* Returns:   The tables, which are built on first use.
+*
+* Operation: Uses a function-local static, so initialisation is thread safe.
+******************************************************************************/
+static const SymmetryTables& symmetry_tables()
+{
+    static const SymmetryTables tables = make_symmetry_tables();
+    return tables;
+}
+
+/******************************************************************************
+* Symmetry functions
+******************************************************************************/
+
+/******************************************************************************
+* Function:  cube_symmetry
+*
+* Purpose:   Looks up one of the symmetries of the cube.
+*
+* Params:    sym - The index of the symmetry, in the range 0..NUM_SYMS-1.
+*
+* Returns:   The symmetry, as a cube which may have mirrored corners.
+*
+* Operation: Simply return the stored value.
+******************************************************************************/
+const Cube& cube_symmetry(int sym)
+{
+    return symmetry_tables().syms[sym];
+}
+
+/******************************************************************************
+* Function:  cube_sym_inverse
+*
+* Purpose:   Looks up the inverse of one of the symmetries of the cube.
+*
+* Params:    sym - The index of the symmetry, in the range 0..NUM_SYMS-1.
+*
+* Returns:   The index of the inverse symmetry.
+*
+* Operation: Simply return the stored value.
+******************************************************************************/
+int cube_sym_inverse(int sym)
+{
+    return symmetry_tables().inverse[sym];
+}
+
+/******************************************************************************
+* Function:  cube_sym_multiply
+*
+* Purpose:   Looks up the product of two symmetries of the cube.
+*
+* Params:    sym_1 - The indices of the symmetries, in the range
+*            sym_2   0..NUM_SYMS-1.
+*
+* Returns:   The index of the symmetry S_1 * S_2, so that conjugating by
+*            sym_2 and then by sym_1 is the same as conjugating by the result.
+*
+* Operation: Simply return the stored value.
+******************************************************************************/
+int cube_sym_multiply(int sym_1, int sym_2)
+{
+    return symmetry_tables().product[sym_1][sym_2];
+}
+
+/******************************************************************************
+* Function:  cube_conjugate_move
+*
+* Purpose:   Looks up the conjugate of a move by a symmetry of the cube.
+*
+* Params:    move - The move to conjugate.
+*            sym  - The index of the symmetry, in the range 0..NUM_SYMS-1.
+*
+* Returns:   The move S * move * S^-1, where S is the symmetry. Every
+*            symmetry maps moves onto moves, so this always exists.
+*
+* Operation: Simply return the stored value.
+******************************************************************************/
+int cube_conjugate_move(int move, int sym)
+{
+    return symmetry_tables().move_conj[move][sym];
+}
+
+/******************************************************************************
+* Function:  cube_conjugate
+*
+* Purpose:   Conjugates a cube position by a symmetry.
+*
+* Params:    cube - The position to conjugate.
+*            sym  - The index of the symmetry.
+*
+* Returns:   The position S * cube * S^-1, where S is the symmetry. This is
+*            the position seen when the whole cube, together with whatever
+*            moves produced it, is rotated or reflected by S^-1.
+*
+* Operation: Two cubie-level multiplications.
+******************************************************************************/
+Cube cube_conjugate(const Cube& cube, int sym)
+{
+    return cube_symmetry(sym).multiply(cube)
+                             .multiply(cube_symmetry(cube_sym_inverse(sym)));
+}
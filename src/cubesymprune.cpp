@@ -0,0 +1,267 @@
+/******************************************************************************
+* File:    cubesymprune.cpp
+*
+* Purpose: Implementation of the CubeSymPrune class, the symmetry-reduced
+*          pruning table shared by the full phase-1, phase-2 and corner
+*          tables.
+******************************************************************************/
+
+/******************************************************************************
+* Dependencies
+******************************************************************************/
+#include <atomic>
+#include <cstdint>
+
+#include <cube.h>
+#include <cubecache.h>
+#include <cubemem.h>
+#include <cubephase.h>
+#include <cubepool.h>
+#include <cubeprune.h>
+#include <cubesym.h>
+#include <cubesymprune.h>
+#include <cubesymtrans.h>
+#include <cubetrans.h>
+
+/******************************************************************************
+* CubeSymPrune class implementation.
+******************************************************************************/
+
+/******************************************************************************
+* Function:  CubeSymPrune::CubeSymPrune
+*
+* Purpose:   Constructor for the CubeSymPrune class.
+*
+* Params:    sym_table  - The sym coordinate table of the reduced coordinate.
+*            conj_table - The conjugation table of the raw coordinate.
+*            raw_table  - The transition table of the raw coordinate.
+*            move_list  - The moves the table is filled with.
+*            classes    - The number of classes of the reduced coordinate.
+*            raw_size   - The range of the raw coordinate.
+*            chunk      - The number of classes each task scans in one level
+*                         of a parallel fill.
+*
+* Returns:   Nothing.
+*
+* Operation: Stores the tables. Space for the data is not allocated until the
+*            table is filled, since it may instead be loaded from a table
+*            file.
+******************************************************************************/
+CubeSymPrune::CubeSymPrune(const CubeSymTrans* sym_table,
+                           const CubeSymConj* conj_table,
+                           const CubeTrans* raw_table,
+                           const CubeMoveList& move_list,
+                           int classes, int raw_size, int chunk)
+{
+    sym_trans = sym_table;
+    raw_conj = conj_table;
+    raw_trans = raw_table;
+    moves = &move_list;
+    num_classes = classes;
+    num_raw = raw_size;
+    fill_chunk = chunk;
+    table = nullptr;
+}
+
+/******************************************************************************
+* Function:  CubeSymPrune::set_all
+*
+* Purpose:   Records the distance of a position and of every other entry
+*            which stands for a symmetric position.
+*
+* Params:    cls   - The class of the position's reduced coordinate.
+*            raw   - The position's raw coordinate, as conjugated onto the
+*                    class representative.
+*            value - The distance to record.
+*
+* Returns:   The number of entries newly recorded.
+*
+* Operation: A symmetry which maps the representative to itself can still
+*            change the raw coordinate, so the position has one entry for
+*            each raw value it can be conjugated to by such a symmetry. All
+*            of them are recorded at once; otherwise the search could reach
+*            one and never the others. Entries already recorded, perhaps by
+*            another thread, are left alone.
+******************************************************************************/
+long CubeSymPrune::set_all(int cls, int raw, int value)
+{
+    long base = (long)cls * num_raw;
+    long count = 0;
+    uint16_t stabiliser = sym_trans->stabiliser(cls);
+
+    for (int sym = 0; stabiliser != 0; ++sym, stabiliser >>= 1)
+    {
+        if (stabiliser & 1)
+        {
+            count += storage.claim(base + (*raw_conj)(raw, sym), value);
+        }
+    }
+    return count;
+}
+
+/******************************************************************************
+* Function:  CubeSymPrune::fill
+*
+* Purpose:   Fill in the entries in this pruning table.
+*
+* Params:    pool      - If set, each level of the search is spread over this
+*                        pool.
+*            placement - Which pages to put the entries on, and where.
+*
+* Returns:   Nothing.
+*
+* Operation: Runs a breadth-first search one depth at a time over the whole
+*            table, sharing out blocks of classes over the pool. While few
+*            entries are filled, each entry at the current depth marks its
+*            unvisited neighbours. Once more than half are filled, it is
+*            cheaper to run backwards: each unvisited entry looks for a
+*            neighbour at the current depth. As in CubePrune::fill, entries
+*            are claimed atomically, so the result does not depend on how the
+*            work is shared out. The transition, sym coordinate and
+*            conjugation tables must already have been filled.
+*
+*            Some tables have positions 15 or more moves away, which is more
+*            than an entry can store, so the search stops once depth 14 is
+*            recorded. The entries left unvisited read as 15, which is still
+*            a lower bound on their distance.
+******************************************************************************/
+void CubeSymPrune::fill(CubeThreadPool* pool, const CubePlacement& placement)
+{
+    long total = (long)num_classes * num_raw;
+    storage.assign(total, placement);
+    table = storage.data();
+
+    int num_moves = moves->count;
+
+    // Record the solved position at depth 0.
+    int solved = sym_trans->solved_pos();
+    long done = set_all(solved / NUM_SYMS_UD,
+                        (*raw_conj)(raw_trans->solved_pos(),
+                                    solved % NUM_SYMS_UD), 0);
+    std::atomic<long> added(done);
+
+    for (int depth = 0;
+         done < total && added > 0 && depth + 1 < PRUNE_UNVISITED; ++depth)
+    {
+        bool backwards = (done > total / 2);
+        added = 0;
+
+        cube_parallel_for(pool, num_classes, fill_chunk,
+                          [&](long begin, long end)
+        {
+            long count = 0;
+            for (int cls = begin; cls < end; ++cls)
+            {
+                // Look up where each move takes the representative, which is
+                // shared by every entry in this class.
+                long next_base[NUM_MOVES];
+                int next_sym[NUM_MOVES];
+                for (int ii = 0; ii < num_moves; ++ii)
+                {
+                    int next = sym_trans->rep_move(cls, moves->moves[ii]);
+                    next_base[ii] = (long)(next / NUM_SYMS_UD) * num_raw;
+                    next_sym[ii] = next % NUM_SYMS_UD;
+                }
+
+                long base = (long)cls * num_raw;
+                for (int raw = 0; raw < num_raw; ++raw)
+                {
+                    int value = storage.get(base + raw);
+                    if (backwards ? (value != PRUNE_UNVISITED)
+                                  : (value != depth))
+                    {
+                        continue;
+                    }
+
+                    for (int ii = 0; ii < num_moves; ++ii)
+                    {
+                        int next_raw = (*raw_trans)(raw, moves->moves[ii]);
+                        long next = next_base[ii] +
+                                    (*raw_conj)(next_raw, next_sym[ii]);
+
+                        if (backwards && storage.get(next) == depth)
+                        {
+                            count += set_all(cls, raw, depth + 1);
+                            break;
+                        }
+                        if (!backwards &&
+                            storage.get(next) == PRUNE_UNVISITED)
+                        {
+                            count += set_all(next / num_raw, next % num_raw,
+                                             depth + 1);
+                        }
+                    }
+                }
+            }
+            added += count;
+        });
+
+        done += added;
+    }
+}
+
+/******************************************************************************
+* Function:  CubeSymPrune::save
+*
+* Purpose:   Adds this pruning table to a table file.
+*
+* Params:    writer - The table file being built.
+*
+* Returns:   Nothing.
+*
+* Operation: The packed entries are recorded as is, along with the table
+*            dimensions. The symmetry tables are saved separately by their
+*            owner.
+******************************************************************************/
+void CubeSymPrune::save(CubeTableWriter& writer) const
+{
+    writer.add_section(SECTION_PRUNE, num_classes, num_raw, 0, table,
+                       ((long)num_classes * num_raw + 1) / 2);
+}
+
+/******************************************************************************
+* Function:  CubeSymPrune::matches
+*
+* Purpose:   Checks whether a section of a table file holds this table.
+*
+* Params:    file  - A validated table file.
+*            first - Which section of the file to check.
+*
+* Returns:   true if the section type and dimensions match this table.
+*
+* Operation: Compares the section descriptor against this table.
+******************************************************************************/
+bool CubeSymPrune::matches(const CubeTableFile& file, int first) const
+{
+    if (file.num_sections() < first + num_sections)
+    {
+        return false;
+    }
+
+    const CubeTableSection& section = file.section(first);
+    return section.type == SECTION_PRUNE &&
+           section.rows == (uint32_t)num_classes &&
+           section.cols == (uint32_t)num_raw &&
+           section.bytes == ((uint64_t)num_classes * num_raw + 1) / 2;
+}
+
+/******************************************************************************
+* Function:  CubeSymPrune::load
+*
+* Purpose:   Points this pruning table at a section of a table file.
+*
+* Params:    file  - A validated table file, which must stay open for as long
+*                    as this table is in use.
+*            first - Which section of the file holds this table. The caller
+*                    must have checked it with matches.
+*
+* Returns:   Nothing.
+*
+* Operation: The packed entries are used directly from the mapping rather than
+*            being copied.
+******************************************************************************/
+void CubeSymPrune::load(const CubeTableFile& file, int first)
+{
+    storage.clear();
+    table = (const uint8_t*)file.section_data(first);
+}
@@ -0,0 +1,494 @@
+/******************************************************************************
+* File:    cubesymtrans.cpp
+*
+* Purpose: Implementation of the CubeSymConj and CubeSymTrans classes, which
+*          let tables be indexed by symmetry class rather than by raw
+*          coordinate value.
+******************************************************************************/
+
+/******************************************************************************
+* Dependencies
+******************************************************************************/
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include <cube.h>
+#include <cubecache.h>
+#include <cubephase.h>
+#include <cubesym.h>
+#include <cubesymtrans.h>
+
+/******************************************************************************
+* Constants
+******************************************************************************/
+#define CLASS_UNASSIGNED 0xFFFF
+
+/******************************************************************************
+* CubeSymConj class implementation
+******************************************************************************/
+
+/******************************************************************************
+* Function:  CubeSymConj::CubeSymConj
+*
+* Purpose:   Constructor for the CubeSymConj class.
+*
+* Params:    func        - Function which calculates the value of the
+*                          coordinate.
+*            set         - Function which gives a cube a particular value of
+*                          the coordinate.
+*            coord_range - The number of values taken by the coordinate.
+*
+* Returns:   Nothing.
+*
+* Operation: Stores the functions and range. Space for the entries is not
+*            allocated until the table is filled, since it may instead be
+*            loaded from a table file.
+******************************************************************************/
+CubeSymConj::CubeSymConj(std::function<int(Cube&)> func,
+                         std::function<void(Cube&, int)> set,
+                         int coord_range)
+{
+    coord_func = func;
+    set_func = set;
+    range = coord_range;
+    table = nullptr;
+}
+
+/******************************************************************************
+* Function:  CubeSymConj::size
+*
+* Purpose:   Getter for the number of values taken by the coordinate.
+*
+* Params:    None.
+*
+* Returns:   The number of values taken by the coordinate.
+*
+* Operation: Simply return the value.
+******************************************************************************/
+int CubeSymConj::size() const
+{
+    return range;
+}
+
+/******************************************************************************
+* Function:  CubeSymConj::fill
+*
+* Purpose:   Fill in the entries in this conjugation table.
+*
+* Params:    None.
+*
+* Returns:   Nothing.
+*
+* Operation: Builds a cube with each value of the coordinate and conjugates
+*            it by each symmetry.
+******************************************************************************/
+void CubeSymConj::fill()
+{
+    storage.resize(range * NUM_SYMS_UD);
+    for (int position = 0; position < range; ++position)
+    {
+        Cube cube;
+        set_func(cube, position);
+        for (int sym = 0; sym < NUM_SYMS_UD; ++sym)
+        {
+            Cube conj = cube_conjugate(cube, sym);
+            storage[position * NUM_SYMS_UD + sym] = coord_func(conj);
+        }
+    }
+    table = storage.data();
+}
+
+/******************************************************************************
+* Function:  CubeSymConj::save
+*
+* Purpose:   Adds this conjugation table to a table file.
+*
+* Params:    writer - The table file being built.
+*
+* Returns:   Nothing.
+*
+* Operation: The entries are recorded as is, along with the table dimensions.
+******************************************************************************/
+void CubeSymConj::save(CubeTableWriter& writer) const
+{
+    writer.add_section(SECTION_SYM_CONJ, range, NUM_SYMS_UD, 0, table,
+                       (size_t)range * NUM_SYMS_UD * sizeof(uint16_t));
+}
+
+/******************************************************************************
+* Function:  CubeSymConj::matches
+*
+* Purpose:   Checks whether a section of a table file holds this table.
+*
+* Params:    file  - A validated table file.
+*            first - Which section of the file to check.
+*
+* Returns:   true if the section type and dimensions match this table.
+*
+* Operation: Compares the section descriptor against this table.
+******************************************************************************/
+bool CubeSymConj::matches(const CubeTableFile& file, int first) const
+{
+    if (file.num_sections() < first + num_sections)
+    {
+        return false;
+    }
+
+    const CubeTableSection& section = file.section(first);
+    return section.type == SECTION_SYM_CONJ &&
+           section.rows == (uint32_t)range &&
+           section.cols == NUM_SYMS_UD &&
+           section.bytes == (uint64_t)range * NUM_SYMS_UD * sizeof(uint16_t);
+}
+
+/******************************************************************************
+* Function:  CubeSymConj::load
+*
+* Purpose:   Points this conjugation table at a section of a table file.
+*
+* Params:    file  - A validated table file, which must stay open for as long
+*                    as this table is in use.
+*            first - Which section of the file holds this table. The caller
+*                    must have checked it with matches.
+*
+* Returns:   Nothing.
+*
+* Operation: The entries are used directly from the mapping rather than being
+*            copied.
+******************************************************************************/
+void CubeSymConj::load(const CubeTableFile& file, int first)
+{
+    storage.clear();
+    storage.shrink_to_fit();
+    table = (const uint16_t*)file.section_data(first);
+}
+
+/******************************************************************************
+* CubeSymTrans class implementation
+******************************************************************************/
+
+/******************************************************************************
+* Function:  CubeSymTrans::CubeSymTrans
+*
+* Purpose:   Constructor for the CubeSymTrans class.
+*
+* Params:    phase_desc  - Whether this table is relevant in phase 1 or phase
+*                          2 of the two-phase algorithm.
+*            func        - Function which calculates the value of the
+*                          coordinate.
+*            set         - Function which gives a cube a particular value of
+*                          the coordinate.
+*            coord_range - The number of values taken by the coordinate.
+*
+* Returns:   Nothing.
+*
+* Operation: Stores the functions and range, and takes copies of the parts of
+*            the symmetry tables that transitions need. Space for the entries
+*            is not allocated until the table is filled, since it may instead
+*            be loaded from a table file.
+******************************************************************************/
+CubeSymTrans::CubeSymTrans(int phase_desc, std::function<int(Cube&)> func,
+                           std::function<void(Cube&, int)> set,
+                           int coord_range)
+{
+    phase = phase_desc;
+    coord_func = func;
+    set_func = set;
+    range = coord_range;
+    classes = 0;
+    _solved_pos = 0;
+    class_index = nullptr;
+    class_sym = nullptr;
+    class_rep = nullptr;
+    class_stab = nullptr;
+    table = nullptr;
+
+    for (int move = 0; move < NUM_MOVES; ++move)
+    {
+        for (int sym = 0; sym < NUM_SYMS_UD; ++sym)
+        {
+            move_conj[move][sym] = cube_conjugate_move(move, sym);
+        }
+    }
+    for (int sym_1 = 0; sym_1 < NUM_SYMS_UD; ++sym_1)
+    {
+        for (int sym_2 = 0; sym_2 < NUM_SYMS_UD; ++sym_2)
+        {
+            sym_product[sym_1][sym_2] = cube_sym_multiply(sym_1, sym_2);
+        }
+    }
+}
+
+/******************************************************************************
+* Function:  CubeSymTrans::size
+*
+* Purpose:   Getter for the number of raw values taken by the coordinate.
+*
+* Params:    None.
+*
+* Returns:   The number of raw values taken by the coordinate.
+*
+* Operation: Simply return the value.
+******************************************************************************/
+int CubeSymTrans::size() const
+{
+    return range;
+}
+
+/******************************************************************************
+* Function:  CubeSymTrans::num_classes
+*
+* Purpose:   Getter for the number of symmetry classes.
+*
+* Params:    None.
+*
+* Returns:   The number of classes, or zero if the table has not been filled
+*            or loaded.
+*
+* Operation: Simply return the value.
+******************************************************************************/
+int CubeSymTrans::num_classes() const
+{
+    return classes;
+}
+
+/******************************************************************************
+* Function:  CubeSymTrans::solved_pos
+*
+* Purpose:   Getter for the sym coordinate of the solved cube.
+*
+* Params:    None.
+*
+* Returns:   The sym coordinate of the solved cube.
+*
+* Operation: Simply return the value.
+******************************************************************************/
+int CubeSymTrans::solved_pos() const
+{
+    return _solved_pos;
+}
+
+/******************************************************************************
+* Function:  CubeSymTrans::rep
+*
+* Purpose:   Looks up the representative of a class.
+*
+* Params:    cls - The class.
+*
+* Returns:   The raw coordinate value of the class representative.
+*
+* Operation: Simply return the stored value.
+******************************************************************************/
+int CubeSymTrans::rep(int cls) const
+{
+    return class_rep[cls];
+}
+
+/******************************************************************************
+* Function:  CubeSymTrans::stabiliser
+*
+* Purpose:   Looks up which symmetries fix the representative of a class.
+*
+* Params:    cls - The class.
+*
+* Returns:   A mask with bit s set if conjugating the representative by
+*            symmetry s leaves its raw coordinate unchanged. Bit 0, for the
+*            identity, is always set.
+*
+* Operation: Simply return the stored value.
+******************************************************************************/
+uint16_t CubeSymTrans::stabiliser(int cls) const
+{
+    return class_stab[cls];
+}
+
+/******************************************************************************
+* Function:  CubeSymTrans::fill
+*
+* Purpose:   Fill in the class tables and the transition table.
+*
+* Params:    None.
+*
+* Returns:   Nothing.
+*
+* Operation: Visits every raw value in order, and each one not yet in a class
+*            becomes the representative of a new class. The class is made up
+*            of the representative's conjugates by the inverse of each
+*            symmetry, so that conjugating a member by the symmetry recorded
+*            for it gives back the representative. The transition table then
+*            needs only one row per class, found by applying each move to a
+*            cube holding the representative.
+******************************************************************************/
+void CubeSymTrans::fill()
+{
+    class_storage.assign(range, CLASS_UNASSIGNED);
+    sym_storage.assign(range, 0);
+    rep_storage.clear();
+    stab_storage.clear();
+
+    for (int raw = 0; raw < range; ++raw)
+    {
+        if (class_storage[raw] != CLASS_UNASSIGNED)
+        {
+            continue;
+        }
+
+        int cls = rep_storage.size();
+        uint16_t stab = 0;
+
+        Cube cube;
+        set_func(cube, raw);
+        for (int sym = 0; sym < NUM_SYMS_UD; ++sym)
+        {
+            Cube conj = cube_conjugate(cube, cube_sym_inverse(sym));
+            int member = coord_func(conj);
+            if (class_storage[member] == CLASS_UNASSIGNED)
+            {
+                class_storage[member] = cls;
+                sym_storage[member] = sym;
+            }
+            if (member == raw)
+            {
+                stab |= 1 << sym;
+            }
+        }
+
+        rep_storage.push_back(raw);
+        stab_storage.push_back(stab);
+    }
+
+    classes = rep_storage.size();
+    class_index = class_storage.data();
+    class_sym = sym_storage.data();
+    class_rep = rep_storage.data();
+    class_stab = stab_storage.data();
+
+    // Work out the available moves
+    const CubeMoveList& allowed_moves = (phase == PHASE_1) ?
+                                        cube_p1_allowed_moves[NUM_MOVES] :
+                                        cube_p2_allowed_moves[NUM_MOVES];
+
+    storage.assign((size_t)classes * NUM_MOVES, 0);
+    for (int cls = 0; cls < classes; ++cls)
+    {
+        Cube cube;
+        set_func(cube, class_rep[cls]);
+        for (int move : allowed_moves)
+        {
+            Cube next = cube.perform_move(move);
+            storage[cls * NUM_MOVES + move] = sym_coord(coord_func(next));
+        }
+    }
+    table = storage.data();
+
+    Cube solved_cube;
+    _solved_pos = sym_coord(coord_func(solved_cube));
+}
+
+/******************************************************************************
+* Function:  CubeSymTrans::save
+*
+* Purpose:   Adds this table to a table file.
+*
+* Params:    writer - The table file being built.
+*
+* Returns:   Nothing.
+*
+* Operation: Adds num_sections sections: the class and symmetry of each raw
+*            value, the representative and stabiliser of each class, and the
+*            transition table. The sym coordinate of the solved cube is
+*            recorded with the transition table.
+******************************************************************************/
+void CubeSymTrans::save(CubeTableWriter& writer) const
+{
+    writer.add_section(SECTION_SYM_CLASS, range, 1, 0, class_index,
+                       (size_t)range * sizeof(uint16_t));
+    writer.add_section(SECTION_SYM_INDEX, range, 1, 0, class_sym,
+                       (size_t)range * sizeof(uint8_t));
+    writer.add_section(SECTION_SYM_REP, classes, 1, 0, class_rep,
+                       (size_t)classes * sizeof(uint32_t));
+    writer.add_section(SECTION_SYM_STAB, classes, 1, 0, class_stab,
+                       (size_t)classes * sizeof(uint16_t));
+    writer.add_section(SECTION_SYM_TRANS, classes, NUM_MOVES, _solved_pos,
+                       table, (size_t)classes * NUM_MOVES * sizeof(uint32_t));
+}
+
+/******************************************************************************
+* Function:  CubeSymTrans::matches
+*
+* Purpose:   Checks whether sections of a table file hold this table.
+*
+* Params:    file  - A validated table file.
+*            first - The first of the num_sections sections to check.
+*
+* Returns:   true if the section types and dimensions match this table.
+*
+* Operation: The number of classes is taken from the file, but must be the
+*            same in every section which depends on it.
+******************************************************************************/
+bool CubeSymTrans::matches(const CubeTableFile& file, int first) const
+{
+    if (file.num_sections() < first + num_sections)
+    {
+        return false;
+    }
+
+    const CubeTableSection& index = file.section(first);
+    const CubeTableSection& syms = file.section(first + 1);
+    const CubeTableSection& reps = file.section(first + 2);
+    const CubeTableSection& stabs = file.section(first + 3);
+    const CubeTableSection& trans = file.section(first + 4);
+    uint64_t count = reps.rows;
+
+    return index.type == SECTION_SYM_CLASS &&
+           index.rows == (uint32_t)range &&
+           index.bytes == (uint64_t)range * sizeof(uint16_t) &&
+           syms.type == SECTION_SYM_INDEX &&
+           syms.rows == (uint32_t)range &&
+           syms.bytes == (uint64_t)range * sizeof(uint8_t) &&
+           reps.type == SECTION_SYM_REP &&
+           reps.bytes == count * sizeof(uint32_t) &&
+           stabs.type == SECTION_SYM_STAB && stabs.rows == count &&
+           stabs.bytes == count * sizeof(uint16_t) &&
+           trans.type == SECTION_SYM_TRANS && trans.rows == count &&
+           trans.cols == NUM_MOVES &&
+           trans.bytes == count * NUM_MOVES * sizeof(uint32_t);
+}
+
+/******************************************************************************
+* Function:  CubeSymTrans::load
+*
+* Purpose:   Points this table at sections of a table file.
+*
+* Params:    file  - A validated table file, which must stay open for as long
+*                    as this table is in use.
+*            first - The first of the num_sections sections holding this
+*                    table. The caller must have checked them with matches.
+*
+* Returns:   Nothing.
+*
+* Operation: Every part of the table is used directly from the mapping rather
+*            than being copied.
+******************************************************************************/
+void CubeSymTrans::load(const CubeTableFile& file, int first)
+{
+    class_storage.clear();
+    class_storage.shrink_to_fit();
+    sym_storage.clear();
+    sym_storage.shrink_to_fit();
+    rep_storage.clear();
+    rep_storage.shrink_to_fit();
+    stab_storage.clear();
+    stab_storage.shrink_to_fit();
+    storage.clear();
+    storage.shrink_to_fit();
+
+    classes = file.section(first + 2).rows;
+    _solved_pos = file.section(first + 4).solved_pos;
+    class_index = (const uint16_t*)file.section_data(first);
+    class_sym = (const uint8_t*)file.section_data(first + 1);
+    class_rep = (const uint32_t*)file.section_data(first + 2);
+    class_stab = (const uint16_t*)file.section_data(first + 3);
+    table = (const uint32_t*)file.section_data(first + 4);
+}
@@ -8,80 +8,596 @@
 /******************************************************************************
 * Includes
 ******************************************************************************/
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
 #include <cube.h>
+#include <cubecache.h>
+#include <cubecornerprune.h>
+#include <cubemem.h>
 #include <cubephase.h>
+#include <cubepool.h>
 #include <cubeprune.h>
+#include <cubephase1prune.h>
+#include <cubephase2prune.h>
+#include <cubesymtrans.h>
 #include <cubetrans.h>
 #include <cubetables.h>
 
 /******************************************************************************
-* Initial definitions of the transition tables
+* Lists of the tables in the order in which they appear in a table file.
+******************************************************************************/
+static CubeTrans SolverTables::* const all_trans_tables[] = {
+    &SolverTables::co_trans,        &SolverTables::eo_trans,
+    &SolverTables::cp_trans,        &SolverTables::ud_sorted_trans,
+    &SolverTables::rl_sorted_trans, &SolverTables::fb_sorted_trans,
+    &SolverTables::ep_trans,        &SolverTables::ud_unsorted_trans,
+    &SolverTables::ud_perm_trans};
+
+static CubePrune SolverTables::* const all_pruning_tables[] = {
+    &SolverTables::co_eo_prune, &SolverTables::co_ud_prune,
+    &SolverTables::eo_ud_prune, &SolverTables::ep_ud_prune,
+    &SolverTables::cp_ud_prune};
+
+typedef CubeCoord<&Cube::coord_corner_orientation,
+                  &Cube::set_corner_orientation>  CoordCO;
+typedef CubeCoord<&Cube::coord_edge_orientation,
+                  &Cube::set_edge_orientation>    CoordEO;
+typedef CubeCoord<&Cube::coord_corner_permutation,
+                  &Cube::set_corner_permutation>  CoordCP;
+typedef CubeCoord<&Cube::coord_ud_sorted,
+                  &Cube::set_ud_sorted>           CoordUDSorted;
+typedef CubeCoord<&Cube::coord_rl_sorted,
+                  &Cube::set_rl_sorted>           CoordRLSorted;
+typedef CubeCoord<&Cube::coord_fb_sorted,
+                  &Cube::set_fb_sorted>           CoordFBSorted;
+typedef CubeCoord<&Cube::coord_edge_permutation,
+                  &Cube::set_edge_permutation>    CoordEP;
+typedef CubeCoord<&Cube::coord_ud_unsorted,
+                  &Cube::set_ud_unsorted>         CoordUDUnsorted;
+typedef CubeCoord<&Cube::coord_ud_permutation,
+                  &Cube::set_ud_permutation>      CoordUDPerm;
+
+static const int num_trans_tables =
+                      sizeof(all_trans_tables) / sizeof(all_trans_tables[0]);
+static const int num_pruning_tables =
+                  sizeof(all_pruning_tables) / sizeof(all_pruning_tables[0]);
+
+static_assert(TABLE_CO_EO_PRUNE == num_trans_tables &&
+              TABLE_PHASE1 == num_trans_tables + num_pruning_tables,
+              "SolverTableId must follow the order of the table lists");
+
+/******************************************************************************
+* Helper functions
 ******************************************************************************/
-CubeTrans cube_co_trans(PHASE_1, &Cube::coord_corner_orientation, 2187);
-CubeTrans cube_eo_trans(PHASE_1, &Cube::coord_edge_orientation, 2048);
-CubeTrans cube_cp_trans(PHASE_1, &Cube::coord_corner_permutation, 40320);
-CubeTrans cube_ud_sorted_trans(PHASE_1, &Cube::coord_ud_sorted, 11880);
-CubeTrans cube_rl_sorted_trans(PHASE_1, &Cube::coord_rl_sorted, 11880);
-CubeTrans cube_fb_sorted_trans(PHASE_1, &Cube::coord_fb_sorted, 11880);
-CubeTrans cube_ep_trans(PHASE_2, &Cube::coord_edge_permutation, 40320);
-CubeTrans cube_ud_unsorted_trans(PHASE_1, &Cube::coord_ud_unsorted, 495);
-CubeTrans cube_ud_perm_trans(PHASE_2, &Cube::coord_ud_permutation, 24);
 
 /******************************************************************************
-* Initial definitions of the pruning tables
+* Function:  resolve_options
+*
+* Purpose:   Works out which tables a set of options really needs.
+*
+* Params:    table_options - The options asked for.
+*
+* Returns:   The same options, with the tables needed by others turned on.
+*
+* Operation: The optimal solver reads the full phase-1 table, and the corner
+*            table shares its conjugation table, so optimal implies
+*            full_phase1.
+******************************************************************************/
+static TableOptions resolve_options(const TableOptions& table_options)
+{
+    TableOptions resolved = table_options;
+    resolved.full_phase1 = resolved.full_phase1 || resolved.optimal;
+    return resolved;
+}
+
+/******************************************************************************
+* SolverTables class implementation
 ******************************************************************************/
-CubePrune cube_co_eo_prune(PHASE_1, &cube_co_trans, &cube_eo_trans);
-CubePrune cube_co_ud_prune(PHASE_1, &cube_co_trans, &cube_ud_unsorted_trans);
-CubePrune cube_eo_ud_prune(PHASE_1, &cube_eo_trans, &cube_ud_unsorted_trans);
-CubePrune cube_ep_ud_prune(PHASE_2, &cube_ep_trans, &cube_ud_perm_trans);
-CubePrune cube_cp_ud_prune(PHASE_2, &cube_cp_trans, &cube_ud_perm_trans);
 
 /******************************************************************************
-* Implementation of functions which populate the tables with data.
+* Function:  SolverTables::SolverTables
+*
+* Purpose:   Constructor for the SolverTables class.
+*
+* Params:    table_options - Which optional tables to build. Tables needed by
+*                            the ones asked for are built too.
+*
+* Returns:   Nothing.
+*
+* Operation: Sets up every table with the coordinate it describes. The tables
+*            are empty until they are filled or loaded.
 ******************************************************************************/
+SolverTables::SolverTables(const TableOptions& table_options)
+    : options(resolve_options(table_options)),
+      co_trans(PHASE_1, CoordCO(), 2187),
+      eo_trans(PHASE_1, CoordEO(), 2048),
+      cp_trans(PHASE_1, CoordCP(), 40320),
+      ud_sorted_trans(PHASE_1, CoordUDSorted(), 11880),
+      rl_sorted_trans(PHASE_1, CoordRLSorted(), 11880),
+      fb_sorted_trans(PHASE_1, CoordFBSorted(), 11880),
+      ep_trans(PHASE_2, CoordEP(), 40320),
+      ud_unsorted_trans(PHASE_1, CoordUDUnsorted(), 495),
+      ud_perm_trans(PHASE_2, CoordUDPerm(), 24),
+      co_eo_prune(PHASE_1, &co_trans, &eo_trans),
+      co_ud_prune(PHASE_1, &co_trans, &ud_unsorted_trans),
+      eo_ud_prune(PHASE_1, &eo_trans, &ud_unsorted_trans),
+      ep_ud_prune(PHASE_2, &ep_trans, &ud_perm_trans),
+      cp_ud_prune(PHASE_2, &cp_trans, &ud_perm_trans),
+      flipslice_trans(PHASE_1, &Cube::coord_flipslice, &Cube::set_flipslice,
+                      P1_NUM_FLIPSLICE),
+      twist_conj(&Cube::coord_corner_orientation,
+                 &Cube::set_corner_orientation, P1_NUM_TWIST),
+      phase1_prune(&flipslice_trans, &twist_conj, &co_trans),
+      cp_sym_trans(PHASE_2, &Cube::coord_corner_permutation,
+                   &Cube::set_corner_permutation, P2_NUM_CORNERS),
+      ep_conj(&Cube::coord_edge_permutation, &Cube::set_edge_permutation,
+              P2_NUM_EDGES),
+      phase2_prune(&cp_sym_trans, &ep_conj, &ep_trans),
+      corner_sym_trans(PHASE_1, &Cube::coord_corner_permutation,
+                       &Cube::set_corner_permutation, CORNER_NUM_PERMS),
+      corner_prune(&corner_sym_trans, &twist_conj, &co_trans)
+{
+}
 
 /******************************************************************************
-* Function:  cube_fill_all_trans_tables
+* Function:  SolverTables::fill_trans_tables
 *
 * Purpose:   Populate all transition tables for the cube.
 *
-* Params:    None.
+* Params:    pool - The pool to spread the work over. If not set, a pool with
+*                   one thread per core is created for the call.
 *
 * Returns:   Nothing.
 *
 * Operation: Calls into each of the functions responsible for populating a
-*            particular transition table.
+*            particular transition table, including the symmetry tables of
+*            any optional tables which are enabled.
 ******************************************************************************/
-void cube_fill_all_trans_tables()
+void SolverTables::fill_trans_tables(CubeThreadPool* pool)
 {
-    cube_co_trans.fill();
-    cube_eo_trans.fill();
-    cube_cp_trans.fill();
-    cube_ud_sorted_trans.fill();
-    cube_rl_sorted_trans.fill();
-    cube_fb_sorted_trans.fill();
-    cube_ep_trans.fill();
-    cube_ud_unsorted_trans.fill();
-    cube_ud_perm_trans.fill();
+    std::unique_ptr<CubeThreadPool> own_pool;
+    if (pool == nullptr)
+    {
+        own_pool.reset(new CubeThreadPool());
+        pool = own_pool.get();
+    }
+
+    for (int ii = 0; ii < num_trans_tables; ++ii)
+    {
+        (this->*all_trans_tables[ii]).fill(pool);
+    }
+    if (options.full_phase1)
+    {
+        flipslice_trans.fill();
+        twist_conj.fill();
+    }
+    if (options.full_phase2)
+    {
+        cp_sym_trans.fill();
+        ep_conj.fill();
+    }
+    if (options.optimal)
+    {
+        corner_sym_trans.fill();
+    }
 }
 
 /******************************************************************************
-* Function:  cube_fill_all_pruning_tables
+* Function:  SolverTables::fill_pruning_tables
 *
 * Purpose:   Populate all pruning tables for the cube.
 *
-* Params:    None.
+* Params:    pool - The pool to spread the work over. If not set, a pool with
+*                   one thread per core is created for the call.
 *
 * Returns:   Nothing.
 *
 * Operation: Calls into each of the functions responsible for populating a
-*            particular pruning table.
+*            particular pruning table, including any optional tables which
+*            are enabled. The transition tables must already have been
+*            filled. Each table is filled in turn, using the whole pool.
+******************************************************************************/
+void SolverTables::fill_pruning_tables(CubeThreadPool* pool)
+{
+    std::unique_ptr<CubeThreadPool> own_pool;
+    if (pool == nullptr)
+    {
+        own_pool.reset(new CubeThreadPool());
+        pool = own_pool.get();
+    }
+
+    for (int ii = 0; ii < num_pruning_tables; ++ii)
+    {
+        (this->*all_pruning_tables[ii]).fill(pool, options.placement);
+    }
+    if (options.full_phase1)
+    {
+        phase1_prune.fill(pool, options.placement);
+    }
+    if (options.full_phase2)
+    {
+        phase2_prune.fill(pool, options.placement);
+    }
+    if (options.optimal)
+    {
+        corner_prune.fill(pool, options.placement);
+    }
+}
+
+/******************************************************************************
+* Function:  SolverTables::uses_table
+*
+* Purpose:   Tells whether a table is built with these options.
+*
+* Params:    table - The table or group of tables.
+*
+* Returns:   true for the transition and pairwise pruning tables, which are
+*            always built, and for each optional group which is enabled.
+*
+* Operation: Checks the option for each optional group.
+******************************************************************************/
+bool SolverTables::uses_table(SolverTableId table) const
+{
+    switch (table)
+    {
+    case TABLE_PHASE1:
+        return options.full_phase1;
+    case TABLE_PHASE2:
+        return options.full_phase2;
+    case TABLE_CORNER:
+        return options.optimal;
+    default:
+        return table < NUM_SOLVER_TABLES;
+    }
+}
+
+/******************************************************************************
+* Function:  SolverTables::fill_table
+*
+* Purpose:   Populates a single table, or group of tables.
+*
+* Params:    table - The table or group to fill.
+*            pool  - The pool to spread the work over, or nullptr to fill on
+*                    the calling thread.
+*
+* Returns:   Nothing.
+*
+* Operation: Fills the table just as fill_trans_tables or fill_pruning_tables
+*            would. A pruning table reads the transition tables it is built
+*            from, so they must be filled first: co_trans for TABLE_PHASE1,
+*            ep_trans for TABLE_PHASE2, co_trans and TABLE_PHASE1 for
+*            TABLE_CORNER, and the two coordinates it pairs for each pairwise
+*            table.
+******************************************************************************/
+void SolverTables::fill_table(SolverTableId table, CubeThreadPool* pool)
+{
+    if (table < num_trans_tables)
+    {
+        (this->*all_trans_tables[table]).fill(pool);
+    }
+    else if (table < num_trans_tables + num_pruning_tables)
+    {
+        (this->*all_pruning_tables[table - num_trans_tables]).fill(
+                                                    pool, options.placement);
+    }
+    else if (table == TABLE_PHASE1)
+    {
+        flipslice_trans.fill();
+        twist_conj.fill();
+        phase1_prune.fill(pool, options.placement);
+    }
+    else if (table == TABLE_PHASE2)
+    {
+        cp_sym_trans.fill();
+        ep_conj.fill();
+        phase2_prune.fill(pool, options.placement);
+    }
+    else if (table == TABLE_CORNER)
+    {
+        corner_sym_trans.fill();
+        corner_prune.fill(pool, options.placement);
+    }
+}
+
+/******************************************************************************
+* Function:  SolverTables::save
+*
+* Purpose:   Writes all transition and pruning tables to a table file.
+*
+* Params:    path - Where the file should be written.
+*
+* Returns:   true if the file was written successfully, false otherwise.
+*
+* Operation: Adds every table to a CubeTableWriter, transition tables first
+*            and optional tables last, and writes it out. The tables must
+*            already have been filled.
+******************************************************************************/
+bool SolverTables::save(const std::string& path) const
+{
+    CubeTableWriter writer;
+    for (int ii = 0; ii < num_trans_tables; ++ii)
+    {
+        (this->*all_trans_tables[ii]).save(writer);
+    }
+    for (int ii = 0; ii < num_pruning_tables; ++ii)
+    {
+        (this->*all_pruning_tables[ii]).save(writer);
+    }
+    if (options.full_phase1)
+    {
+        flipslice_trans.save(writer);
+        twist_conj.save(writer);
+        phase1_prune.save(writer);
+    }
+    if (options.full_phase2)
+    {
+        cp_sym_trans.save(writer);
+        ep_conj.save(writer);
+        phase2_prune.save(writer);
+    }
+    if (options.optimal)
+    {
+        corner_sym_trans.save(writer);
+        corner_prune.save(writer);
+    }
+
+    return writer.write(path, cube_p1_moves, cube_p2_moves);
+}
+
+/******************************************************************************
+* Function:  SolverTables::load
+*
+* Purpose:   Populates all transition and pruning tables from a table file.
+*
+* Params:    path - The file to read.
+*
+* Returns:   true if every table was loaded, false if the file is missing or
+*            stale, in which case the tables must be filled some other way.
+*
+* Operation: Maps and validates the file, or reads it into memory placed as
+*            the options ask, then checks that it holds the expected tables
+*            before loading each one. The file stays mapped for the lifetime
+*            of this object, since the tables refer into it.
+*            A file holding optional tables which are not enabled is still
+*            usable; the extra tables are simply ignored. The optional phase 1
+*            tables, when present, come first, then the optional phase 2
+*            tables, then the optimal solver's corner tables.
+******************************************************************************/
+bool SolverTables::load(const std::string& path)
+{
+    int optional_first = num_trans_tables + num_pruning_tables;
+
+    std::unique_ptr<CubeTableFile> new_file(new CubeTableFile());
+    if (!new_file->open(path, cube_p1_moves, cube_p2_moves,
+                        options.placement) ||
+        new_file->num_sections() < optional_first)
+    {
+        return false;
+    }
+
+    // Check every table before touching any of them, so that a stale file
+    // leaves the current tables intact.
+    for (int ii = 0; ii < num_trans_tables; ++ii)
+    {
+        if (!(this->*all_trans_tables[ii]).matches(*new_file, ii))
+        {
+            return false;
+        }
+    }
+    for (int ii = 0; ii < num_pruning_tables; ++ii)
+    {
+        if (!(this->*all_pruning_tables[ii]).matches(*new_file,
+                                                     num_trans_tables + ii))
+        {
+            return false;
+        }
+    }
+    int twist_first = optional_first + CubeSymTrans::num_sections;
+    int phase1_first = twist_first + CubeSymConj::num_sections;
+    bool has_phase1 = flipslice_trans.matches(*new_file, optional_first) &&
+                      twist_conj.matches(*new_file, twist_first) &&
+                      phase1_prune.matches(*new_file, phase1_first);
+    if (options.full_phase1 && !has_phase1)
+    {
+        return false;
+    }
+
+    int cp_sym_first = (has_phase1) ?
+                       phase1_first + CubePhase1Prune::num_sections :
+                       optional_first;
+    int ep_conj_first = cp_sym_first + CubeSymTrans::num_sections;
+    int phase2_first = ep_conj_first + CubeSymConj::num_sections;
+    bool has_phase2 = cp_sym_trans.matches(*new_file, cp_sym_first) &&
+                      ep_conj.matches(*new_file, ep_conj_first) &&
+                      phase2_prune.matches(*new_file, phase2_first);
+    if (options.full_phase2 && !has_phase2)
+    {
+        return false;
+    }
+
+    int corner_sym_first = (has_phase2) ?
+                           phase2_first + CubePhase2Prune::num_sections :
+                           cp_sym_first;
+    int corner_first = corner_sym_first + CubeSymTrans::num_sections;
+    if (options.optimal &&
+        (!corner_sym_trans.matches(*new_file, corner_sym_first) ||
+         !corner_prune.matches(*new_file, corner_first)))
+    {
+        return false;
+    }
+
+    for (int ii = 0; ii < num_trans_tables; ++ii)
+    {
+        (this->*all_trans_tables[ii]).load(*new_file, ii);
+    }
+    for (int ii = 0; ii < num_pruning_tables; ++ii)
+    {
+        (this->*all_pruning_tables[ii]).load(*new_file, num_trans_tables + ii);
+    }
+    if (options.full_phase1)
+    {
+        flipslice_trans.load(*new_file, optional_first);
+        twist_conj.load(*new_file, twist_first);
+        phase1_prune.load(*new_file, phase1_first);
+    }
+    if (options.full_phase2)
+    {
+        cp_sym_trans.load(*new_file, cp_sym_first);
+        ep_conj.load(*new_file, ep_conj_first);
+        phase2_prune.load(*new_file, phase2_first);
+    }
+    if (options.optimal)
+    {
+        corner_sym_trans.load(*new_file, corner_sym_first);
+        corner_prune.load(*new_file, corner_first);
+    }
+
+    file = std::move(new_file);
+    return true;
+}
+
+/******************************************************************************
+* Function:  SolverTables::init
+*
+* Purpose:   Makes all transition and pruning tables ready for use, using a
+*            table file as a cache.
+*
+* Params:    path - The table file to load from, or create.
+*
+* Returns:   true if the tables were loaded from the file, false if they had
+*            to be regenerated.
+*
+* Operation: Tries to load the file. If it is missing or stale, generates the
+*            tables from scratch, using every core, and writes a fresh file
+*            for next time. Failure to write the file is not an error, since
+*            the tables are usable either way.
+******************************************************************************/
+bool SolverTables::init(const std::string& path)
+{
+    if (load(path))
+    {
+        return true;
+    }
+
+    CubeThreadPool pool;
+    fill_trans_tables(&pool);
+    fill_pruning_tables(&pool);
+    save(path);
+    return false;
+}
+
+/******************************************************************************
+* CubeTableReplicas class implementation
+******************************************************************************/
+
+/******************************************************************************
+* Function:  CubeTableReplicas::init
+*
+* Purpose:   Sets up one set of tables on each NUMA node with processors.
+*
+* Params:    path          - The table file to load from, or create.
+*            table_options - The tables to build, and the kind of pages to
+*                            put them on. The node is set for each replica.
+*
+* Returns:   true if every replica was loaded from the file, false if the
+*            tables had to be generated.
+*
+* Operation: Each replica is initialised on a thread pinned to its node, so
+*            that whatever memory it touches first, including any filled
+*            transition tables, lands there along with the memory bound to
+*            the node explicitly. Only the first replica can need to fill
+*            and write the file; the others then load it. Node numbers may
+*            have gaps, and nodes without processors are skipped. If that
+*            leaves none, a single replica is set up with no node.
+******************************************************************************/
+bool CubeTableReplicas::init(const std::string& path,
+                             const TableOptions& table_options)
+{
+    replicas.clear();
+    nodes.clear();
+
+    bool loaded = true;
+    int num_nodes = cube_numa_nodes();
+    for (int node = 0; node < num_nodes; ++node)
+    {
+        if (cube_numa_cpus(node).empty())
+        {
+            continue;
+        }
+
+        TableOptions node_options = table_options;
+        node_options.placement.node = node;
+        replicas.emplace_back(new SolverTables(node_options));
+        nodes.push_back(node);
+
+        SolverTables& replica = *replicas.back();
+        std::thread setup([&replica, &path, &loaded, node]
+        {
+            cube_pin_thread(node);
+            loaded = replica.init(path) && loaded;
+        });
+        setup.join();
+    }
+
+    if (replicas.empty())
+    {
+        TableOptions any_options = table_options;
+        any_options.placement.node = -1;
+        replicas.emplace_back(new SolverTables(any_options));
+        nodes.push_back(-1);
+        loaded = replicas.back()->init(path);
+    }
+    return loaded;
+}
+
+/******************************************************************************
+* Function:  CubeTableReplicas::size
+*
+* Purpose:   Getter for the number of replicas.
+*
+* Params:    None.
+*
+* Returns:   The number of replicas, one per NUMA node with processors.
+*
+* Operation: Simply return the value.
+******************************************************************************/
+int CubeTableReplicas::size() const
+{
+    return replicas.size();
+}
+
+/******************************************************************************
+* Function:  CubeTableReplicas::node
+*
+* Purpose:   Gives the node a replica is placed on.
+*
+* Params:    index - The replica, in the range 0..size()-1.
+*
+* Returns:   The NUMA node, or -1 if the replica is tied to no node.
+*
+* Operation: Simply return the value.
+******************************************************************************/
+int CubeTableReplicas::node(int index) const
+{
+    return nodes[index];
+}
+
+/******************************************************************************
+* Function:  CubeTableReplicas::tables
+*
+* Purpose:   Gives a replica.
+*
+* Params:    index - The replica, in the range 0..size()-1.
+*
+* Returns:   The tables placed on the replica's node.
+*
+* Operation: Simply return the value.
 ******************************************************************************/
-void cube_fill_all_pruning_tables()
+const SolverTables& CubeTableReplicas::tables(int index) const
 {
-    cube_co_eo_prune.fill();
-    cube_co_ud_prune.fill();
-    cube_eo_ud_prune.fill();
-    cube_ep_ud_prune.fill();
-    cube_cp_ud_prune.fill();
+    return *replicas[index];
 }
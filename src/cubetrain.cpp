@@ -0,0 +1,84 @@
+/******************************************************************************
+* File:    cubetrain.cpp
+*
+* Purpose: Training workload for profile-guided builds. Solves a fixed set of
+*          random scrambles in the ways the solver is normally used, so that
+*          the recorded profile reflects the real search.
+******************************************************************************/
+
+/******************************************************************************
+* Dependencies
+******************************************************************************/
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+#include <cube.h>
+#include <cubecorpus.h>
+#include <cubepool.h>
+#include <cubesolver.h>
+#include <cubetables.h>
+
+/******************************************************************************
+* Constants
+*
+* The number of cubes solved for each kind of solve, the seed of the corpus
+* they are drawn from and the node budget given to each solve.
+******************************************************************************/
+#define TRAIN_CUBES       40
+#define TRAIN_SEED        0x5EED
+#define TRAIN_NODE_LIMIT  2000000
+
+/******************************************************************************
+* Function:  main
+*
+* Purpose:   Runs the training workload.
+*
+* Params:    argv[1] - Optional path of the table file to use, which is created
+*                      if it does not exist. Defaults to cubetables.dat.
+*
+* Returns:   0 on success, 1 if any cube was not solved.
+*
+* Operation: Each cube is solved once with a single sequential search and once
+*            with a multi-axis search, whose orientations run concurrently on
+*            one pool, both under a node budget so that the run takes a
+*            predictable time.
+******************************************************************************/
+int main(int argc, char** argv)
+{
+    const char* path = (argc > 1) ? argv[1] : "cubetables.dat";
+    SolverTables tables;
+    tables.init(path);
+
+    std::vector<Cube> cubes = cube_scramble_corpus(TRAIN_SEED, TRAIN_CUBES);
+    SolveOptions options;
+    options.node_limit = TRAIN_NODE_LIMIT;
+    int failed = 0;
+    long long total_length = 0;
+
+    CubeThreadPool pool(SOLVE_ORIENTATIONS);
+    for (int multi_axis = 0; multi_axis < 2; multi_axis++)
+    {
+        options.multi_axis = (multi_axis != 0);
+        options.pool = options.multi_axis ? &pool : nullptr;
+        for (const Cube& cube : cubes)
+        {
+            CubeSolver solver(tables, cube);
+            SolveResult result = solver.solve(options);
+            if (result.length < 0)
+            {
+                failed++;
+            }
+            else
+            {
+                total_length += result.length;
+            }
+        }
+    }
+
+    std::cout << "Solved " << (2 * TRAIN_CUBES - failed) << " of "
+              << (2 * TRAIN_CUBES) << " cubes, " << total_length
+              << " moves in total" << std::endl;
+
+    return (failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -8,42 +8,25 @@
 /******************************************************************************
 * Dependencies
 ******************************************************************************/
-#include <functional>
-#include <stack>
+#include <cstdint>
 #include <vector>
 
 #include <cube.h>
+#include <cubecache.h>
 #include <cubephase.h>
+#include <cubepool.h>
 #include <cubetrans.h>
 
 /******************************************************************************
-* Cubetrans class implementation
+* Constants
+*
+* The number of coordinate values each task fills in a parallel fill.
 ******************************************************************************/
+#define TRANS_FILL_CHUNK 1024
 
 /******************************************************************************
-* Function:  CubeTrans::CubeTrans
-*
-* Purpose:   Constructor for the CubeTrans class.
-*
-* Params:    phase_desc - Whether this pruning table is relevant in phase 1
-*                         or phase 2 of the two-phase algorithm.
-*            func       - Pointer to Cube member function which calculates the
-*                         value of some coordinate.
-*            range      - The number of values taken by the above coordinate.
-*
-* Returns:   Nothing.
-*
-* Operation: Stores the function pointer as a member variable and allocates
-*            space for the transition table entries. Also stores the moves
-*            allowed for the given phase.
+* Cubetrans class implementation
 ******************************************************************************/
-CubeTrans::CubeTrans(int phase_desc, std::function<int(Cube&)> func, int range)
-{
-    phase = phase_desc;
-    coord_func = func;
-    table = std::vector<std::vector<int>>(range,
-                                          std::vector<int>(NUM_MOVES, -1));
-}
 
 /******************************************************************************
 * Function:  CubeTrans::solved_pos
@@ -56,7 +39,7 @@ CubeTrans::CubeTrans(int phase_desc, std::function<int(Cube&)> func, int range)
 *
 * Operation: Simply return the value.
 ******************************************************************************/
-int CubeTrans::solved_pos()
+int CubeTrans::solved_pos() const
 {
     return _solved_pos;
 }
@@ -72,91 +55,97 @@ int CubeTrans::solved_pos()
 *
 * Operation: Simply return the value.
 ******************************************************************************/
-int CubeTrans::size()
+int CubeTrans::size() const
 {
-    return table.size();
+    return range;
 }
 
 /******************************************************************************
-* Function:  CubeTrans::operator()
+* Function:  CubeTrans::fill
 *
-* Purpose:   Returns an entry in the transition table.
+* Purpose:   Fills in the entries of this transition table.
 *
-* Params:    position - The coordinate value of the 'from' position
-*            move     - The move to be performed.
+* Params:    pool - If set, the work is spread over this pool.
 *
-* Returns:   The coordinate value of the resulting position.
+* Returns:   Nothing.
 *
-* Operation: Simply return the value from the private table.
+* Operation: Every coordinate value has a cube built from it by the
+*            coordinate's set function, so the table is filled by running
+*            through the values directly, in chunks shared out over the pool.
+*            Entries for moves not allowed in this table's phase are left as
+*            zero.
 ******************************************************************************/
-int CubeTrans::operator()(int position, int move)
+void CubeTrans::fill(CubeThreadPool* pool)
 {
-    return table[position][move];
+    // Allocate space for the entries.
+    storage.assign(range * NUM_MOVES, 0);
+    table = storage.data();
+
+    cube_parallel_for(pool, range, TRANS_FILL_CHUNK, [this](long begin,
+                                                            long end)
+    {
+        fill_rows(*this, begin, end);
+    });
 }
 
 /******************************************************************************
-* Function:  CubeTrans::fill
+* Function:  CubeTrans::save
 *
-* Purpose:   Fills in the entries of this transition table.
+* Purpose:   Adds this transition table to a table file.
 *
-* Params:    None.
+* Params:    writer - The table file being built.
 *
 * Returns:   Nothing.
 *
-* Operation: Starting from the solved position, uses a depth-first search of
-*            cube positions, visiting each value of the coordinate exactly once
-*            and determining the result of each move on it.
+* Operation: The table is already stored row-major, so it is recorded as is
+*            along with its dimensions and solved position.
 ******************************************************************************/
-void CubeTrans::fill()
+void CubeTrans::save(CubeTableWriter& writer) const
 {
-    // Local variables
-    Cube curr_cube, next_cube;
-    int curr_coord, next_coord;
-
-    // Set up a stack which we will use to perform the depth-first search and
-    // an auxiliary array which will keep track of which coordinate values we
-    // have already pushed onto the stack, to avoid duplication.
-    std::stack<Cube> dfs;
-    std::vector<bool> seen(table.size(), false);
-
-    // Push the solved position onto the stack and record the coordinate value
-    // of the solved cube.
-    Cube solved_cube;
-    _solved_pos = coord_func(solved_cube);
-    seen[_solved_pos] = true;
-    dfs.push(solved_cube);
-
-    // Work out the available moves
-    if (phase == PHASE_1)
-    {
-        allowed_moves = cube_p1_allowed_moves[NUM_MOVES];
-    }
-    else if (phase == PHASE_2)
-    {
-        allowed_moves = cube_p2_allowed_moves[NUM_MOVES];
-    }
-
-    // Perform the depth-first search
-    while (!dfs.empty())
-    {
-        // Get the top cube from the stack, and record the result of each move
-        // on the coordinate value.
-        curr_cube = dfs.top();
-        curr_coord = coord_func(curr_cube);
-        dfs.pop();
+    writer.add_section(SECTION_TRANS, range, NUM_MOVES, _solved_pos,
+                       table, range * NUM_MOVES * sizeof(uint16_t));
+}
 
-        for (int move : allowed_moves)
-        {
-            next_cube = curr_cube.perform_move(move);
-            next_coord = coord_func(next_cube);
-            table[curr_coord][move] = next_coord;
+/******************************************************************************
+* Function:  CubeTrans::matches
+*
+* Purpose:   Checks whether a section of a table file holds this table.
+*
+* Params:    file  - A validated table file.
+*            index - Which section of the file to check.
+*
+* Returns:   true if the section type and dimensions match this table.
+*
+* Operation: Compares the section descriptor against this table.
+******************************************************************************/
+bool CubeTrans::matches(const CubeTableFile& file, int index) const
+{
+    const CubeTableSection& section = file.section(index);
+    return section.type == SECTION_TRANS &&
+           section.rows == (uint32_t)range &&
+           section.cols == NUM_MOVES &&
+           section.bytes == range * NUM_MOVES * sizeof(uint16_t);
+}
 
-            // Push the resulting cube onto the stack if necessary.
-            if (!seen[next_coord])
-            {
-                seen[next_coord] = true;
-                dfs.push(next_cube);
-            }
-        }
-    }
+/******************************************************************************
+* Function:  CubeTrans::load
+*
+* Purpose:   Points this transition table at a section of a table file.
+*
+* Params:    file  - A validated table file, which must stay open for as long
+*                    as this table is in use.
+*            index - Which section of the file holds this table. The caller
+*                    must have checked it with matches.
+*
+* Returns:   Nothing.
+*
+* Operation: The entries are used directly from the mapping rather than being
+*            copied, so pages are only read in as the search touches them.
+******************************************************************************/
+void CubeTrans::load(const CubeTableFile& file, int index)
+{
+    storage.clear();
+    storage.shrink_to_fit();
+    table = (const uint16_t*)file.section_data(index);
+    _solved_pos = file.section(index).solved_pos;
 }
@@ -2,7 +2,6 @@
 #include <vector>
 
 #include <cube.h>
-#include <cubephase.h>
 #include <cubetables.h>
 #include <cubesolver.h>
 
@@ -10,12 +9,13 @@
 int main()
 {
     // Common initialisation that must be done at startup.
-    std::cout << "Initialising..." << std::endl;
-    cube_create_allowed_moves();
-    std::cout << "Generating transition tables..." << std::endl;
-    cube_fill_all_trans_tables();
-    std::cout << "Generating pruning tables..." << std::endl;
-    cube_fill_all_pruning_tables();
+    std::cout << "Loading tables..." << std::endl;
+    SolverTables tables;
+    if (!tables.init("cubetables.dat"))
+    {
+        std::cout << "Tables generated and cached in cubetables.dat"
+                  << std::endl;
+    }
 
     // The state of the cube that should be solved. The various vectors are
     // defined as follows:
@@ -55,10 +55,25 @@ int main()
                                     FLIP_NONE, FLIP_NONE, FLIP_NONE};
 
     Cube scrambled_cube(corner_perm, corner_orient, edge_perm, edge_orient);
-    CubeSolver solver(scrambled_cube);
+
+    // Cubes can also be read from a 54-character facelet string, or from a
+    // scramble such as "R U2 F'", with Cube::from_facelets and
+    // Cube::from_moves, which reject any cube that cannot be solved.
+    CubeSolver solver(tables, scrambled_cube);
+
+    // Print each solution as it is found. The search runs until the shortest
+    // two-phase solution has been found; see SolveOptions for ways to stop it
+    // sooner.
+    SolveOptions options;
+    options.process_sol = [](const SolveResult& result)
+    {
+        std::cout << "Length: " << result.length << "\n"
+                  << cube_solution_string(result.moves) << "\n\n"
+                  << std::flush;
+    };
 
     std::cout << "Solving..." << std::endl << std::endl;
-    solver.solve();
+    solver.solve(options);
 
     return 0;
 }
@@ -0,0 +1,524 @@
+/******************************************************************************
+* File:    cubetest.cpp
+*
+* Purpose: Checks of the solver's guarantees. Each check solves cubes whose
+*          solution length is known and checks what the solver reports
+*          about them.
+******************************************************************************/
+
+/******************************************************************************
+* Dependencies
+******************************************************************************/
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <cube.h>
+#include <cubemem.h>
+#include <cubepool.h>
+#include <cubesolcache.h>
+#include <cubesolver.h>
+#include <cubetables.h>
+
+/******************************************************************************
+* Macros
+*
+* CHECK - Reports a failed condition, with where it was, and fails the check
+*         it is in.
+******************************************************************************/
+#define CHECK(condition)                                                      \
+    do                                                                        \
+    {                                                                         \
+        if (!(condition))                                                     \
+        {                                                                     \
+            std::printf("%s:%d: check failed: %s\n", __FILE__, __LINE__,      \
+                        #condition);                                          \
+            return false;                                                     \
+        }                                                                     \
+    } while (0)
+
+/******************************************************************************
+* F2 B2 L' R2 D', which the two-phase search solves with six moves before it
+* finds the five-move solution.
+******************************************************************************/
+static const std::vector<int> test_scramble = {MOVE_F2, MOVE_B2, MOVE_LP,
+                                               MOVE_R2, MOVE_DP};
+
+/******************************************************************************
+* The path of the table file, as given on the command line.
+******************************************************************************/
+static const char* test_tables_path;
+
+/******************************************************************************
+* Function:  scrambled
+*
+* Purpose:   Makes the cube a scramble leads to.
+*
+* Params:    moves - The scramble.
+*
+* Returns:   The cube.
+*
+* Operation: Applies each move in turn to the solved cube.
+******************************************************************************/
+static Cube scrambled(const std::vector<int>& moves)
+{
+    Cube cube;
+    for (int move : moves)
+    {
+        cube.apply_move(move);
+    }
+    return cube;
+}
+
+/******************************************************************************
+* Function:  solves
+*
+* Purpose:   Checks that a solution solves a cube.
+*
+* Params:    cube  - The cube.
+*            moves - The solution.
+*
+* Returns:   true if the moves take the cube to the solved state.
+*
+* Operation: Applies each move in turn, then compares every coordinate, which
+*            between them fix the cube, with those of the solved cube.
+******************************************************************************/
+static bool solves(Cube cube, const std::vector<int>& moves)
+{
+    for (int move : moves)
+    {
+        cube.apply_move(move);
+    }
+    Cube solved;
+    return cube.coord_corner_orientation() ==
+                                       solved.coord_corner_orientation() &&
+           cube.coord_edge_orientation() == solved.coord_edge_orientation() &&
+           cube.coord_corner_permutation() ==
+                                       solved.coord_corner_permutation() &&
+           cube.coord_edge_permutation() == solved.coord_edge_permutation();
+}
+
+/******************************************************************************
+* Function:  test_solved
+*
+* Purpose:   Checks that the solved cube is solved with no moves.
+*
+* Params:    tables - The solver tables.
+*
+* Returns:   true if the check passed.
+*
+* Operation: Run first, so that a missing table cache is generated before
+*            the other checks run.
+******************************************************************************/
+static bool test_solved(const SolverTables& tables)
+{
+    CubeSolver solver(tables, Cube());
+    SolveResult result = solver.solve();
+    CHECK(result.length == 0);
+    CHECK(solver.lower_bound() == 0);
+    return true;
+}
+
+/******************************************************************************
+* Function:  test_target_length
+*
+* Purpose:   Checks that a solve with a target length equal to the length of
+*            the scramble stops at a solution of at most that length.
+*
+* Params:    tables - The solver tables.
+*
+* Returns:   true if the check passed.
+*
+* Operation: The search must go on past the six-move solution of
+*            test_scramble to meet the target.
+******************************************************************************/
+static bool test_target_length(const SolverTables& tables)
+{
+    static const std::vector<int> scrambles[] = {
+        test_scramble,
+        {MOVE_R, MOVE_U, MOVE_F},
+        {MOVE_U, MOVE_R2, MOVE_FP, MOVE_D, MOVE_L2, MOVE_B}};
+    for (const std::vector<int>& scramble : scrambles)
+    {
+        Cube cube = scrambled(scramble);
+        CubeSolver solver(tables, cube);
+        SolveOptions options;
+        options.target_length = scramble.size();
+        SolveResult result = solver.solve(options);
+        CHECK(result.length >= 0);
+        CHECK(result.length <= (int)scramble.size());
+        CHECK(solves(cube, result.moves));
+    }
+    return true;
+}
+
+/******************************************************************************
+* Function:  test_multi_axis
+*
+* Purpose:   Checks that a multi-axis solve finds the shortest solution,
+*            whether its orientations run on a pool or take turns.
+*
+* Params:    tables - The solver tables.
+*
+* Returns:   true if the check passed.
+*
+* Operation: Solves test_scramble with and without a pool, and a batch of
+*            it, whose workers each take the orientations in turn.
+******************************************************************************/
+static bool test_multi_axis(const SolverTables& tables)
+{
+    Cube cube = scrambled(test_scramble);
+    CubeThreadPool pool(SOLVE_ORIENTATIONS);
+    SolveOptions options;
+    options.multi_axis = true;
+    for (CubeThreadPool* use : {&pool, (CubeThreadPool*)nullptr})
+    {
+        options.pool = use;
+        CubeSolver solver(tables, cube);
+        SolveResult result = solver.solve(options);
+        CHECK(result.length == 5);
+        CHECK(solves(cube, result.moves));
+    }
+
+    options.pool = &pool;
+    std::vector<Cube> cubes(4, cube);
+    for (const SolveResult& result : cube_solve_batch(tables, cubes, options))
+    {
+        CHECK(result.length == 5);
+        CHECK(solves(cube, result.moves));
+    }
+    return true;
+}
+
+/******************************************************************************
+* Function:  test_replicas
+*
+* Purpose:   Checks that a batch given table replicas solves every cube.
+*
+* Params:    tables - The solver tables, whose file the replicas load.
+*
+* Returns:   true if the check passed.
+*
+* Operation: Sets up the replicas from the table file given to cubetest.
+*            Every replica must be on a node with processors, or on no node
+*            at all, so that the batch has workers to run on.
+******************************************************************************/
+static bool test_replicas(const SolverTables& tables)
+{
+    (void)tables;
+    CubeTableReplicas replicas;
+    replicas.init(test_tables_path);
+    CHECK(replicas.size() > 0);
+    for (int ii = 0; ii < replicas.size(); ++ii)
+    {
+        int node = replicas.node(ii);
+        CHECK(node < 0 || !cube_numa_cpus(node).empty());
+    }
+
+    Cube cube = scrambled(test_scramble);
+    std::vector<Cube> cubes(8, cube);
+    std::vector<SolveResult> results =
+                    cube_solve_batch(replicas, cubes.data(), cubes.size(),
+                                     SolveOptions());
+    for (const SolveResult& result : results)
+    {
+        CHECK(result.length == 5);
+        CHECK(solves(cube, result.moves));
+    }
+    return true;
+}
+
+/******************************************************************************
+* Function:  test_exhausted
+*
+* Purpose:   Checks that a session which has searched everything holds the
+*            shortest solution.
+*
+* Params:    tables - The solver tables.
+*
+* Returns:   true if the check passed.
+*
+* Operation: Improves a session for test_scramble a hundred nodes at a time
+*            until it is exhausted. The search finds a six-move solution
+*            before the five-move one, so must not stop at the six.
+******************************************************************************/
+static bool test_exhausted(const SolverTables& tables)
+{
+    Cube cube = scrambled(test_scramble);
+    CubeSolver solver(tables, cube);
+    solver.start();
+
+    SolveOptions budget;
+    budget.node_limit = 100;
+    for (int ii = 0; ii < 100000 && !solver.exhausted(); ++ii)
+    {
+        solver.improve(budget);
+    }
+    CHECK(solver.exhausted());
+    CHECK(solver.best().length == 5);
+    CHECK(solver.lower_bound() == 5);
+    CHECK(solves(cube, solver.best().moves));
+    return true;
+}
+
+/******************************************************************************
+* Function:  test_lower_bound
+*
+* Purpose:   Checks that an unbounded solve of a short scramble neither
+*            returns more moves than the scramble has nor claims a bound
+*            above that, directly or through the solution cache.
+*
+* Params:    tables - The solver tables.
+*
+* Returns:   true if the check passed.
+*
+* Operation: Solves test_scramble, and then a seeded set of random scrambles
+*            of up to seven moves, each turning a different face from the
+*            move before. Each cube is then solved through a cache twice,
+*            the second time from the entry stored by the first.
+******************************************************************************/
+static bool test_lower_bound(const SolverTables& tables)
+{
+    std::vector<std::vector<int>> scrambles = {test_scramble};
+    std::mt19937 rng(1);
+    for (int ii = 0; ii < 300; ++ii)
+    {
+        std::vector<int> scramble;
+        int last_face = -1;
+        for (int jj = 0; jj <= ii % 7; ++jj)
+        {
+            int move;
+            do
+            {
+                move = rng() % NUM_MOVES;
+            } while (move / 3 == last_face);
+            scramble.push_back(move);
+            last_face = move / 3;
+        }
+        scrambles.push_back(scramble);
+    }
+
+    CubeSolutionCache cache(1024);
+    for (const std::vector<int>& scramble : scrambles)
+    {
+        int length = scramble.size();
+        Cube cube = scrambled(scramble);
+        CubeSolver solver(tables, cube);
+        SolveResult result = solver.solve();
+        CHECK(result.length >= 0);
+        CHECK(result.length <= length);
+        CHECK(solver.lower_bound() == result.length);
+        CHECK(solves(cube, result.moves));
+
+        cache.solve(tables, cube);
+        CubeCachedSolution cached;
+        CHECK(cache.lookup(cube, cached));
+        CHECK(cached.bound <= length);
+        CHECK((int)cached.moves.size() == result.length);
+        CHECK(solves(cube, cache.solve(tables, cube).moves));
+    }
+    return true;
+}
+
+/******************************************************************************
+* Function:  test_load_session
+*
+* Purpose:   Checks that a damaged or forged saved session is rejected.
+*
+* Params:    tables - The solver tables.
+*
+* Returns:   true if the check passed.
+*
+* Operation: Saves a session for a ten-move scramble part way through its
+*            search, once it has found a solution. Every truncation of it
+*            is rejected, as are copies with the sign bit of the time set
+*            and with a bit of the best solution flipped, and one which
+*            claims a one-move best solution. The session itself still
+*            loads afterwards. The best solution starts at byte 37, after
+*            the magic number, version, coordinates, nodes, time, depth and
+*            length.
+******************************************************************************/
+static bool test_load_session(const SolverTables& tables)
+{
+    static const std::vector<int> scramble = {MOVE_R, MOVE_U, MOVE_F,
+                                              MOVE_L2, MOVE_D, MOVE_BP,
+                                              MOVE_U2, MOVE_RP, MOVE_F2,
+                                              MOVE_L};
+    const size_t length_byte = 36;
+    const size_t sign_byte = 34;
+
+    Cube cube = scrambled(scramble);
+    CubeSolver solver(tables, cube);
+    SolveOptions budget;
+    budget.node_limit = 2000;
+    for (int ii = 0; ii < 1000 && solver.best().length < 0; ++ii)
+    {
+        solver.improve(budget);
+    }
+    CHECK(solver.best().length > 1);
+    CHECK(!solver.exhausted());
+    std::vector<uint8_t> saved = solver.save_session();
+    CHECK(saved[length_byte] == solver.best().length);
+
+    CubeSolver loader(tables, cube);
+    for (size_t size = 0; size < saved.size(); ++size)
+    {
+        std::vector<uint8_t> truncated(saved.begin(), saved.begin() + size);
+        CHECK(!loader.load_session(truncated));
+    }
+
+    std::vector<uint8_t> flipped = saved;
+    flipped[sign_byte] ^= 0x80;
+    CHECK(!loader.load_session(flipped));
+    flipped = saved;
+    flipped[length_byte + 1] ^= 0x01;
+    CHECK(!loader.load_session(flipped));
+
+    std::vector<uint8_t> forged(saved.begin(),
+                                saved.begin() + length_byte);
+    forged.push_back(1);
+    forged.push_back(MOVE_U);
+    forged.insert(forged.end(),
+                  saved.begin() + length_byte + 1 + saved[length_byte],
+                  saved.end());
+    CHECK(!loader.load_session(forged));
+
+    CHECK(loader.load_session(saved));
+    CHECK(loader.best().length == solver.best().length);
+    CHECK(solves(cube, loader.best().moves));
+    return true;
+}
+
+/******************************************************************************
+* Function:  test_facelets
+*
+* Purpose:   Checks that facelet strings are read as the cubes they show,
+*            and that one no sequence of moves can produce is rejected.
+*
+* Params:    tables - The solver tables, which are not used.
+*
+* Returns:   true if the check passed.
+*
+* Operation: Compares the facelet strings of R and F with the cubes the same
+*            moves make, then twists one corner of the solved cube in place.
+******************************************************************************/
+static bool test_facelets(const SolverTables&)
+{
+    Cube expected;
+    Cube cube;
+    CHECK(Cube::from_moves("R", expected));
+    CHECK(Cube::from_facelets(
+              "UUFUUFUUFRRRRRRRRRFFDFFDFFDDDBDDBDDBLLLLLLLLLUBBUBBUBB", cube));
+    CHECK(cube == expected);
+
+    CHECK(Cube::from_moves("F", expected));
+    CHECK(Cube::from_facelets(
+              "UUUUUULLLURRURRURRFFFFFFFFFRRRDDDDDDLLDLLDLLDBBBBBBBBB", cube));
+    CHECK(cube == expected);
+
+    // The UFR corner turned clockwise on its own, and the string cut short.
+    CHECK(!Cube::from_facelets(
+              "UUUUUUUUFURRRRRRRRFFRFFFFFFDDDDDDDDDLLLLLLLLLBBBBBBBBB", cube));
+    CHECK(!Cube::from_facelets(
+              "UUUUUUUUURRRRRRRRRFFFFFFFFFDDDDDDDDDLLLLLLLLLBBBBBBBB", cube));
+    CHECK(cube == expected);
+    return true;
+}
+
+/******************************************************************************
+* Function:  test_moves
+*
+* Purpose:   Checks that malformed move text is rejected.
+*
+* Params:    tables - The solver tables, which are not used.
+*
+* Returns:   true if the check passed.
+*
+* Operation: Each string is one character away from a valid scramble. The
+*            cube must be left as it was by every failure.
+******************************************************************************/
+static bool test_moves(const SolverTables&)
+{
+    Cube cube;
+    CHECK(Cube::from_moves(" R  U2\tF' ", cube));
+    CHECK(cube == scrambled({MOVE_R, MOVE_U2, MOVE_FP}));
+
+    Cube expected = cube;
+    CHECK(!Cube::from_moves("R3", cube));
+    CHECK(!Cube::from_moves("RU", cube));
+    CHECK(!Cube::from_moves("R2'", cube));
+    CHECK(!Cube::from_moves("R X", cube));
+    CHECK(cube == expected);
+    return true;
+}
+
+/******************************************************************************
+* The checks, by name.
+******************************************************************************/
+struct TestCase
+{
+    const char* name;
+    bool (*run)(const SolverTables& tables);
+};
+
+static const TestCase test_cases[] = {
+    {"solved", test_solved},
+    {"target_length", test_target_length},
+    {"multi_axis", test_multi_axis},
+    {"replicas", test_replicas},
+    {"exhausted", test_exhausted},
+    {"lower_bound", test_lower_bound},
+    {"load_session", test_load_session},
+    {"facelets", test_facelets},
+    {"moves", test_moves},
+};
+
+/******************************************************************************
+* Function:  main
+*
+* Purpose:   Runs the checks.
+*
+* Params:    argc - The number of arguments.
+*            argv - The path of the table cache, and then optionally the name
+*                   of the one check to run.
+*
+* Returns:   0 if every check run passed, or 1 otherwise.
+*
+* Operation: Loads the tables, generating them first if the cache does not
+*            hold them, then runs each check, reporting its outcome.
+******************************************************************************/
+int main(int argc, char** argv)
+{
+    if (argc < 2 || argc > 3)
+    {
+        std::printf("usage: cubetest TABLES [CHECK]\n");
+        return 1;
+    }
+
+    SolverTables tables;
+    tables.init(argv[1]);
+    test_tables_path = argv[1];
+
+    int failures = 0;
+    int run = 0;
+    for (const TestCase& test : test_cases)
+    {
+        if (argc == 3 && std::strcmp(argv[2], test.name) != 0)
+        {
+            continue;
+        }
+        bool passed = test.run(tables);
+        std::printf("%s: %s\n", test.name, passed ? "passed" : "FAILED");
+        failures += passed ? 0 : 1;
+        ++run;
+    }
+
+    if (run == 0)
+    {
+        std::printf("no such check: %s\n", argv[2]);
+        return 1;
+    }
+    return (failures == 0) ? 0 : 1;
+}